@@ -0,0 +1,34 @@
+#pragma once
+
+#include "nuke/types.hpp"
+#include "nuke/core/config.hpp"
+#include "nuke/core/checkpoint.hpp"
+#include <string>
+#include <vector>
+
+namespace nuke {
+
+// ============================================================================
+// Candidate List (--from-list: targets named by an index instead of a walk)
+// ============================================================================
+// Reads the paths of a `find -print0` / `locate -0` listing (NUL or newline
+// separated), or the directory records of an mlocate database, and keeps
+// the directories named like a configured target. What is left of a scan is
+// sizing them, which the plan hands to Scanner::resume as pending targets;
+// the sizer drops the ones that are gone since the index was built.
+struct CandidateList {
+    std::vector<fs::path> targets;  // Absolute, sorted, none inside another
+    std::size_t entries = 0;        // Paths read from the source
+    std::string format;             // What the source turned out to be
+
+    // From a file, or stdin for "-" (an mlocate database only from a file)
+    static bool read(const std::string& source, const Config& config, CandidateList& out);
+
+    // The deepest directory holding every target
+    fs::path common_root() const;
+    // The targets within `roots` as a scan to resume; ignored folders
+    // between a root and a target exclude it, as they would the walk
+    ScanCheckpoint plan(const std::vector<fs::path>& roots, const Config& config) const;
+};
+
+} // namespace nuke
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "nuke/types.hpp"
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace nuke {
+
+// ============================================================================
+// Scan Checkpoint (unexplored frontier of an interrupted scan)
+// ============================================================================
+// Written when a scan runs out of --time-budget or is interrupted, and read
+// back by --resume. Targets found so far travel with it so the resumed run
+// reports the whole picture.
+struct ScanCheckpoint {
+    enum class Kind : std::uint8_t {
+        Directory,  // Not read yet
+        Target      // Found but not sized yet
+    };
+
+    struct Pending {
+        Kind kind = Kind::Directory;
+        int depth = 0;
+        fs::path path;
+    };
+
+    std::vector<fs::path> roots;
+    int max_depth = -1;
+    std::vector<Pending> pending;
+    std::vector<TargetEntry> found;
+
+    bool empty() const { return pending.empty(); }
+
+    bool load(const fs::path& path);
+    bool save(const fs::path& path) const;
+    // Unknown keys are skipped, so other files can embed a checkpoint
+    bool read(std::istream& in);
+    bool write(std::ostream& out) const;
+};
+
+// Path fields as written in checkpoint lines (UTF-8, "\\" and "\n" escaped)
+std::string escape_path(const fs::path& path);
+fs::path unescape_path(const std::string& text);
+
+} // namespace nuke
@@ -0,0 +1,157 @@
+#pragma once
+
+#include "nuke/types.hpp"
+#include "nuke/core/config.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace nuke {
+
+// ============================================================================
+// Device Kind (decides where the concurrency controller starts)
+// ============================================================================
+enum class DeviceKind : std::uint8_t {
+    Rotational,  // Seeks dominate; few requests in flight
+    SolidState,  // SSD / NVMe; roughly one per CPU to start
+    Network,     // NFS / SMB / FUSE; latency bound, wants many in flight
+    Unknown
+};
+
+inline const char* device_kind_to_string(DeviceKind kind) {
+    switch (kind) {
+        case DeviceKind::Rotational: return "rotational";
+        case DeviceKind::SolidState: return "ssd";
+        case DeviceKind::Network: return "network";
+        case DeviceKind::Unknown: return "unknown";
+    }
+    return "unknown";
+}
+
+// ============================================================================
+// Concurrency Controller (per-device AIMD on per-operation latency)
+// ============================================================================
+// Shared by Scanner and Destroyer so what one learns about a device carries
+// over to the other within a run. Each device starts from a seed picked by
+// its kind and the CPU quota, then every window of completions either adds
+// one slot (latency still near the best seen and throughput not falling) or
+// cuts the limit by a quarter (latency has doubled: requests are queueing).
+// A positive `scan_threads` in the config pins every device to that value.
+class ConcurrencyController {
+public:
+    struct DeviceInfo {
+        DeviceKind kind = DeviceKind::Unknown;
+        int initial = 1;
+        int min = 1;
+        int max = 1;
+    };
+
+    static ConcurrencyController& instance();
+
+    void configure(const Config& config);
+
+    // st_dev on POSIX, the volume on Windows
+    static std::uint64_t device_of(const fs::path& path);
+    // CPUs granted by the cgroup v2 cpu.max quota, else hardware_concurrency
+    static unsigned int cpu_quota();
+    static DeviceKind device_kind(const fs::path& path, std::uint64_t device);
+
+    // Registers the device on first use (logged at --verbosity diag)
+    int limit(std::uint64_t device, const fs::path& sample);
+    int limit(std::uint64_t device) const;
+    // Upper bound over every device seen so far
+    int max_limit() const;
+
+    // Reports `ops` filesystem operations finished in `elapsed` by one task
+    // that ran with `in_flight` tasks active on the device.
+    void complete(std::uint64_t device, std::size_t ops, std::chrono::nanoseconds elapsed,
+                  int in_flight);
+
+    // A pool starts or stops working on a registered device. The first pool
+    // on an idle device starts a new phase there, forgetting the latency
+    // baseline but keeping the limit: an unlink costs more than a stat, so
+    // deletion must not be judged against the scan's best. A device another
+    // pool is still tuning keeps its baseline.
+    void enter(std::uint64_t device);
+    void leave(std::uint64_t device);
+
+    // One diag line per device with the limit it settled on
+    void log_summary() const;
+
+private:
+    ConcurrencyController() = default;
+
+    struct Device {
+        DeviceInfo info;
+        int limit = 1;
+        double baseline_ns = 0;  // Best per-op latency seen, drifts up slowly
+        double previous_rate = 0;
+        int pools = 0;           // Pools working on the device
+        // Current window
+        std::size_t ops = 0;
+        std::size_t completions = 0;
+        double busy_ns = 0;
+        bool saturated = false;  // Some task ran with every slot taken
+        std::chrono::steady_clock::time_point window_start;
+    };
+
+    DeviceInfo seed(DeviceKind kind, unsigned int cpus) const;
+    void adjust(std::uint64_t device, Device& state);
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::uint64_t, Device> devices_;
+    int pinned_ = 0;
+};
+
+// ============================================================================
+// Task Pool (worker threads gated by the controller's per-device limits)
+// ============================================================================
+// Workers take the oldest task whose device still has a free slot, so a slow
+// device never holds up work queued for another. Threads are started only as
+// the limits call for them. A task returns the number of filesystem
+// operations it issued, which is what the controller learns from.
+class TaskPool {
+public:
+    using Task = std::function<std::size_t()>;
+
+    explicit TaskPool(ConcurrencyController& controller = ConcurrencyController::instance());
+    ~TaskPool();
+
+    TaskPool(const TaskPool&) = delete;
+    TaskPool& operator=(const TaskPool&) = delete;
+
+    // Blocks while too much work is already queued
+    void submit(const fs::path& path, Task task);
+    void submit(std::uint64_t device, const fs::path& path, Task task);
+    // Returns once every submitted task has finished
+    void wait();
+
+private:
+    struct Entry {
+        std::uint64_t device = 0;
+        Task task;
+    };
+
+    void worker_loop();
+    bool take(Entry& entry);
+    void maybe_spawn();
+
+    ConcurrencyController& controller_;
+    std::mutex mutex_;
+    std::condition_variable work_cv_;
+    std::condition_variable done_cv_;
+    std::deque<Entry> queue_;
+    std::unordered_map<std::uint64_t, int> in_flight_;
+    std::vector<std::uint64_t> entered_;  // Devices this pool works on
+    std::vector<std::thread> workers_;
+    std::size_t running_ = 0;
+    bool stopping_ = false;
+};
+
+} // namespace nuke
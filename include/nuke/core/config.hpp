@@ -4,10 +4,29 @@
 #include <string>
 #include <vector>
 #include <filesystem>
+#include <map>
 #include <optional>
 
 namespace nuke {
 
+// A cache budget for `nuke enforce`: the targets it covers may take at most
+// max_size, and the least recently used go first when they take more
+struct QuotaPolicy {
+    std::string project_type;  // "rust", "node", ...; empty covers every type
+    std::string root;          // Only targets below it ("~/" expands); empty for all
+    std::string max_size;      // "200GB", as parse_bytes reads it
+};
+
+// A filesystem `nuke guard` keeps free space on: when what is available
+// drops below `low`, targets below `roots` are deleted until it is back at
+// `high`
+struct GuardPolicy {
+    std::string mount;               // Any path on the watched filesystem
+    std::string low;                 // "10%" of the capacity, or "20GB"
+    std::string high;
+    std::vector<std::string> roots;  // Where candidates are found; empty: the mount
+};
+
 class Config {
 public:
     Config();
@@ -18,6 +37,18 @@ public:
     
     const std::vector<std::string>& targets() const { return targets_; }
     const std::vector<std::string>& ignore() const { return ignore_; }
+    const std::vector<std::string>& skip_filesystems() const { return skip_filesystems_; }
+    // Extra directories nothing may be deleted from ("~/" is the home directory)
+    const std::vector<std::string>& protected_paths() const { return protected_paths_; }
+    const std::vector<QuotaPolicy>& quotas() const { return quotas_; }
+    const std::vector<GuardPolicy>& guards() const { return guards_; }
+    // Files whose mtime says when a target was last built or installed, per
+    // target folder name; relative to the target ("../Cargo.lock" is beside it)
+    const std::map<std::string, std::vector<std::string>>& staleness_markers() const {
+        return staleness_markers_;
+    }
+    // Levels below a target read for its newest mtime when it has no marker
+    int staleness_depth() const { return staleness_depth_; }
     Strategy strategy() const { return strategy_; }
     int scan_threads() const { return scan_threads_; }
     
@@ -25,20 +56,41 @@ public:
     void set_scan_threads(int n) { scan_threads_ = n; }
     void add_target(const std::string& target) { targets_.push_back(target); }
     void add_ignore(const std::string& pattern) { ignore_.push_back(pattern); }
+    void add_protected_path(const std::string& path) { protected_paths_.push_back(path); }
+    void add_quota(const QuotaPolicy& quota) { quotas_.push_back(quota); }
+    void add_guard(const GuardPolicy& guard) { guards_.push_back(guard); }
+    void set_staleness_markers(const std::string& target, std::vector<std::string> markers) {
+        staleness_markers_[target] = std::move(markers);
+    }
+    void set_staleness_depth(int depth) { staleness_depth_ = depth; }
     
     bool is_target(const std::string& name) const;
     bool is_ignored(const std::string& name) const;
+    // Filesystem types never entered below a root ("fuse.*" matches any FUSE type)
+    bool is_skipped_filesystem(const std::string& fs_type) const;
+    // Hash of everything that decides what a scan finds: targets, ignore
+    // list, skipped filesystems, protected paths and staleness markers. A
+    // scan server only answers clients whose config hashes the same.
+    std::uint64_t scan_fingerprint() const;
     
     static fs::path get_default_config_path();
     static fs::path get_stats_path();
+    static fs::path get_checkpoint_path();
+    static fs::path get_cost_model_path();
 
 private:
     void set_defaults();
     
     std::vector<std::string> targets_;
     std::vector<std::string> ignore_;
+    std::vector<std::string> skip_filesystems_;
+    std::vector<std::string> protected_paths_;
+    std::vector<QuotaPolicy> quotas_;
+    std::vector<GuardPolicy> guards_;
+    std::map<std::string, std::vector<std::string>> staleness_markers_;
+    int staleness_depth_ = 2;
     Strategy strategy_ = Strategy::OsFast;
-    int scan_threads_ = 8;
+    int scan_threads_ = 0;  // 0 = adaptive per device
 };
 
 } // namespace nuke
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "nuke/types.hpp"
+#include "nuke/core/mount_table.hpp"
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace nuke {
+
+// ============================================================================
+// Deletion Forecast
+// ============================================================================
+struct DeletionForecast {
+    std::chrono::milliseconds total{0};               // Devices work side by side
+    std::vector<std::chrono::milliseconds> targets;   // Same order as the input
+    std::size_t operations = 0;                       // Unlinks plus rmdirs
+    bool calibrated = true;  // False when some device has no measured rate yet
+};
+
+// ============================================================================
+// Cost Model (unlinks per second, per device, kept between runs)
+// ============================================================================
+// Deleting costs one unlink per file and one rmdir per directory whatever the
+// bytes, so a target's cost is its entry count over its device's rate. A
+// device never measured starts from a guess for its kind; every deletion
+// long enough to time well moves the rate towards what was observed.
+// Devices are named by filesystem and source ("ext4 /dev/nvme0n1p2") or by
+// drive, which unlike st_dev stay the same across reboots.
+class CostModel {
+public:
+    bool load();
+    bool save() const;
+
+    DeletionForecast predict(const std::vector<TargetEntry>& targets);
+    // Folds a finished deletion into the rates. Returns false when it was
+    // too short to learn from.
+    bool observe(const DeletionResult& result);
+
+    static std::size_t operations(const TargetEntry& target) {
+        return target.file_count + target.dir_count + 1;
+    }
+
+private:
+    struct Rate {
+        double ops_per_second = 0;
+        std::size_t runs = 0;  // Deletions folded in; 0 means a guess
+    };
+
+    std::string device_key(std::uint64_t device, const fs::path& sample);
+    Rate& rate_for(std::uint64_t device, const fs::path& sample);
+
+    std::unordered_map<std::string, Rate> rates_;
+    std::unordered_map<std::uint64_t, std::string> keys_;  // st_dev -> key, this run
+    MountTable mounts_;
+    bool mounts_loaded_ = false;
+};
+
+} // namespace nuke
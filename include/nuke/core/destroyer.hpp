@@ -3,6 +3,7 @@
 #include "nuke/types.hpp"
 #include "nuke/core/config.hpp"
 #include <functional>
+#include <mutex>
 
 namespace nuke {
 
@@ -14,14 +15,20 @@ public:
     explicit Destroyer(const Config& config);
     
     bool destroy(const fs::path& path);
+    // Deletes each target only if it is still the directory that was
+    // scanned (same device and inode, not replaced by a symlink).
     DeletionResult destroy_all(const std::vector<TargetEntry>& targets);
     
     void set_progress_callback(ProgressCallback cb) { progress_cb_ = std::move(cb); }
     void set_error_callback(ErrorCallback cb) { error_cb_ = std::move(cb); }
+    void set_progress_counters(ProgressCounters* counters) { counters_ = counters; }
     
     static fs::path get_void_path();
 
+    enum class Outcome { Deleted, Failed, Skipped };
+
 private:
+    Outcome destroy_target(const TargetEntry& target, std::string& reason);
     bool destroy_native(const fs::path& path);
     bool destroy_fast(const fs::path& path);
     bool destroy_robocopy(const fs::path& path);
@@ -30,7 +37,10 @@ private:
     const Config& config_;
     ProgressCallback progress_cb_;
     ErrorCallback error_cb_;
+    ProgressCounters* counters_ = nullptr;
     fs::path void_path_;
+    std::mutex void_mutex_;
+    bool void_ready_ = false;
 };
 
 } // namespace nuke
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "nuke/types.hpp"
+#include "nuke/core/config.hpp"
+#include "nuke/core/cost_model.hpp"
+#include "nuke/utils/safety.hpp"
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace nuke {
+
+class Scanner;
+
+// Free space as a share of the capacity ("10%") or in bytes ("20GB")
+struct Watermark {
+    double percent = 0;
+    std::uintmax_t bytes = 0;
+
+    static std::optional<Watermark> parse(const std::string& text);
+    std::uintmax_t resolve(std::uintmax_t capacity) const;
+};
+
+struct GuardOptions {
+    std::chrono::milliseconds interval{2000};   // Between free-space checks
+    std::chrono::milliseconds refresh{600000};  // Between candidate scans
+    bool dry_run = false;                       // Log what would go, delete nothing
+};
+
+// ============================================================================
+// Disk Guard (nuke guard)
+// ============================================================================
+// Two loops. The refresher scans every watch's roots in one pass and keeps,
+// per watched filesystem, the targets on it ordered oldest first (largest
+// first among those last used the same day). The poller checks free space
+// with one statvfs per watch; below the low watermark it deletes from the
+// front of that list until the high watermark is back, so reacting costs a
+// few deletions, not a scan. A target already deleted or changed since the
+// scan is skipped by the Destroyer's identity check.
+class DiskGuard {
+public:
+    DiskGuard(const Config& config, GuardOptions options);
+    ~DiskGuard();
+
+    DiskGuard(const DiskGuard&) = delete;
+    DiskGuard& operator=(const DiskGuard&) = delete;
+
+    // Resolves the config's guard entries; false with `error` naming the
+    // first bad one
+    bool configure(std::string& error);
+
+    // Polls and reclaims until stop(), rescanning in the background
+    void run();
+    // One scan, then one check of every watch (for cron and tests)
+    void run_once();
+    // Safe to call from another thread or a signal handler
+    void stop();
+
+    std::size_t watch_count() const { return watches_.size(); }
+
+private:
+    struct Watch {
+        std::string label;           // The mount as configured
+        fs::path mount;
+        std::vector<fs::path> roots;
+        Watermark low;
+        Watermark high;
+        std::uint64_t device = 0;    // 0 when not known
+        std::vector<TargetEntry> candidates;  // Next to delete at the back
+        bool pressed = false;        // Between crossing low and reaching high
+        // Set once per pressure episode: with nothing left to delete, one
+        // rescan is asked for, then the guard waits for the scheduled ones
+        std::size_t rescan_after = 0;  // refreshes_ the asked-for rescan ends at
+        bool exhausted = false;        // That rescan found nothing either
+    };
+
+    void refresh();
+    void poll();
+    void reclaim(Watch& watch, std::uintmax_t available, std::uintmax_t goal);
+    // False once stopped; returns early when a rescan is asked for
+    bool sleep_for(std::chrono::milliseconds duration);
+    void cancel_scan();
+
+    const Config& config_;
+    GuardOptions options_;
+    Safety safety_;
+    CostModel cost_model_;
+    std::vector<Watch> watches_;
+
+    // Guards the candidate lists and deleted_ (the refresher swaps new lists in)
+    std::mutex mutex_;
+    // Deleted since the running refresh started; dropped from its lists
+    std::vector<fs::path> deleted_;
+    bool refreshed_ = false;
+    std::size_t refreshes_ = 0;
+
+    std::atomic<bool> stopping_{false};
+    std::atomic<bool> refresh_now_{false};
+    std::mutex scanner_mutex_;
+    Scanner* scanner_ = nullptr;  // The refresh scan running, if any
+};
+
+} // namespace nuke
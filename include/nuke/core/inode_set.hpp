@@ -0,0 +1,67 @@
+#pragma once
+
+#include "nuke/types.hpp"
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace nuke {
+
+// ============================================================================
+// Inode Set (open addressing, 16 bytes per slot)
+// ============================================================================
+// Remembers directories already entered, so a bind mount or a symlink back
+// up the tree is not walked twice. A million directories fit in 32 MB.
+class InodeSet {
+public:
+    // False when the id was already present (or is not known)
+    bool insert(const FileId& id);
+    bool contains(const FileId& id) const;
+
+    std::size_t size() const { return size_; }
+    void clear();
+
+private:
+    void grow();
+
+    std::vector<FileId> slots_;  // Empty slots have ino == 0
+    std::size_t size_ = 0;
+};
+
+// ============================================================================
+// Link Tracker (hardlinked files across targets; thread-safe)
+// ============================================================================
+// Sizing workers report each file with more links than they found inside
+// the target being sized. A file whose links all turn up across the targets
+// is freed once every target is deleted, though no single target frees it.
+// Striped by hash, so concurrent workers rarely share a lock; 32 bytes per
+// file.
+class LinkTracker {
+public:
+    struct Totals {
+        std::uintmax_t covered = 0;    // Every link lies inside the targets
+        std::uintmax_t uncovered = 0;  // Some link lies elsewhere; never freed
+    };
+
+    void add(const FileId& id, std::uint32_t links, std::uint32_t seen, std::uintmax_t bytes);
+    // Each file counted once, however many targets it was reported by
+    Totals totals() const;
+
+private:
+    struct Entry {
+        FileId id;
+        std::uint32_t links = 0;
+        std::uint32_t seen = 0;
+        std::uint64_t bytes = 0;
+    };
+    struct Stripe {
+        mutable std::mutex mutex;
+        std::vector<Entry> slots;
+        std::size_t size = 0;
+    };
+    static constexpr std::size_t STRIPES = 64;
+
+    Stripe stripes_[STRIPES];
+};
+
+} // namespace nuke
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "nuke/types.hpp"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace nuke {
+
+// ============================================================================
+// Mount Table (a snapshot of /proc/self/mountinfo)
+// ============================================================================
+// Read once per scan, so deciding whether a directory is a mount point, and
+// of which filesystem, is a lookup rather than a syscall. Empty on Windows
+// and wherever mountinfo cannot be read; every lookup then misses.
+struct MountInfo {
+    std::uint64_t dev = 0;  // Same encoding as st_dev
+    fs::path mount_point;
+    fs::path fs_root;       // Directory of the filesystem mounted here (bind mounts)
+    std::string fs_type;    // "ext4", "nfs4", "fuse.sshfs", ...
+    std::string source;
+};
+
+class MountTable {
+public:
+    static MountTable load();
+    // Parses mountinfo text; exposed for reading a saved copy
+    static MountTable parse(std::istream& in);
+
+    // The mount at exactly this path (the topmost one if stacked)
+    const MountInfo* find(const fs::path& mount_point) const;
+    // The mount holding this path (longest mount point prefix)
+    const MountInfo* containing(const fs::path& path) const;
+
+    const std::vector<MountInfo>& mounts() const { return mounts_; }
+    bool empty() const { return mounts_.empty(); }
+
+private:
+    std::vector<MountInfo> mounts_;
+    std::unordered_map<fs::path::string_type, std::size_t> by_path_;
+};
+
+} // namespace nuke
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "nuke/types.hpp"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace nuke {
+
+// ============================================================================
+// Server Protocol (nuke serve <-> nuke clients over a Unix domain socket)
+// ============================================================================
+// Every message is a frame: u32 payload length, u8 message type, payload.
+// Integers are little-endian, strings and paths a u32 length and UTF-8
+// bytes. A client sends one request frame (which starts with VERSION), then
+// reads frames until a summary or an error:
+//
+//   Handshake     -> Handshake
+//   ScanRequest   -> Target* ScanSummary
+//   DeleteRequest -> DeletionSummary
+//   (any)         -> Error
+//
+// A Handshake carries Config::scan_fingerprint(), the client's and then the
+// server's; a client whose config differs scans locally instead, and the
+// server refuses a ScanRequest made with another config.
+namespace protocol {
+
+constexpr std::uint16_t VERSION = 3;
+constexpr std::uint32_t MAX_FRAME = 64u << 20;
+
+enum class MessageType : std::uint8_t {
+    ScanRequest = 1,
+    DeleteRequest = 2,
+    Handshake = 3,
+    Target = 16,
+    ScanSummary = 17,
+    DeletionSummary = 18,
+    Error = 19
+};
+
+class Writer {
+public:
+    void u8(std::uint8_t value) { data_.push_back(static_cast<char>(value)); }
+    void u16(std::uint16_t value);
+    void u32(std::uint32_t value);
+    void u64(std::uint64_t value);
+    void i64(std::int64_t value) { u64(static_cast<std::uint64_t>(value)); }
+    void str(std::string_view value);
+    void path(const fs::path& value);
+
+    const std::string& data() const { return data_; }
+
+private:
+    std::string data_;
+};
+
+// Reads stop at the first short field; ok() then stays false
+class Reader {
+public:
+    explicit Reader(std::string_view data) : data_(data) {}
+
+    std::uint8_t u8();
+    std::uint16_t u16();
+    std::uint32_t u32();
+    std::uint64_t u64();
+    std::int64_t i64() { return static_cast<std::int64_t>(u64()); }
+    std::string str();
+    fs::path path();
+
+    bool ok() const { return ok_; }
+    bool done() const { return ok_ && pos_ == data_.size(); }
+
+private:
+    bool take(std::size_t n);
+
+    std::string_view data_;
+    std::size_t pos_ = 0;
+    bool ok_ = true;
+};
+
+// Frames can be batched into one buffer and sent with a single write_all
+void append_frame(std::string& out, MessageType type, const std::string& payload);
+
+// Blocking I/O on a connected socket; false on EOF, error or a frame over
+// MAX_FRAME
+bool write_all(int fd, const std::string& data);
+bool write_frame(int fd, MessageType type, const std::string& payload);
+bool read_frame(int fd, MessageType& type, std::string& payload);
+
+} // namespace protocol
+
+// ============================================================================
+// Requests and Replies
+// ============================================================================
+struct ScanRequest {
+    std::vector<fs::path> roots;  // Absolute and without overlap
+    std::int32_t max_depth = -1;
+    bool one_file_system = false;
+    bool estimate = false;
+    bool fresh = false;           // Ignore a cached result (still shares a running walk)
+    std::uint64_t config = 0;     // Config::scan_fingerprint() of the client
+    std::uint64_t min_bytes = 0;
+    std::uint64_t max_bytes = UINT64_MAX;
+    std::uint64_t top = 0;
+    std::uint32_t older_than_hours = 0;
+
+    // Everything that shapes the result; equal keys share one walk
+    std::string key() const;
+
+    void encode(protocol::Writer& out) const;
+    bool decode(protocol::Reader& in);
+};
+
+struct ScanReply {
+    ScanResult result;      // targets filled, store empty
+    bool cached = false;    // Served from the server's inventory
+    bool shared = false;    // Joined a walk another client started
+};
+
+void encode_target(protocol::Writer& out, const TargetEntry& target);
+bool decode_target(protocol::Reader& in, TargetEntry& target);
+void encode_scan_summary(protocol::Writer& out, const ScanResult& result, bool cached, bool shared);
+bool decode_scan_summary(protocol::Reader& in, ScanReply& reply);
+void encode_deletion(protocol::Writer& out, const DeletionResult& result);
+bool decode_deletion(protocol::Reader& in, DeletionResult& result);
+
+} // namespace nuke
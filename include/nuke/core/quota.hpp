@@ -0,0 +1,53 @@
+#pragma once
+
+#include "nuke/types.hpp"
+#include "nuke/core/config.hpp"
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace nuke {
+
+// ============================================================================
+// Quota Plan (nuke enforce)
+// ============================================================================
+// A config policy, checked and resolved: which targets it covers and how
+// many bytes they may take
+struct QuotaBudget {
+    std::string label;                        // "rust under ~/src", "all types"
+    std::optional<ProjectType> type;          // Every type when empty
+    fs::path root;                            // Canonical; everywhere when empty
+    std::uintmax_t max_bytes = 0;
+
+    bool covers(const TargetEntry& target) const;
+    // Parses and resolves every policy; false with `error` naming the first bad one
+    static bool from_config(const std::vector<QuotaPolicy>& policies, std::vector<QuotaBudget>& out,
+                            std::string& error);
+};
+
+struct QuotaUsage {
+    const QuotaBudget* budget = nullptr;
+    std::size_t targets = 0;            // Covered by the budget
+    std::uintmax_t used_bytes = 0;      // Before eviction
+    std::uintmax_t evicted_bytes = 0;   // Covered targets in the eviction set
+    std::size_t evicted = 0;
+
+    std::uintmax_t kept_bytes() const { return used_bytes - evicted_bytes; }
+    bool over() const { return used_bytes > budget->max_bytes; }
+};
+
+struct QuotaPlan {
+    std::vector<QuotaUsage> usage;      // One per budget, in config order
+    std::vector<TargetEntry> evict;     // Least recently used first
+    std::uintmax_t evict_bytes = 0;
+};
+
+// Budgets are settled in order. Each evicts its own least recently used
+// targets (by TargetEntry::recency, larger first on ties) until what it
+// covers fits; a target already evicted by an earlier budget counts as gone
+// for the later ones, so every budget ends within its limit and the set is
+// the shortest LRU prefix that does it. O(budgets x targets) after one sort.
+QuotaPlan plan_evictions(const std::vector<QuotaBudget>& budgets,
+                         const std::vector<TargetEntry>& targets);
+
+} // namespace nuke
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "nuke/types.hpp"
+#include <string>
+#include <vector>
+
+namespace nuke {
+
+// ============================================================================
+// Root Set (several scan roots, canonicalized and without overlap)
+// ============================================================================
+// Roots from repeated --root and --roots-from are canonicalized, then a root
+// is dropped when it names the same directory as an earlier one (compared by
+// device and inode, so bind mounts are caught) or lies inside another root.
+struct RootSet {
+    struct Dropped {
+        std::string input;
+        std::string reason;
+        bool missing = false;  // Does not exist or is not a directory
+    };
+
+    std::vector<fs::path> roots;  // In the order first given
+    std::vector<Dropped> dropped;
+
+    // One root per line from a file, or stdin for "-". Blank lines and
+    // lines starting with '#' are skipped.
+    static bool read_manifest(const std::string& source, std::vector<std::string>& out);
+    static RootSet plan(const std::vector<std::string>& inputs);
+};
+
+} // namespace nuke
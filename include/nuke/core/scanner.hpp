@@ -2,35 +2,186 @@
 
 #include "nuke/types.hpp"
 #include "nuke/core/config.hpp"
+#include "nuke/core/target_store.hpp"
+#include "nuke/core/checkpoint.hpp"
+#include "nuke/core/concurrency.hpp"
+#include "nuke/core/inode_set.hpp"
+#include "nuke/core/mount_table.hpp"
+#include "nuke/core/staleness.hpp"
+#include <atomic>
 #include <functional>
+#include <mutex>
 #include <optional>
+#include <queue>
+#include <unordered_map>
 #include <chrono>
 
 namespace nuke {
 
+struct DirectoryStats {
+    std::uintmax_t bytes = 0;
+    std::size_t files = 0;
+    std::size_t dirs = 0;
+    bool exceeded = false;  // Walk stopped early once bytes passed the limit
+    std::uintmax_t bytes_error = 0;  // ~95% bound when bytes is an estimate
+    std::uintmax_t shared_bytes = 0; // Part of bytes hardlinked from outside the tree
+    // Newest atime or mtime of the files stat'ed (only the sampled ones for
+    // an estimate); directories are left out, since reading them for the
+    // walk is what moves their atime
+    std::chrono::system_clock::time_point newest{};
+};
+
 class Scanner {
 public:
     using ProgressCallback = std::function<void(const fs::path& current_path, std::size_t found_count)>;
+    using TargetCallback = std::function<void(const TargetEntry& target)>;
     
     explicit Scanner(const Config& config);
     
     ScanResult scan(const fs::path& root, int max_depth = -1);
+    // Several roots in one pass, sharing the frontier and the sizing pool,
+    // with a subtotal per root. Roots must not overlap (see RootSet).
+    ScanResult scan(const std::vector<fs::path>& roots, int max_depth = -1);
+    // Continues an interrupted scan from its checkpoint. Pending targets
+    // (as from a shard or a --from-list plan) that are gone or are not
+    // directories are dropped when sized.
+    ScanResult resume(const ScanCheckpoint& checkpoint);
     
     void set_older_than(std::chrono::hours age) { older_than_ = age; }
     void set_progress_callback(ProgressCallback cb) { progress_cb_ = std::move(cb); }
+    void set_progress_counters(ProgressCounters* counters) { counters_ = counters; }
+    
+    // Called once per target as soon as it is sized (for streaming output).
+    void set_target_callback(TargetCallback cb) { target_cb_ = std::move(cb); }
+    // When false, targets are only reported through the callback and the
+    // result carries totals without any rows.
+    void set_retain_targets(bool retain) { retain_targets_ = retain; }
+    // When false, ScanResult::targets stays empty and callers read the compact
+    // ScanResult::store instead of one TargetEntry allocation per target.
+    void set_materialize_targets(bool materialize) { materialize_targets_ = materialize; }
+    // Keep only targets within [min_bytes, max_bytes]. A size walk stops as
+    // soon as it passes max_bytes.
+    void set_size_range(std::uintmax_t min_bytes, std::uintmax_t max_bytes) {
+        min_bytes_ = min_bytes;
+        max_bytes_ = max_bytes;
+    }
+    // Keep only the n largest targets (0 keeps all) in a bounded heap. The
+    // target callback then fires once per survivor, largest first, at the end.
+    void set_top(std::size_t n) { top_n_ = n; }
+    // Size targets with estimate_directory instead of a full walk.
+    void set_estimate(bool estimate) { estimate_ = estimate; }
+    // When false, targets are reported unsized (size 0) so the caller can
+    // size them lazily with measure_directory.
+    void set_size_targets(bool size) { size_targets_ = size; }
+    
+    // Do not cross into other filesystems below the roots (like find -xdev).
+    // Independently of this, mounts of the config's skip_filesystems types
+    // are never entered, and no directory is walked twice (bind mounts,
+    // symlinks back up the tree).
+    void set_one_file_system(bool one) { one_file_system_ = one; }
+    
+    // Stop once this much time has passed and return the best result so far.
+    void set_time_budget(std::chrono::milliseconds budget) { time_budget_ = budget; }
     
-    static std::uintmax_t get_directory_size(const fs::path& path);
-    static std::string detect_project_type(const std::string& folder_name);
+    // Safe to call from another thread (or a signal handler); scan() returns
+    // what it found so far and checkpoint() holds the rest.
+    void cancel() { cancelled_.store(true, std::memory_order_relaxed); }
+    // Unexplored frontier of the last scan; empty when it completed.
+    const ScanCheckpoint& checkpoint() const { return checkpoint_; }
+    
+    static std::uintmax_t get_directory_size(const fs::path& path,
+                                             ProgressCounters* counters = nullptr);
+    // Bytes allocated on disk, so sparse files count what they occupy and a
+    // hardlinked file counts once. Files with links outside the tree are
+    // also in shared_bytes, and reported to `links` when given.
+    static DirectoryStats measure_directory(const fs::path& path,
+                                            ProgressCounters* counters = nullptr,
+                                            const std::atomic<bool>* cancel = nullptr,
+                                            std::uintmax_t stop_above = UINTMAX_MAX,
+                                            LinkTracker* links = nullptr);
+    // Reads a random sample of the subtree's directories and stats a sample
+    // of the files in each, then extrapolates. Small trees come out exact.
+    static DirectoryStats estimate_directory(const fs::path& path,
+                                             ProgressCounters* counters = nullptr,
+                                             const std::atomic<bool>* cancel = nullptr);
+    static ProjectType detect_project_type(const std::string& folder_name);
 
 private:
-    void scan_recursive(const fs::path& path, int current_depth, int max_depth,
-                        std::vector<TargetEntry>& results);
+    // Directories wait in a priority queue: shallow ones first, and those
+    // near projects already found ahead of others at the same depth.
+    struct WorkItem {
+        fs::path path;
+        int depth = 0;
+        ScanCheckpoint::Kind kind = ScanCheckpoint::Kind::Directory;
+        double priority = 0;  // Lower is visited first
+        std::uint64_t seq = 0;
+        double yield = 0;     // Handed down to subdirectories
+        FileId id;            // From the parent's readdir; unknown when resumed
+    };
+    struct WorkOrder {
+        bool operator()(const WorkItem& a, const WorkItem& b) const {
+            return a.priority != b.priority ? a.priority > b.priority : a.seq > b.seq;
+        }
+    };
+    
+    ScanResult run(const ScanCheckpoint& start);
+    void push_work(fs::path path, int depth, ScanCheckpoint::Kind kind, double yield,
+                   FileId id = {});
+    void visit_directory(const WorkItem& item, ScanResult& result);
+    bool may_enter(const fs::path& path, FileId& id);
+    void dispatch_target(fs::path path, std::string name, int depth, FileId id, ScanResult& result);
+    std::size_t visit_target(const fs::path& path, const std::string& name, int depth,
+                             ScanResult& result);
+    void record_target(const TargetEntry& target, ProjectType type, bool notify, ScanResult& result);
     
-    bool passes_age_filter(const fs::path& path) const;
+    bool passes_age_filter(const fs::path& path, const std::string& name) const;
+    std::uint32_t materialize_path(const fs::path& dir);
+    std::size_t root_of(const fs::path& path) const;
+    bool admits(std::uintmax_t bytes) const;
+    void push_top(std::uint32_t row);
+    void compact_store();
     
     const Config& config_;
+    StalenessProbe staleness_;
     std::optional<std::chrono::hours> older_than_;
     ProgressCallback progress_cb_;
+    ProgressCounters* counters_ = nullptr;
+    TargetCallback target_cb_;
+    bool retain_targets_ = true;
+    bool size_targets_ = true;
+    bool materialize_targets_ = true;
+    std::uintmax_t min_bytes_ = 0;
+    std::uintmax_t max_bytes_ = UINTMAX_MAX;
+    std::size_t top_n_ = 0;
+    bool estimate_ = false;
+    double error_squares_ = 0;  // Sum of squared per-target bounds
+    // Hardlinks shared between targets; only when every sized target is kept
+    std::unique_ptr<LinkTracker> links_;
+    // Min-heap of store rows by size; rows evicted from it stay in the store
+    // until the next compaction.
+    std::vector<std::uint32_t> top_heap_;
+    std::optional<std::chrono::milliseconds> time_budget_;
+    
+    std::vector<fs::path> roots_;
+    std::vector<std::uint64_t> root_devs_;
+    int max_depth_ = -1;
+    bool one_file_system_ = false;
+    MountTable mounts_;
+    InodeSet visited_;  // Directories entered (and targets found) this scan
+    std::priority_queue<WorkItem, std::vector<WorkItem>, WorkOrder> frontier_;
+    std::uint64_t work_seq_ = 0;
+    // Taken off the frontier but not finished when the scan stopped
+    std::vector<ScanCheckpoint::Pending> unfinished_;
+    ScanCheckpoint checkpoint_;
+    
+    // Arena ids of directories holding targets; only those get a node
+    std::unordered_map<fs::path::string_type, std::uint32_t> store_nodes_;
+    std::shared_ptr<TargetStore> store_;
+    // Targets are sized on the pool; everything they record is guarded by
+    // results_mutex_ (store, top heap, totals, unfinished_, callbacks)
+    TaskPool* sizers_ = nullptr;
+    std::mutex results_mutex_;
+    std::atomic<bool> cancelled_{false};
     std::size_t found_count_ = 0;
 };
 
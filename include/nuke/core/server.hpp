@@ -0,0 +1,141 @@
+#pragma once
+
+#include "nuke/types.hpp"
+#include "nuke/core/config.hpp"
+#include "nuke/core/protocol.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace nuke {
+
+class Scanner;
+
+struct ServerOptions {
+    fs::path socket_path;                  // Empty: ScanServer::default_socket_path()
+    std::chrono::seconds ttl{60};          // How long a finished walk answers repeats
+    std::size_t max_walks = 2;             // Distinct walks running at once
+    std::size_t max_clients = 64;          // Connections served at once
+};
+
+// ============================================================================
+// Scan Server (nuke serve)
+// ============================================================================
+// Owns an inventory of walks keyed by ScanRequest::key(). A request equal to
+// one being walked joins it and streams the same targets as they are found;
+// a repeat within the TTL is answered from memory. Deletes run in the server
+// too: two whose targets overlap (one inside the other) run one after the
+// other, and each drops the inventory entries it made stale.
+//
+// POSIX only (AF_UNIX, owner-only socket). Elsewhere listen() fails.
+class ScanServer {
+public:
+    ScanServer(const Config& config, ServerOptions options);
+    ~ScanServer();
+
+    ScanServer(const ScanServer&) = delete;
+    ScanServer& operator=(const ScanServer&) = delete;
+
+    // Binds the socket, replacing a stale one; false when another server
+    // already answers there or the socket cannot be created
+    bool listen();
+    // Serves until stop(), then waits for open connections and walks
+    void run();
+    // Safe to call from another thread or a signal handler
+    void stop();
+
+    const fs::path& socket_path() const { return options_.socket_path; }
+
+    // $NUKE_SOCKET, else $XDG_RUNTIME_DIR/nuke.sock, else /tmp/nuke-<uid>.sock
+    static fs::path default_socket_path();
+
+private:
+    // One walk: running while done is false, then a cached answer
+    struct Inventory {
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::vector<TargetEntry> targets;  // In the order found
+        ScanResult summary;                // Totals only
+        std::string error;
+        bool done = false;
+        std::vector<fs::path> roots;
+        std::chrono::steady_clock::time_point finished;
+    };
+
+    void serve_connection(int fd);
+    void handle_handshake(int fd, protocol::Reader& in);
+    void handle_scan(int fd, protocol::Reader& in);
+    void handle_delete(int fd, protocol::Reader& in);
+    std::shared_ptr<Inventory> obtain(const ScanRequest& request, bool& cached, bool& shared);
+    void walk(ScanRequest request, std::shared_ptr<Inventory> inventory);
+    void invalidate(const std::vector<TargetEntry>& deleted);
+
+    // Held while deleting; overlapping sets wait for each other
+    using PathSet = std::set<std::string>;
+    std::list<PathSet>::iterator lock_paths(const std::vector<TargetEntry>& targets);
+    void unlock_paths(std::list<PathSet>::iterator locked);
+
+    const Config& config_;
+    std::uint64_t fingerprint_;  // config_.scan_fingerprint(), fixed at startup
+    ServerOptions options_;
+    std::atomic<int> listen_fd_{-1};
+    std::atomic<bool> stopping_{false};
+
+    std::mutex inventory_mutex_;
+    std::unordered_map<std::string, std::shared_ptr<Inventory>> inventory_;
+
+    // Connections, running walks and walk slots
+    std::mutex state_mutex_;
+    std::condition_variable state_cv_;
+    std::size_t clients_ = 0;
+    std::size_t walks_ = 0;
+    std::size_t walking_ = 0;
+    std::vector<Scanner*> scanners_;  // Cancelled when the server stops
+
+    std::mutex delete_mutex_;
+    std::condition_variable delete_cv_;
+    std::list<PathSet> deleting_;
+};
+
+// ============================================================================
+// Scan Client
+// ============================================================================
+// One connection per request. Every call returns false with error() set when
+// the server is gone or answers with an error.
+class ScanClient {
+public:
+    using TargetCallback = std::function<void(const TargetEntry& target)>;
+
+    explicit ScanClient(fs::path socket_path = ScanServer::default_socket_path());
+
+    // Whether a server accepts connections on the socket right now
+    bool available() const;
+    // Whether the server scans with a config that hashes to `fingerprint`
+    // (Config::scan_fingerprint()); when not, its results would not be the
+    // ones a local scan finds
+    bool matches(std::uint64_t fingerprint);
+
+    // Targets go to on_target as they arrive, or into reply.result.targets
+    // when there is no callback
+    bool scan(const ScanRequest& request, const TargetCallback& on_target, ScanReply& reply);
+    bool destroy(const std::vector<TargetEntry>& targets, DeletionResult& result);
+
+    const fs::path& socket_path() const { return socket_path_; }
+    const std::string& error() const { return error_; }
+
+private:
+    int open() const;
+
+    fs::path socket_path_;
+    std::string error_;
+};
+
+} // namespace nuke
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "nuke/types.hpp"
+#include "nuke/core/config.hpp"
+#include "nuke/core/checkpoint.hpp"
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace nuke {
+
+// ============================================================================
+// Shard Spec ("--shard i/N", 0-based)
+// ============================================================================
+struct ShardSpec {
+    std::uint32_t index = 0;
+    std::uint32_t count = 1;
+
+    static std::optional<ShardSpec> parse(const std::string& text);
+    std::string to_string() const;
+};
+
+// ============================================================================
+// Shard Plan (the same split of the roots on every machine)
+// ============================================================================
+// The roots are cut into units: at first each root's top-level directories,
+// then, while there are fewer than UNITS_PER_SHARD units per shard, the unit
+// with the most subdirectories is replaced by its children, so one dominant
+// subtree is spread over several shards. Every shard reads the same top
+// levels and makes the same choices; a unit belongs to the shard its path
+// (relative to its root) hashes to. The fingerprint covers the whole plan,
+// so `nuke merge` can tell when shards disagreed about the tree.
+struct ShardPlan {
+    static constexpr std::size_t UNITS_PER_SHARD = 16;
+    static constexpr int MAX_SPLIT_DEPTH = 4;
+
+    struct Unit {
+        ScanCheckpoint::Kind kind = ScanCheckpoint::Kind::Directory;
+        int depth = 0;
+        fs::path path;
+        std::string key;  // "<root index>:<relative path>", hashed for the owner
+        std::uint32_t owner = 0;
+    };
+
+    std::vector<fs::path> roots;
+    int max_depth = -1;
+    std::uint32_t shards = 1;
+    std::vector<Unit> units;  // Sorted by key
+    std::uint64_t fingerprint = 0;
+
+    static ShardPlan build(const std::vector<fs::path>& roots, int max_depth, std::uint32_t shards,
+                           const Config& config);
+    // The units owned by one shard, ready for Scanner::resume
+    ScanCheckpoint checkpoint_for(std::uint32_t shard) const;
+};
+
+// ============================================================================
+// Shard Result (what one shard writes and `nuke merge` reads)
+// ============================================================================
+// A checkpoint file with a header: which shard this is, which plan it
+// followed and the unit keys it covered. `state.found` holds its targets and
+// `state.pending` whatever it did not get to.
+struct ShardResult {
+    ShardSpec spec;
+    std::uint64_t fingerprint = 0;
+    std::size_t plan_units = 0;
+    std::vector<std::string> covered;
+    std::chrono::milliseconds duration{0};
+    ScanCheckpoint state;
+
+    bool load(const fs::path& path);
+    bool save(const fs::path& path) const;
+};
+
+// Checks that the shard results are one complete run of one plan: every
+// shard present once, every unit covered by exactly one shard, nothing left
+// pending. Returns the problems found (empty when the merge is sound).
+std::vector<std::string> verify_shards(const std::vector<ShardResult>& shards);
+
+} // namespace nuke
@@ -0,0 +1,151 @@
+#pragma once
+
+#include "nuke/types.hpp"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace nuke {
+
+// ============================================================================
+// Scan Snapshot (--snapshot-out, nuke diff)
+// ============================================================================
+// A scan's targets in one file that is read through a memory mapping:
+// opening checks the header and the section table, and every accessor reads
+// the mapped columns directly, so nothing is parsed or allocated per target.
+//
+// Layout (little-endian, sections 8-byte aligned):
+//   header        magic "NUKESNAP", version, totals, section table
+//   bytes         u64 per target
+//   shared        u64 per target
+//   mtimes        i64 per target (Unix seconds)
+//   files, dirs   u32 per target
+//   types         u8 per target (ProjectType)
+//   restarts      u64 per block of RESTART_INTERVAL targets: offset into paths
+//   paths         per target: varint shared-prefix length, varint suffix
+//                 length, suffix bytes; the prefix is 0 at each block start
+//
+// Targets are sorted by their UTF-8 path bytes, so two snapshots merge-join
+// in one pass and neighbouring paths share most of their bytes.
+class Snapshot {
+public:
+    static constexpr std::uint32_t VERSION = 1;
+    static constexpr std::uint32_t RESTART_INTERVAL = 16;
+
+    Snapshot() = default;
+    ~Snapshot();
+    Snapshot(Snapshot&& other) noexcept;
+    Snapshot& operator=(Snapshot&& other) noexcept;
+    Snapshot(const Snapshot&) = delete;
+    Snapshot& operator=(const Snapshot&) = delete;
+
+    // Writes the result's targets (from the store when it has one), via a
+    // temporary file renamed into place
+    static bool save(const fs::path& file, const ScanResult& result);
+
+    // Maps the file; false with error() set when it is not a snapshot this
+    // version can read
+    bool load(const fs::path& file);
+    const std::string& error() const { return error_; }
+
+    std::size_t size() const { return count_; }
+    std::uint64_t bytes(std::size_t i) const { return bytes_[i]; }
+    std::uint64_t shared(std::size_t i) const { return shared_[i]; }
+    std::int64_t mtime(std::size_t i) const { return mtimes_[i]; }
+    std::uint32_t files(std::size_t i) const { return files_[i]; }
+    std::uint32_t dirs(std::size_t i) const { return dirs_[i]; }
+    ProjectType type(std::size_t i) const { return static_cast<ProjectType>(types_[i]); }
+
+    std::chrono::system_clock::time_point created() const;
+    std::uint64_t total_size() const;
+    bool complete() const;
+    bool estimated() const;
+
+    // Decodes paths in order, reusing one buffer
+    class Cursor {
+    public:
+        explicit Cursor(const Snapshot& snapshot, std::size_t start = 0);
+
+        // Moves to the next target; false at the end or on a corrupt entry
+        bool next();
+        std::size_t index() const { return index_ - 1; }
+        std::string_view path() const { return path_; }
+
+    private:
+        bool decode();
+
+        const Snapshot* snapshot_;
+        std::size_t index_;
+        const std::uint8_t* pos_ = nullptr;
+        std::string path_;
+        std::size_t skip_ = 0;  // Entries to pass before the requested start
+    };
+
+    // One path, decoded from the nearest block start
+    std::string path(std::size_t i) const;
+
+private:
+    void unmap();
+
+    std::string error_;
+    const std::uint8_t* base_ = nullptr;
+    std::size_t length_ = 0;
+    void* mapping_ = nullptr;  // The Windows mapping handle
+
+    std::size_t count_ = 0;
+    const std::uint64_t* bytes_ = nullptr;
+    const std::uint64_t* shared_ = nullptr;
+    const std::int64_t* mtimes_ = nullptr;
+    const std::uint32_t* files_ = nullptr;
+    const std::uint32_t* dirs_ = nullptr;
+    const std::uint8_t* types_ = nullptr;
+    const std::uint64_t* restarts_ = nullptr;
+    const std::uint8_t* paths_ = nullptr;
+    std::size_t paths_size_ = 0;
+};
+
+// ============================================================================
+// Snapshot Diff
+// ============================================================================
+struct SnapshotChange {
+    enum class Kind : std::uint8_t { Added, Removed, Grown, Shrunk };
+
+    Kind kind = Kind::Added;
+    std::string path;
+    std::uint64_t old_bytes = 0;
+    std::uint64_t new_bytes = 0;
+    ProjectType type = ProjectType::Unknown;
+
+    std::int64_t delta() const {
+        return static_cast<std::int64_t>(new_bytes) - static_cast<std::int64_t>(old_bytes);
+    }
+};
+
+inline const char* change_kind_to_string(SnapshotChange::Kind kind) {
+    switch (kind) {
+        case SnapshotChange::Kind::Added: return "added";
+        case SnapshotChange::Kind::Removed: return "removed";
+        case SnapshotChange::Kind::Grown: return "grown";
+        case SnapshotChange::Kind::Shrunk: return "shrunk";
+    }
+    return "added";
+}
+
+struct SnapshotDiff {
+    std::vector<SnapshotChange> changes;  // In path order
+    std::size_t added = 0;
+    std::size_t removed = 0;
+    std::size_t grown = 0;
+    std::size_t shrunk = 0;
+    std::size_t unchanged = 0;            // Including changes under min_delta
+    std::uint64_t old_total = 0;
+    std::uint64_t new_total = 0;
+    bool corrupt = false;                 // A path failed to decode; the diff stops there
+};
+
+// Merge-joins two snapshots in one pass. Targets in both whose size moved by
+// less than min_delta bytes count as unchanged.
+SnapshotDiff diff_snapshots(const Snapshot& before, const Snapshot& after, std::uint64_t min_delta = 0);
+
+} // namespace nuke
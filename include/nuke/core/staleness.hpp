@@ -0,0 +1,37 @@
+#pragma once
+
+#include "nuke/types.hpp"
+#include "nuke/core/config.hpp"
+#include <chrono>
+#include <optional>
+#include <string>
+
+namespace nuke {
+
+// ============================================================================
+// Staleness Probe (--older-than)
+// ============================================================================
+// A target folder's own mtime only moves when an entry directly inside it is
+// added or removed, so it says little about when the project was last built.
+// The probe stats the few marker files the config lists for the folder name
+// (a build stamp, the lockfile beside it) and takes the newest. A folder
+// without markers gets its newest mtime within staleness_depth levels, read
+// from at most PROBE_ENTRIES entries, so the cost stays bounded either way.
+class StalenessProbe {
+public:
+    static constexpr std::size_t PROBE_ENTRIES = 512;
+
+    explicit StalenessProbe(const Config& config) : config_(config) {}
+
+    // When the target was last built or installed; nullopt when neither a
+    // marker nor the folder itself can be read
+    std::optional<std::chrono::system_clock::time_point>
+    last_activity(const fs::path& target, const std::string& name) const;
+
+private:
+    std::optional<std::chrono::system_clock::time_point> newest_within(const fs::path& target) const;
+
+    const Config& config_;
+};
+
+} // namespace nuke
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "nuke/types.hpp"
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace nuke {
+
+// ============================================================================
+// Path Arena
+// ============================================================================
+// Directories interned as (parent id, UTF-8 name slice). Names live in fixed-size
+// character chunks that are never reallocated, so a node costs ~9 bytes plus
+// its name instead of a heap-allocated fs::path.
+class PathArena {
+public:
+    static constexpr std::uint32_t NO_PARENT = UINT32_MAX;
+
+    std::uint32_t add(std::uint32_t parent, std::string_view name);
+
+    std::size_t size() const { return parents_.size(); }
+    std::uint32_t parent(std::uint32_t id) const { return parents_[id]; }
+    std::string_view name(std::uint32_t id) const;
+    fs::path path(std::uint32_t id) const;
+
+    // Rank of every node in a component-wise lexicographic walk of the tree,
+    // computed with string_view comparisons only.
+    std::vector<std::uint32_t> name_order() const;
+
+    // Child lists in CSR form: children of n are
+    // children[offsets[n] .. offsets[n + 1]).
+    void child_index(std::vector<std::uint32_t>& offsets,
+                     std::vector<std::uint32_t>& children) const;
+
+private:
+    static constexpr std::size_t CHUNK_BITS = 20;
+    static constexpr std::size_t CHUNK_SIZE = std::size_t{1} << CHUNK_BITS;
+
+    std::vector<std::uint32_t> parents_;
+    std::vector<std::uint32_t> name_offsets_;  // (chunk << CHUNK_BITS) | position
+    std::vector<std::uint16_t> name_lengths_;
+    std::vector<std::unique_ptr<char[]>> chunks_;
+    std::size_t chunk_used_ = CHUNK_SIZE;
+};
+
+// ============================================================================
+// Target Store (struct-of-arrays scan result)
+// ============================================================================
+class TargetStore {
+public:
+    PathArena& paths() { return paths_; }
+    const PathArena& paths() const { return paths_; }
+
+    std::size_t add_target(std::uint32_t node, ProjectType type, std::uintmax_t bytes,
+                           std::size_t files, std::size_t dirs,
+                           std::chrono::system_clock::time_point last_modified,
+                           std::uintmax_t size_error = 0, std::uintmax_t shared = 0,
+                           FileId id = {},
+                           std::chrono::system_clock::time_point last_used = {});
+
+    // Adds a target's bytes to `node` and every ancestor.
+    void roll_up(std::uint32_t node, std::uintmax_t bytes);
+
+    std::size_t size() const { return nodes_.size(); }
+    std::uint32_t node(std::size_t i) const { return nodes_[i]; }
+    std::uintmax_t bytes(std::size_t i) const { return bytes_[i]; }
+    std::uintmax_t size_error(std::size_t i) const { return size_errors_[i]; }
+    std::uintmax_t shared(std::size_t i) const { return shared_[i]; }
+    const FileId& id(std::size_t i) const { return ids_[i]; }
+    ProjectType type(std::size_t i) const { return types_[i]; }
+    std::uint32_t files(std::size_t i) const { return files_[i]; }
+    std::uint32_t dirs(std::size_t i) const { return dirs_[i]; }
+    std::chrono::system_clock::time_point last_modified(std::size_t i) const;
+    std::chrono::system_clock::time_point last_used(std::size_t i) const;
+
+    std::uintmax_t subtree_bytes(std::uint32_t node) const {
+        return node < subtree_bytes_.size() ? subtree_bytes_[node] : 0;
+    }
+    std::uint32_t subtree_targets(std::uint32_t node) const {
+        return node < subtree_targets_.size() ? subtree_targets_[node] : 0;
+    }
+
+    // Materializes one row as a TargetEntry (the public ScanResult view).
+    TargetEntry entry(std::size_t i) const;
+    std::vector<TargetEntry> entries() const;
+
+    // Index permutation in display order; entries themselves never move.
+    std::vector<std::uint32_t> order_by(SortBy sort_by) const;
+
+    // Keeps only `rows` (which become rows 0..n-1 in that order) and the
+    // path nodes they reference; roll-up totals are recomputed. Returns the
+    // old-to-new node id map (NO_PARENT for dropped nodes).
+    std::vector<std::uint32_t> compact(const std::vector<std::uint32_t>& rows);
+
+private:
+    PathArena paths_;
+
+    // One element per target
+    std::vector<std::uint32_t> nodes_;
+    std::vector<std::uintmax_t> bytes_;
+    std::vector<std::uintmax_t> size_errors_;
+    std::vector<std::uintmax_t> shared_;
+    std::vector<FileId> ids_;
+    std::vector<std::chrono::system_clock::rep> mtimes_;
+    std::vector<std::chrono::system_clock::rep> used_;
+    std::vector<ProjectType> types_;
+    std::vector<std::uint32_t> files_;
+    std::vector<std::uint32_t> dirs_;
+
+    // One element per arena node
+    std::vector<std::uintmax_t> subtree_bytes_;
+    std::vector<std::uint32_t> subtree_targets_;
+};
+
+} // namespace nuke
@@ -0,0 +1,186 @@
+#ifndef NUKE_NUKE_H
+#define NUKE_NUKE_H
+
+/*
+ * libnuke C API
+ *
+ * A stable C ABI over the scanner, destroyer, safety checks and statistics,
+ * for driving scans in-process (a long-lived daemon, a build orchestrator)
+ * instead of spawning the CLI and parsing its output.
+ *
+ * - Objects are opaque handles created and destroyed by the library.
+ * - Every call returns a nuke_status; nothing throws across the boundary.
+ *   After a failure, nuke_last_error() describes it (per thread).
+ * - Strings are UTF-8 and NUL-terminated. Strings handed to callbacks are
+ *   only valid during the call.
+ * - Option structs start with struct_size, so fields can be appended in
+ *   later versions without breaking callers built against older headers.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32) && defined(NUKE_SHARED)
+#  if defined(NUKE_BUILDING)
+#    define NUKE_API __declspec(dllexport)
+#  else
+#    define NUKE_API __declspec(dllimport)
+#  endif
+#elif defined(__GNUC__)
+#  define NUKE_API __attribute__((visibility("default")))
+#else
+#  define NUKE_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Bumped whenever a function, struct or enum changes incompatibly */
+#define NUKE_ABI_VERSION 1
+
+typedef enum nuke_status {
+    NUKE_OK = 0,
+    NUKE_ERROR_INVALID_ARGUMENT = 1,
+    NUKE_ERROR_NOT_FOUND = 2,       /* A path or file does not exist */
+    NUKE_ERROR_UNSAFE_PATH = 3,     /* Refused by the safety checks */
+    NUKE_ERROR_CANCELLED = 4,       /* A callback asked to stop */
+    NUKE_ERROR_INCOMPLETE = 5,      /* Some targets failed or were skipped */
+    NUKE_ERROR_OUT_OF_MEMORY = 6,
+    NUKE_ERROR_INTERNAL = 7
+} nuke_status;
+
+typedef struct nuke_config nuke_config;
+typedef struct nuke_scan nuke_scan;
+
+/* One target, as streamed during a scan or read back from a finished one */
+typedef struct nuke_target {
+    const char* path;
+    const char* project_type;   /* "node", "rust", "python", ... */
+    uint64_t size;              /* Bytes on disk, hardlinks counted once */
+    uint64_t shared_size;       /* Part of size also linked from elsewhere */
+    uint64_t size_error;        /* ~95% bound when sizes are estimated */
+    uint64_t file_count;
+    uint64_t dir_count;
+    int64_t mtime;              /* Unix seconds */
+} nuke_target;
+
+typedef struct nuke_progress {
+    uint64_t entries;   /* Directory entries visited */
+    uint64_t items;     /* Targets found (scan) or deleted (delete) */
+    uint64_t bytes;     /* Bytes sized (scan) or freed (delete) */
+} nuke_progress;
+
+/* Return nonzero to stop: the scan returns what it found so far with
+   NUKE_ERROR_CANCELLED. Calls never overlap. */
+typedef int (*nuke_target_fn)(const nuke_target* target, void* user);
+/* Called from a library thread about every progress_interval_ms */
+typedef void (*nuke_progress_fn)(const nuke_progress* progress, void* user);
+
+/* ---- Library ----------------------------------------------------------- */
+
+NUKE_API uint32_t nuke_abi_version(void);
+NUKE_API const char* nuke_status_string(nuke_status status);
+/* Message for the last failed call on this thread; "" when there is none */
+NUKE_API const char* nuke_last_error(void);
+
+/* ---- Config ------------------------------------------------------------ */
+
+/* Built-in defaults; nothing is read from disk */
+NUKE_API nuke_status nuke_config_create(nuke_config** out);
+NUKE_API void nuke_config_destroy(nuke_config* config);
+/* Replaces settings with those in a YAML file (NULL: the default location) */
+NUKE_API nuke_status nuke_config_load(nuke_config* config, const char* yaml_path);
+NUKE_API nuke_status nuke_config_add_target(nuke_config* config, const char* name);
+NUKE_API nuke_status nuke_config_add_ignore(nuke_config* config, const char* name);
+NUKE_API nuke_status nuke_config_add_protected_path(nuke_config* config, const char* path);
+/* 0 adapts per device; a positive number pins the concurrency */
+NUKE_API nuke_status nuke_config_set_threads(nuke_config* config, int threads);
+
+/* ---- Safety ------------------------------------------------------------ */
+
+/* NUKE_OK when `path` may be deleted (as_root = 0) or scanned from
+   (as_root != 0); NUKE_ERROR_UNSAFE_PATH with the reason otherwise */
+NUKE_API nuke_status nuke_check_path(const nuke_config* config, const char* path, int as_root);
+
+/* ---- Scanning ---------------------------------------------------------- */
+
+typedef struct nuke_scan_options {
+    size_t struct_size;              /* sizeof(nuke_scan_options) */
+    int max_depth;                   /* -1: unlimited */
+    int one_file_system;             /* Do not cross into other filesystems */
+    int estimate;                    /* Sampled sizes instead of full walks */
+    uint64_t min_size;               /* Keep targets of at least this many bytes */
+    uint64_t max_size;               /* 0: no upper limit */
+    uint32_t older_than_hours;       /* 0: any age */
+    uint32_t time_budget_ms;         /* 0: no budget */
+    nuke_target_fn on_target;
+    void* on_target_user;
+    nuke_progress_fn on_progress;
+    void* on_progress_user;
+    uint32_t progress_interval_ms;   /* 0: 100 ms */
+} nuke_scan_options;
+
+/* Fills in the defaults, including struct_size */
+NUKE_API void nuke_scan_options_init(nuke_scan_options* options);
+
+/* Scans one or more roots (a root inside another is dropped) and keeps the
+   targets in *out, which must be released with nuke_scan_destroy. `options`
+   may be NULL. On NUKE_ERROR_CANCELLED *out still holds the partial result. */
+NUKE_API nuke_status nuke_scan_run(const nuke_config* config, const char* const* roots,
+                                   size_t root_count, const nuke_scan_options* options,
+                                   nuke_scan** out);
+NUKE_API void nuke_scan_destroy(nuke_scan* scan);
+
+NUKE_API size_t nuke_scan_count(const nuke_scan* scan);
+/* Fills *out with target `index`; its strings live as long as the scan */
+NUKE_API nuke_status nuke_scan_target(const nuke_scan* scan, size_t index, nuke_target* out);
+/* Bytes deleting every target frees */
+NUKE_API uint64_t nuke_scan_total_size(const nuke_scan* scan);
+NUKE_API uint64_t nuke_scan_total_shared(const nuke_scan* scan);
+/* Predicted milliseconds to delete every target (see delete_rates.txt) */
+NUKE_API uint64_t nuke_scan_predicted_delete_ms(const nuke_scan* scan);
+/* 0 when a budget or a callback stopped the scan early */
+NUKE_API int nuke_scan_complete(const nuke_scan* scan);
+
+/* ---- Deleting ---------------------------------------------------------- */
+
+typedef struct nuke_delete_options {
+    size_t struct_size;              /* sizeof(nuke_delete_options) */
+    int record_stats;                /* Add to the user's stats and ranks */
+    nuke_progress_fn on_progress;
+    void* on_progress_user;
+    uint32_t progress_interval_ms;   /* 0: 100 ms */
+} nuke_delete_options;
+
+typedef struct nuke_deletion {
+    uint64_t deleted;
+    uint64_t failed;
+    uint64_t skipped;        /* Changed since the scan, or protected */
+    uint64_t freed_bytes;
+    uint64_t duration_ms;
+} nuke_deletion;
+
+NUKE_API void nuke_delete_options_init(nuke_delete_options* options);
+
+/* Deletes every target of `scan` that passes the safety checks. Returns
+   NUKE_ERROR_INCOMPLETE when some failed or were skipped; *out is filled
+   either way. `options` may be NULL. */
+NUKE_API nuke_status nuke_delete(const nuke_config* config, const nuke_scan* scan,
+                                 const nuke_delete_options* options, nuke_deletion* out);
+
+/* ---- Statistics -------------------------------------------------------- */
+
+typedef struct nuke_stats {
+    uint64_t total_bytes_deleted;
+    uint64_t total_files_deleted;
+    const char* rank;        /* Valid until the next call on this thread */
+} nuke_stats;
+
+NUKE_API nuke_status nuke_stats_get(nuke_stats* out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NUKE_NUKE_H */
@@ -1,9 +1,16 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <cctype>
 #include <cstdint>
 #include <cstdio>
 #include <filesystem>
+#include <iterator>
+#include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <chrono>
 
@@ -39,6 +46,45 @@ enum class SortBy {
     Date
 };
 
+// ============================================================================
+// Output Format for list / scout / clean
+// ============================================================================
+enum class OutputFormat {
+    Text,    // Colored table for humans (default)
+    Json,    // One JSON document, streamed
+    Ndjson   // One JSON record per line, emitted as targets are found
+};
+
+// ============================================================================
+// Project Type (stored as one byte per target)
+// ============================================================================
+enum class ProjectType : std::uint8_t {
+    Node,
+    Rust,
+    Python,
+    Dotnet,
+    Generic,
+    Unknown
+};
+
+// ============================================================================
+// File Identity
+// ============================================================================
+// (st_dev, st_ino); ino 0 never names a file, so {} means "not known"
+struct FileId {
+    std::uint64_t dev = 0;
+    std::uint64_t ino = 0;
+
+    bool known() const { return ino != 0; }
+    bool operator==(const FileId& other) const { return dev == other.dev && ino == other.ino; }
+};
+
+struct FileIdHash {
+    std::size_t operator()(const FileId& id) const {
+        return static_cast<std::size_t>(id.ino * 0x9e3779b97f4a7c15ULL ^ id.dev);
+    }
+};
+
 // ============================================================================
 // Target Entry (A folder to be deleted)
 // ============================================================================
@@ -47,31 +93,84 @@ struct TargetEntry {
     std::uintmax_t size;
     std::chrono::system_clock::time_point last_modified;
     std::string project_type;
+    std::size_t file_count = 0;
+    std::size_t dir_count = 0;
+    std::uintmax_t size_error = 0;  // ~95% bound when size is a sampled estimate
+    std::uintmax_t shared_size = 0; // Part of size hardlinked from outside the target
+    FileId id;                      // As scanned; deletion checks it is still the same
+    // Newest of last_modified and the file times seen while sizing: when the
+    // target was last built or read. {} when not known (checkpoints, shards).
+    std::chrono::system_clock::time_point last_used{};
+    
+    // last_used when known, else last_modified
+    std::chrono::system_clock::time_point recency() const {
+        return last_used > last_modified ? last_used : last_modified;
+    }
+    
+    // What deleting this target alone frees
+    std::uintmax_t exclusive_size() const { return size - shared_size; }
     
     bool operator<(const TargetEntry& other) const {
         return size > other.size;
     }
 };
 
+class TargetStore;
+
+// ============================================================================
+// Root Total (one root's share of a multi-root scan)
+// ============================================================================
+struct RootTotal {
+    fs::path root;
+    std::uintmax_t total_size = 0;
+    std::size_t total_count = 0;
+};
+
 // ============================================================================
 // Scan Result
 // ============================================================================
 struct ScanResult {
-    std::vector<TargetEntry> targets;
-    std::uintmax_t total_size = 0;
+    std::vector<TargetEntry> targets;          // Materialized view of store (optional)
+    std::shared_ptr<const TargetStore> store;  // Compact rows plus the roll-up tree
+    std::uintmax_t total_size = 0;        // Bytes deleting every target frees
+    std::uintmax_t total_shared = 0;      // Also in targets, but linked from elsewhere
     std::size_t total_count = 0;
     std::chrono::milliseconds scan_duration{0};
+    bool complete = true;                 // False when stopped by a time budget or cancel()
+    bool estimated = false;               // Sizes come from sampled walks (--estimate)
+    std::uintmax_t total_size_error = 0;  // ~95% bound on total_size when estimated
+    std::vector<RootTotal> roots;         // Subtotals, one per root scanned
 };
 
 // ============================================================================
 // Deletion Result
 // ============================================================================
+// Where the time went on one device, for calibrating the cost model
+struct DeviceDeletion {
+    std::uint64_t device = 0;
+    fs::path sample;                       // A target on the device, to name it
+    std::size_t operations = 0;            // Unlinks and rmdirs of the deleted targets
+    std::chrono::milliseconds elapsed{0};  // First target started to last finished
+};
+
 struct DeletionResult {
     std::size_t deleted_count = 0;
     std::size_t failed_count = 0;
+    std::size_t skipped_count = 0;  // Changed since the scan, so left alone
     std::uintmax_t freed_bytes = 0;
     std::chrono::milliseconds duration{0};
     std::vector<std::string> errors;
+    std::vector<std::string> skipped;
+    std::vector<DeviceDeletion> devices;
+};
+
+// ============================================================================
+// Progress Counters (bumped by workers, read by the progress renderer)
+// ============================================================================
+struct ProgressCounters {
+    std::atomic<std::size_t> entries{0};   // Directory entries visited
+    std::atomic<std::size_t> items{0};     // Targets found / deleted
+    std::atomic<std::uintmax_t> bytes{0};  // Bytes sized / freed
 };
 
 // ============================================================================
@@ -132,19 +231,132 @@ inline std::string format_bytes(std::uintmax_t bytes) {
     
     char buf[32];
     if (bytes >= TB) {
-        sprintf_s(buf, sizeof(buf), "%.1f TB", bytes / TB);
+        std::snprintf(buf, sizeof(buf), "%.1f TB", bytes / TB);
     } else if (bytes >= GB) {
-        sprintf_s(buf, sizeof(buf), "%.1f GB", bytes / GB);
+        std::snprintf(buf, sizeof(buf), "%.1f GB", bytes / GB);
     } else if (bytes >= MB) {
-        sprintf_s(buf, sizeof(buf), "%.1f MB", bytes / MB);
+        std::snprintf(buf, sizeof(buf), "%.1f MB", bytes / MB);
     } else if (bytes >= KB) {
-        sprintf_s(buf, sizeof(buf), "%.1f KB", bytes / KB);
+        std::snprintf(buf, sizeof(buf), "%.1f KB", bytes / KB);
     } else {
-        sprintf_s(buf, sizeof(buf), "%llu B", static_cast<unsigned long long>(bytes));
+        std::snprintf(buf, sizeof(buf), "%llu B", static_cast<unsigned long long>(bytes));
     }
     return std::string(buf);
 }
 
+// "850ms", "12.3s", "4m 05s", "2h 10m"
+inline std::string format_duration(std::chrono::milliseconds duration) {
+    auto ms = static_cast<unsigned long long>(duration.count() > 0 ? duration.count() : 0);
+    
+    char buf[32];
+    if (ms < 1000) {
+        std::snprintf(buf, sizeof(buf), "%llums", ms);
+    } else if (ms < 60 * 1000) {
+        std::snprintf(buf, sizeof(buf), "%.1fs", ms / 1000.0);
+    } else if (ms < 60 * 60 * 1000) {
+        std::snprintf(buf, sizeof(buf), "%llum %02llus", ms / 60000, (ms / 1000) % 60);
+    } else {
+        std::snprintf(buf, sizeof(buf), "%lluh %02llum", ms / 3600000, (ms / 60000) % 60);
+    }
+    return std::string(buf);
+}
+
+// Component-wise, so "/a/b" is inside "/a" but "/ab" is not; a path is
+// within itself
+inline bool is_within(const fs::path& path, const fs::path& root) {
+    auto [root_end, path_end] = std::mismatch(root.begin(), root.end(), path.begin(), path.end());
+    return root_end == root.end() ||
+           (std::next(root_end) == root.end() && root_end->empty());  // "root/" form
+}
+
+// FNV-1a; stable across platforms and runs, unlike std::hash
+inline std::uint64_t fnv1a(std::string_view text, std::uint64_t hash = 14695981039346656037ULL) {
+    for (char c : text) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+// Time since `when`: "12d", "4mo", "3y"
+inline std::string format_age(std::chrono::system_clock::time_point when) {
+    auto days = std::chrono::duration_cast<std::chrono::hours>(
+        std::chrono::system_clock::now() - when).count() / 24;
+    if (days >= 730) return std::to_string(days / 365) + "y";
+    if (days >= 60) return std::to_string(days / 30) + "mo";
+    return std::to_string(days < 0 ? 0 : days) + "d";
+}
+
+// Parses "500MB", "1.5 GB", "4096" (binary units, as printed by format_bytes)
+inline std::optional<std::uintmax_t> parse_bytes(const std::string& s) {
+    std::size_t pos = 0;
+    double value = 0;
+    try {
+        value = std::stod(s, &pos);
+    } catch (...) {
+        return std::nullopt;
+    }
+    if (value < 0) return std::nullopt;
+
+    std::string unit;
+    for (std::size_t i = pos; i < s.size(); ++i) {
+        if (s[i] != ' ') unit += static_cast<char>(std::toupper(static_cast<unsigned char>(s[i])));
+    }
+
+    double scale = 1.0;
+    if (unit.empty() || unit == "B") scale = 1.0;
+    else if (unit == "K" || unit == "KB") scale = 1024.0;
+    else if (unit == "M" || unit == "MB") scale = 1024.0 * 1024.0;
+    else if (unit == "G" || unit == "GB") scale = 1024.0 * 1024.0 * 1024.0;
+    else if (unit == "T" || unit == "TB") scale = 1024.0 * 1024.0 * 1024.0 * 1024.0;
+    else return std::nullopt;
+
+    return static_cast<std::uintmax_t>(value * scale);
+}
+
+// Parses "500ms", "60s", "5m", "2h" (a bare number means seconds)
+inline std::optional<std::chrono::milliseconds> parse_duration(const std::string& s) {
+    std::size_t pos = 0;
+    double value = 0;
+    try {
+        value = std::stod(s, &pos);
+    } catch (...) {
+        return std::nullopt;
+    }
+    if (value < 0) return std::nullopt;
+    
+    std::string unit = s.substr(pos);
+    double ms = 0;
+    if (unit == "ms") ms = value;
+    else if (unit.empty() || unit == "s") ms = value * 1000.0;
+    else if (unit == "m") ms = value * 60.0 * 1000.0;
+    else if (unit == "h") ms = value * 3600.0 * 1000.0;
+    else return std::nullopt;
+    
+    return std::chrono::milliseconds(static_cast<long long>(ms));
+}
+
+inline const char* project_type_to_string(ProjectType type) {
+    switch (type) {
+        case ProjectType::Node: return "node";
+        case ProjectType::Rust: return "rust";
+        case ProjectType::Python: return "python";
+        case ProjectType::Dotnet: return "dotnet";
+        case ProjectType::Generic: return "generic";
+        case ProjectType::Unknown: return "unknown";
+    }
+    return "unknown";
+}
+
+inline ProjectType string_to_project_type(const std::string& s) {
+    if (s == "node") return ProjectType::Node;
+    if (s == "rust") return ProjectType::Rust;
+    if (s == "python") return ProjectType::Python;
+    if (s == "dotnet") return ProjectType::Dotnet;
+    if (s == "generic") return ProjectType::Generic;
+    return ProjectType::Unknown;
+}
+
 inline std::string verbosity_to_string(Verbosity v) {
     switch (v) {
         case Verbosity::Quiet: return "quiet";
@@ -165,4 +377,11 @@ inline Verbosity string_to_verbosity(const std::string& s) {
     return Verbosity::Normal;
 }
 
+inline std::optional<OutputFormat> string_to_output_format(const std::string& s) {
+    if (s == "text") return OutputFormat::Text;
+    if (s == "json") return OutputFormat::Json;
+    if (s == "ndjson") return OutputFormat::Ndjson;
+    return std::nullopt;
+}
+
 } // namespace nuke
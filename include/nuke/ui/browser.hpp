@@ -0,0 +1,96 @@
+#pragma once
+
+#include "nuke/types.hpp"
+#include "nuke/core/config.hpp"
+#include "nuke/core/scanner.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace nuke {
+
+// ============================================================================
+// Interactive Browser (nuke ui)
+// ============================================================================
+// Targets appear as the scan discovers them. A small pool sizes them in the
+// background, rows on screen first. Sorting and filtering only rebuild an
+// index permutation, and rendering touches just the visible window, so it
+// stays responsive with 100k rows.
+class Browser {
+public:
+    Browser(const Config& config, fs::path root, int max_depth);
+    ~Browser();
+
+    Browser(const Browser&) = delete;
+    Browser& operator=(const Browser&) = delete;
+
+    int run();
+
+private:
+    enum class SizeState : std::uint8_t {
+        Pending,
+        Sizing,
+        Sized
+    };
+
+    struct Row {
+        TargetEntry entry;
+        SizeState state = SizeState::Pending;
+        bool selected = false;
+        bool deleted = false;
+    };
+
+    void start_workers();
+    void stop_workers();
+    void sizer_loop();
+    bool claim_next(std::size_t& index, fs::path& path);
+
+    void rebuild_view();
+    bool passes_filters(const Row& row) const;
+    void render(int width, int height);
+    void move_cursor(long long delta);
+    void handle_key(int key, int page);
+    void request_delete();
+    bool delete_ready() const;
+    void delete_selected();
+
+    const Config& config_;
+    fs::path root_;
+    int max_depth_;
+
+    // Shared with scan and sizer threads; guarded by mutex_
+    mutable std::mutex mutex_;
+    std::deque<Row> rows_;
+    std::vector<std::size_t> visible_rows_;
+    std::size_t next_unsized_ = 0;
+    std::size_t sized_count_ = 0;
+    // Rows picked for deletion; sized ahead of the rest, and the prompt
+    // waits until they all are
+    std::vector<std::size_t> pending_delete_;
+    bool scan_done_ = false;
+    bool dirty_ = true;
+
+    std::condition_variable work_cv_;
+    std::atomic<bool> stopping_{false};
+    std::unique_ptr<Scanner> scanner_;
+    std::thread scan_thread_;
+    std::vector<std::thread> sizers_;
+
+    // UI state (UI thread only)
+    std::vector<std::size_t> view_;
+    std::size_t cursor_ = 0;
+    std::size_t scroll_ = 0;
+    SortBy sort_by_ = SortBy::Size;
+    int type_filter_ = 0;
+    int age_filter_ = 0;
+    int size_filter_ = 0;
+    std::string status_;
+};
+
+} // namespace nuke
@@ -1,6 +1,10 @@
 #pragma once
 
 #include "nuke/types.hpp"
+#include "nuke/core/cost_model.hpp"
+#include "nuke/core/quota.hpp"
+#include "nuke/core/snapshot.hpp"
+#include "nuke/utils/profiler.hpp"
 #include <string>
 #include <vector>
 
@@ -9,16 +13,26 @@ namespace nuke {
 class Display {
 public:
     static void show_scan_results(const ScanResult& results, SortBy sort_by = SortBy::Size);
-    static void show_deletion_results(const DeletionResult& results);
+    // `forecast`, when given, is compared with how long deleting took
+    static void show_deletion_results(const DeletionResult& results,
+                                      const DeletionForecast* forecast = nullptr);
+    static void show_deletion_forecast(const std::vector<TargetEntry>& targets,
+                                       const DeletionForecast& forecast);
+    // Changes in the order given, then the counts and totals
+    static void show_snapshot_diff(const SnapshotDiff& diff);
+    // The eviction set, least recently used first, then each budget's usage
+    static void show_quota_plan(const QuotaPlan& plan);
     static void show_stats(const UserStats& stats);
+    static void show_profile(const Profiler& profiler);
     static void show_scan_progress(const fs::path& current, std::size_t found);
     static void show_deletion_progress(std::size_t current, std::size_t total, 
                                         const fs::path& current_path);
     static bool confirm(const std::string& message, bool default_yes = false);
     static bool captcha(const std::string& reason);
-    static void show_tree(const std::vector<TargetEntry>& entries, int max_depth = 2);
+    static void show_tree(const ScanResult& results, int max_depth = 2);
     static void show_banner();
     static void clear_line();
+    static bool is_terminal();
     
     struct Color {
         static std::string red(const std::string& text);
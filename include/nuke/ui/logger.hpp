@@ -1,7 +1,13 @@
 #pragma once
 
 #include "nuke/types.hpp"
+#include "nuke/utils/bounded_queue.hpp"
+#include <fmt/core.h>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <chrono>
 
 namespace nuke {
@@ -9,34 +15,75 @@ namespace nuke {
 class Logger {
 public:
     static Logger& instance();
-    
+    ~Logger();
+
     void set_verbosity(Verbosity level) { verbosity_ = level; }
     Verbosity verbosity() const { return verbosity_; }
+    bool enabled(Verbosity level) const { return verbosity_ >= level; }
     
+    // Sends all output to stderr, leaving stdout to machine-readable results.
+    void set_reserve_stdout(bool reserve) { reserve_stdout_ = reserve; }
+
     void quiet(const std::string& msg) const;
     void minimal(const std::string& msg) const;
     void normal(const std::string& msg) const;
     void detailed(const std::string& msg) const;
     void diagnostic(const std::string& msg) const;
-    
+
     void error(const std::string& msg) const;
     void success(const std::string& msg) const;
     void warning(const std::string& msg) const;
-    
+
+    // Blocks until every message queued so far has been written. Call before
+    // writing to the console directly so output stays in order.
+    void flush() const;
+
     class Timer {
     public:
-        explicit Timer(const std::string& operation);
+        explicit Timer(const char* operation);
         ~Timer();
     private:
-        std::string operation_;
+        const char* operation_;
         std::chrono::high_resolution_clock::time_point start_;
     };
 
 private:
+    struct Record {
+        std::string text;
+        bool to_stderr = false;
+    };
+
     Logger() = default;
+    void write(std::string text, bool to_stderr) const;
+    void writer_loop() const;
+
     Verbosity verbosity_ = Verbosity::Normal;
+    bool reserve_stdout_ = false;
+
+    // Asynchronous sink: producers push formatted lines, a single writer
+    // thread drains them in batches and flushes once per batch.
+    mutable BoundedQueue<Record> queue_{4096};
+    mutable std::atomic<std::uint64_t> pushed_{0};
+    mutable std::atomic<std::uint64_t> written_{0};
+    mutable std::atomic<std::uint32_t> wakeups_{0};
+    mutable std::atomic<bool> stopping_{false};
+    mutable std::once_flag writer_started_;
+    mutable std::thread writer_;
 };
 
 #define NUKE_TIMER(name) nuke::Logger::Timer _timer_##__LINE__(name)
 
+// Deferred-format logging: arguments are only evaluated and formatted when
+// the level is enabled, e.g. NUKE_DIAG("Skipping entry: {}", e.what()).
+#define NUKE_LOG_AT(level, method, ...)                                        \
+    do {                                                                       \
+        const auto& nuke_logger_ = ::nuke::Logger::instance();                 \
+        if (nuke_logger_.enabled(level)) {                                     \
+            nuke_logger_.method(fmt::format(__VA_ARGS__));                     \
+        }                                                                      \
+    } while (0)
+
+#define NUKE_DETAIL(...) NUKE_LOG_AT(::nuke::Verbosity::Detailed, detailed, __VA_ARGS__)
+#define NUKE_DIAG(...) NUKE_LOG_AT(::nuke::Verbosity::Diagnostic, diagnostic, __VA_ARGS__)
+
 } // namespace nuke
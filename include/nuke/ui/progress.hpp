@@ -0,0 +1,58 @@
+#pragma once
+
+#include "nuke/types.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace nuke {
+
+// ============================================================================
+// Progress Renderer
+// ============================================================================
+// Workers only bump the atomic ProgressCounters; a dedicated thread redraws
+// at a fixed rate with a single write per frame. When stdout is not a
+// terminal it prints a plain status line every few seconds instead.
+class ProgressRenderer {
+public:
+    enum class Phase {
+        Scanning,
+        Deleting
+    };
+
+    explicit ProgressRenderer(Phase phase,
+                              std::chrono::milliseconds interval = std::chrono::milliseconds(100));
+    ~ProgressRenderer();
+
+    ProgressRenderer(const ProgressRenderer&) = delete;
+    ProgressRenderer& operator=(const ProgressRenderer&) = delete;
+
+    ProgressCounters& counters() { return counters_; }
+
+    // Totals enable the percentage bar and ETA (deletion only).
+    void set_totals(std::size_t items, std::uintmax_t bytes);
+
+    void start();
+    void stop();
+
+private:
+    void run();
+    std::string render_frame(std::chrono::steady_clock::duration elapsed, bool plain) const;
+
+    Phase phase_;
+    std::chrono::milliseconds interval_;
+    ProgressCounters counters_;
+    std::size_t total_items_ = 0;
+    std::uintmax_t total_bytes_ = 0;
+    bool tty_ = false;
+
+    std::chrono::steady_clock::time_point started_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stopping_ = false;
+    std::thread thread_;
+};
+
+} // namespace nuke
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "nuke/types.hpp"
+#include "nuke/core/cost_model.hpp"
+#include "nuke/core/quota.hpp"
+#include "nuke/core/snapshot.hpp"
+#include "nuke/utils/safety.hpp"
+#include <fmt/format.h>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <string>
+
+namespace nuke {
+
+// ============================================================================
+// Machine-readable Result Writer (--format json|ndjson)
+// ============================================================================
+// Records are formatted into one reusable buffer that is written out in
+// large chunks, so streaming a huge scan never holds the whole result.
+//
+// NDJSON: one object per line, tagged by "type":
+//   {"type":"target",...} ... {"type":"scan_summary",...} {"type":"deletion_forecast",...}
+//   {"type":"deletion_summary",...}
+//   nuke diff: {"type":"change",...} ... {"type":"diff_summary",...}
+//   nuke enforce: the evicted targets, then {"type":"quota_summary",...}
+// JSON: a single document {"command":..,"targets":[..],"scan_summary":..,"deletion_forecast":..,
+//   "deletion_summary":..}; nuke diff puts its changes in "targets"
+class ResultWriter {
+public:
+    ResultWriter(OutputFormat format, const std::string& command, std::FILE* out = stdout);
+    ~ResultWriter();
+
+    ResultWriter(const ResultWriter&) = delete;
+    ResultWriter& operator=(const ResultWriter&) = delete;
+
+    void write_target(const TargetEntry& target);
+    // `rejected`: targets already written that the safety checks then refused
+    void write_scan_summary(const ScanResult& result, const std::vector<Safety::Rejection>& rejected = {});
+    // Predicted deletion time in total and per target (same order as `targets`)
+    void write_forecast(const std::vector<TargetEntry>& targets, const DeletionForecast& forecast);
+    void write_deletion_summary(const DeletionResult& result);
+    void write_change(const SnapshotChange& change);
+    void write_diff_summary(const SnapshotDiff& diff);
+    void write_quota_summary(const QuotaPlan& plan);
+
+    // Closes the JSON document (if any) and writes out the buffer.
+    void finish();
+
+private:
+    void begin_record(const char* type);
+    void end_record();
+    void flush_if_full();
+    void flush();
+
+    OutputFormat format_;
+    std::FILE* out_;
+    fmt::memory_buffer buffer_;
+    std::chrono::steady_clock::time_point last_flush_ = std::chrono::steady_clock::now();
+    std::mutex mutex_;
+    std::size_t target_count_ = 0;
+    bool targets_closed_ = false;
+    bool finished_ = false;
+};
+
+} // namespace nuke
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <fmt/format.h>
+#include <filesystem>
+#include <string_view>
+
+namespace nuke {
+
+// Appends `text` as a quoted JSON string. Bytes >= 0x80 are passed through
+// unchanged, so UTF-8 paths stay readable.
+inline void append_json_string(fmt::memory_buffer& out, std::string_view text) {
+    out.push_back('"');
+    for (char c : text) {
+        switch (c) {
+            case '"': out.append(std::string_view("\\\"")); break;
+            case '\\': out.append(std::string_view("\\\\")); break;
+            case '\n': out.append(std::string_view("\\n")); break;
+            case '\r': out.append(std::string_view("\\r")); break;
+            case '\t': out.append(std::string_view("\\t")); break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    fmt::format_to(std::back_inserter(out), "\\u{:04x}", static_cast<unsigned>(c));
+                } else {
+                    out.push_back(c);
+                }
+        }
+    }
+    out.push_back('"');
+}
+
+// Paths go through u8string(): string() is the ANSI code page on Windows,
+// which is not UTF-8 and throws on characters it cannot map
+inline void append_json_path(fmt::memory_buffer& out, const std::filesystem::path& path) {
+    auto u8 = path.u8string();
+    append_json_string(out, std::string_view(reinterpret_cast<const char*>(u8.data()), u8.size()));
+}
+
+} // namespace nuke
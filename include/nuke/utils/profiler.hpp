@@ -0,0 +1,133 @@
+#pragma once
+
+#include "nuke/types.hpp"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace nuke {
+
+// ============================================================================
+// Filesystem Operations tracked by --profile
+// ============================================================================
+enum class FsOp : std::uint8_t {
+    OpenDir,       // Open a directory for enumeration
+    ReadDir,       // Advance a directory iterator (one entry)
+    Stat,          // stat/lstat (size, mtime, type)
+    Unlink,        // Remove a file or symlink
+    Rmdir,         // Remove an empty directory
+    Canonicalize,  // Path resolution (weakly_canonical)
+    Spawn,         // External helper process (robocopy)
+    Count
+};
+
+inline const char* fs_op_to_string(FsOp op) {
+    switch (op) {
+        case FsOp::OpenDir: return "opendir";
+        case FsOp::ReadDir: return "readdir";
+        case FsOp::Stat: return "stat";
+        case FsOp::Unlink: return "unlink";
+        case FsOp::Rmdir: return "rmdir";
+        case FsOp::Canonicalize: return "canonicalize";
+        case FsOp::Spawn: return "spawn";
+        case FsOp::Count: break;
+    }
+    return "unknown";
+}
+
+// ============================================================================
+// Latency Histogram (log-linear buckets, ~6% relative error)
+// ============================================================================
+class LatencyHistogram {
+public:
+    static constexpr int SUB_BITS = 4;
+    static constexpr int SUB_COUNT = 1 << SUB_BITS;
+    static constexpr int BUCKETS = (64 - SUB_BITS + 1) * SUB_COUNT;
+
+    void record(std::uint64_t ns);
+    void merge(const LatencyHistogram& other);
+
+    std::uint64_t count() const { return count_; }
+    std::uint64_t total_ns() const { return total_ns_; }
+    std::uint64_t min_ns() const { return count_ ? min_ns_ : 0; }
+    std::uint64_t max_ns() const { return max_ns_; }
+    std::uint64_t percentile(double p) const;
+
+private:
+    static int bucket_index(std::uint64_t ns);
+    static std::uint64_t bucket_midpoint(int index);
+
+    std::array<std::uint64_t, BUCKETS> buckets_{};
+    std::uint64_t count_ = 0;
+    std::uint64_t total_ns_ = 0;
+    std::uint64_t min_ns_ = UINT64_MAX;
+    std::uint64_t max_ns_ = 0;
+};
+
+// ============================================================================
+// Profiler
+// ============================================================================
+class Profiler {
+public:
+    struct ThreadProfile {
+        std::size_t index = 0;
+        std::array<LatencyHistogram, static_cast<std::size_t>(FsOp::Count)> ops;
+    };
+
+    static Profiler& instance();
+
+    void enable() { enabled_.store(true, std::memory_order_relaxed); }
+    bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+    void record(FsOp op, std::uint64_t ns);
+
+    // Only call once worker threads have finished recording.
+    const std::vector<std::unique_ptr<ThreadProfile>>& threads() const { return threads_; }
+    LatencyHistogram totals(FsOp op) const;
+
+    bool write_json(const fs::path& path) const;
+
+private:
+    Profiler() = default;
+    ThreadProfile& local();
+
+    std::atomic<bool> enabled_{false};
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<ThreadProfile>> threads_;
+};
+
+// Times the enclosing scope and records it under `op` when profiling is on.
+class ProfileScope {
+public:
+    explicit ProfileScope(FsOp op) : op_(op), active_(Profiler::instance().enabled()) {
+        if (active_) start_ = std::chrono::steady_clock::now();
+    }
+
+    ~ProfileScope() {
+        if (active_) {
+            auto elapsed = std::chrono::steady_clock::now() - start_;
+            Profiler::instance().record(op_, static_cast<std::uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+        }
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    FsOp op_;
+    bool active_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+#define NUKE_PROFILE_CONCAT_(a, b) a##b
+#define NUKE_PROFILE_CONCAT(a, b) NUKE_PROFILE_CONCAT_(a, b)
+#define NUKE_PROFILE(op) \
+    ::nuke::ProfileScope NUKE_PROFILE_CONCAT(nuke_profile_scope_, __LINE__)(::nuke::FsOp::op)
+
+} // namespace nuke
@@ -1,19 +1,75 @@
 #pragma once
 
 #include "nuke/types.hpp"
+#include "nuke/core/config.hpp"
+#include <cstdint>
+#include <shared_mutex>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace nuke {
 
+// ============================================================================
+// Safety (protected-prefix trie over canonical paths)
+// ============================================================================
+// Built once per command from filesystem roots, system directories, the home
+// directory, every mount point and the config's protected_paths. A check
+// resolves the path through a cache of already canonicalized directories (a
+// miss costs one lstat per new ancestor) and walks the trie component by
+// component, so validating every target costs microseconds each.
 class Safety {
 public:
-    static bool is_safe_path(const fs::path& path);
-    static bool is_root_path(const fs::path& path);
-    static bool is_home_path(const fs::path& path);
+    struct Rejection {
+        TargetEntry target;
+        std::string reason;
+    };
+
+    explicit Safety(const Config& config);
+
+    // Why a scan may not start at `root`; empty when it may
+    std::string check_root(const fs::path& root) const;
+    // Why `path` may not be deleted, including anything protected inside it;
+    // empty when it may
+    std::string check_target(const fs::path& path) const;
+    // Checks every target in parallel and removes the unsafe ones, keeping
+    // the order of the rest
+    std::vector<Rejection> validate(std::vector<TargetEntry>& targets) const;
+
+    // "~" and "~/..." below the home directory; anything else as given
+    static fs::path expand_home(const std::string& path);
     static bool is_protected_folder(const std::string& name);
-    static bool requires_captcha(std::uintmax_t total_bytes, std::size_t project_count);
+    // `reclaimable_bytes` is what deleting frees, not counting hardlinked data
+    static bool requires_captcha(std::uintmax_t reclaimable_bytes, std::size_t project_count);
     static const std::vector<std::string>& protected_folders();
-    static std::string get_unsafe_reason(const fs::path& path);
+
+private:
+    enum class Guard : std::uint8_t {
+        None,
+        Exact,    // The directory itself
+        Subtree   // The directory and everything below it
+    };
+
+    struct Node {
+        std::unordered_map<fs::path::string_type, std::uint32_t> children;
+        Guard guard = Guard::None;
+        bool blocks_scan = false;    // Also refused as a scan root
+        bool guards_below = false;   // Some descendant is guarded
+        std::string label;           // "the system directory /usr", ...
+    };
+
+    void protect(const fs::path& path, Guard guard, bool blocks_scan, std::string label);
+    std::string verdict(const fs::path& path, bool deleting) const;
+    const Node* first_guarded_below(const Node& node) const;
+
+    fs::path resolve(const fs::path& path) const;
+    fs::path resolve_directory(const fs::path& dir) const;
+
+    std::vector<Node> nodes_;  // nodes_[0] is the root of the trie
+    fs::path home_;
+
+    mutable std::shared_mutex cache_mutex_;
+    mutable std::unordered_map<fs::path::string_type, fs::path> resolved_;
 };
 
 } // namespace nuke
@@ -0,0 +1,454 @@
+#include "nuke/nuke.h"
+#include "nuke/core/config.hpp"
+#include "nuke/core/cost_model.hpp"
+#include "nuke/core/destroyer.hpp"
+#include "nuke/core/root_set.hpp"
+#include "nuke/core/scanner.hpp"
+#include "nuke/utils/safety.hpp"
+#include "nuke/utils/stats.hpp"
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+// ============================================================================
+// Handles
+// ============================================================================
+
+struct nuke_config {
+    nuke::Config config;
+};
+
+struct nuke_scan {
+    nuke::ScanResult result;
+    // Kept beside the rows so nuke_target can point into them
+    std::vector<std::string> paths;
+    std::vector<std::string> types;
+    std::uint64_t predicted_delete_ms = 0;
+};
+
+namespace {
+    using namespace nuke;
+
+    thread_local std::string last_error;
+
+    nuke_status fail(nuke_status status, std::string message) {
+        last_error = std::move(message);
+        return status;
+    }
+
+    // Runs `body` with every exception turned into a status; nothing may
+    // unwind into C callers
+    template <typename Body>
+    nuke_status guarded(Body&& body) {
+        try {
+            last_error.clear();
+            return body();
+        } catch (const std::bad_alloc&) {
+            return fail(NUKE_ERROR_OUT_OF_MEMORY, "out of memory");
+        } catch (const fs::filesystem_error& e) {
+            return fail(e.code() == std::errc::no_such_file_or_directory ? NUKE_ERROR_NOT_FOUND
+                                                                         : NUKE_ERROR_INTERNAL,
+                        e.what());
+        } catch (const std::exception& e) {
+            return fail(NUKE_ERROR_INTERNAL, e.what());
+        } catch (...) {
+            return fail(NUKE_ERROR_INTERNAL, "unknown error");
+        }
+    }
+
+    // Copies the caller's struct over the defaults, as far as both know
+    // the layout; older callers simply leave the newer fields at default
+    template <typename Options>
+    Options read_options(const Options* given, void (*init)(Options*)) {
+        Options options;
+        init(&options);
+        if (given && given->struct_size > sizeof(given->struct_size)) {
+            std::memcpy(&options, given, std::min(given->struct_size, sizeof(Options)));
+        }
+        options.struct_size = sizeof(Options);
+        return options;
+    }
+
+    std::int64_t unix_seconds(std::chrono::system_clock::time_point tp) {
+        return std::chrono::duration_cast<std::chrono::seconds>(tp.time_since_epoch()).count();
+    }
+
+    void fill_target(const TargetEntry& entry, const char* path, const char* type, nuke_target* out) {
+        out->path = path;
+        out->project_type = type;
+        out->size = entry.size;
+        out->shared_size = entry.shared_size;
+        out->size_error = entry.size_error;
+        out->file_count = entry.file_count;
+        out->dir_count = entry.dir_count;
+        out->mtime = unix_seconds(entry.last_modified);
+    }
+
+    // Reports the counters to a progress callback from its own thread until
+    // destroyed, then once more with the final values
+    class ProgressTicker {
+    public:
+        ProgressTicker(const ProgressCounters& counters, nuke_progress_fn fn, void* user,
+                       std::uint32_t interval_ms)
+            : counters_(counters), fn_(fn), user_(user),
+              interval_(interval_ms > 0 ? interval_ms : 100) {
+            if (fn_) {
+                thread_ = std::thread([this] { run(); });
+            }
+        }
+
+        ~ProgressTicker() {
+            if (!fn_) return;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stopping_ = true;
+            }
+            cv_.notify_all();
+            thread_.join();
+            report();
+        }
+
+        ProgressTicker(const ProgressTicker&) = delete;
+        ProgressTicker& operator=(const ProgressTicker&) = delete;
+
+    private:
+        void run() {
+            std::unique_lock<std::mutex> lock(mutex_);
+            while (!cv_.wait_for(lock, interval_, [this] { return stopping_; })) {
+                report();
+            }
+        }
+
+        void report() const {
+            nuke_progress progress{counters_.entries.load(std::memory_order_relaxed),
+                                   counters_.items.load(std::memory_order_relaxed),
+                                   counters_.bytes.load(std::memory_order_relaxed)};
+            fn_(&progress, user_);
+        }
+
+        const ProgressCounters& counters_;
+        nuke_progress_fn fn_;
+        void* user_;
+        std::chrono::milliseconds interval_;
+        std::mutex mutex_;
+        std::condition_variable cv_;
+        bool stopping_ = false;
+        std::thread thread_;
+    };
+}
+
+// ============================================================================
+// Library
+// ============================================================================
+
+extern "C" {
+
+uint32_t nuke_abi_version(void) {
+    return NUKE_ABI_VERSION;
+}
+
+const char* nuke_status_string(nuke_status status) {
+    switch (status) {
+        case NUKE_OK: return "ok";
+        case NUKE_ERROR_INVALID_ARGUMENT: return "invalid argument";
+        case NUKE_ERROR_NOT_FOUND: return "not found";
+        case NUKE_ERROR_UNSAFE_PATH: return "unsafe path";
+        case NUKE_ERROR_CANCELLED: return "cancelled";
+        case NUKE_ERROR_INCOMPLETE: return "incomplete";
+        case NUKE_ERROR_OUT_OF_MEMORY: return "out of memory";
+        case NUKE_ERROR_INTERNAL: return "internal error";
+    }
+    return "unknown status";
+}
+
+const char* nuke_last_error(void) {
+    return last_error.c_str();
+}
+
+// ============================================================================
+// Config
+// ============================================================================
+
+nuke_status nuke_config_create(nuke_config** out) {
+    if (!out) return fail(NUKE_ERROR_INVALID_ARGUMENT, "out is NULL");
+    return guarded([&] {
+        *out = new nuke_config();
+        return NUKE_OK;
+    });
+}
+
+void nuke_config_destroy(nuke_config* config) {
+    delete config;
+}
+
+nuke_status nuke_config_load(nuke_config* config, const char* yaml_path) {
+    if (!config) return fail(NUKE_ERROR_INVALID_ARGUMENT, "config is NULL");
+    return guarded([&] {
+        fs::path path = yaml_path ? fs::path(yaml_path) : Config::get_default_config_path();
+        if (!fs::exists(path)) {
+            return fail(NUKE_ERROR_NOT_FOUND, "no config file at " + path.string());
+        }
+        if (!config->config.load(path)) {
+            return fail(NUKE_ERROR_INVALID_ARGUMENT, "could not parse " + path.string());
+        }
+        return NUKE_OK;
+    });
+}
+
+nuke_status nuke_config_add_target(nuke_config* config, const char* name) {
+    if (!config || !name || !*name) return fail(NUKE_ERROR_INVALID_ARGUMENT, "missing name");
+    return guarded([&] {
+        config->config.add_target(name);
+        return NUKE_OK;
+    });
+}
+
+nuke_status nuke_config_add_ignore(nuke_config* config, const char* name) {
+    if (!config || !name || !*name) return fail(NUKE_ERROR_INVALID_ARGUMENT, "missing name");
+    return guarded([&] {
+        config->config.add_ignore(name);
+        return NUKE_OK;
+    });
+}
+
+nuke_status nuke_config_add_protected_path(nuke_config* config, const char* path) {
+    if (!config || !path || !*path) return fail(NUKE_ERROR_INVALID_ARGUMENT, "missing path");
+    return guarded([&] {
+        config->config.add_protected_path(path);
+        return NUKE_OK;
+    });
+}
+
+nuke_status nuke_config_set_threads(nuke_config* config, int threads) {
+    if (!config || threads < 0) return fail(NUKE_ERROR_INVALID_ARGUMENT, "threads must be >= 0");
+    config->config.set_scan_threads(threads);
+    return NUKE_OK;
+}
+
+// ============================================================================
+// Safety
+// ============================================================================
+
+nuke_status nuke_check_path(const nuke_config* config, const char* path, int as_root) {
+    if (!config || !path) return fail(NUKE_ERROR_INVALID_ARGUMENT, "missing config or path");
+    return guarded([&] {
+        Safety safety(config->config);
+        std::string reason = as_root ? safety.check_root(path) : safety.check_target(path);
+        return reason.empty() ? NUKE_OK : fail(NUKE_ERROR_UNSAFE_PATH, reason);
+    });
+}
+
+// ============================================================================
+// Scanning
+// ============================================================================
+
+void nuke_scan_options_init(nuke_scan_options* options) {
+    if (!options) return;
+    *options = nuke_scan_options{};
+    options->struct_size = sizeof(nuke_scan_options);
+    options->max_depth = -1;
+}
+
+nuke_status nuke_scan_run(const nuke_config* config, const char* const* roots, size_t root_count,
+                          const nuke_scan_options* given, nuke_scan** out) {
+    if (!config || !roots || root_count == 0 || !out) {
+        return fail(NUKE_ERROR_INVALID_ARGUMENT, "need a config, at least one root and out");
+    }
+    *out = nullptr;
+    return guarded([&] {
+        auto options = read_options(given, nuke_scan_options_init);
+
+        std::vector<std::string> inputs;
+        for (size_t i = 0; i < root_count; ++i) {
+            if (!roots[i]) return fail(NUKE_ERROR_INVALID_ARGUMENT, "root is NULL");
+            inputs.emplace_back(roots[i]);
+        }
+        auto plan = RootSet::plan(inputs);
+        for (const auto& dropped : plan.dropped) {
+            if (dropped.missing) {
+                return fail(NUKE_ERROR_NOT_FOUND, dropped.input + ": " + dropped.reason);
+            }
+        }
+
+        Safety safety(config->config);
+        for (const auto& root : plan.roots) {
+            if (auto reason = safety.check_root(root); !reason.empty()) {
+                return fail(NUKE_ERROR_UNSAFE_PATH, reason);
+            }
+        }
+
+        Scanner scanner(config->config);
+        scanner.set_one_file_system(options.one_file_system != 0);
+        scanner.set_estimate(options.estimate != 0);
+        if (options.min_size > 0 || options.max_size > 0) {
+            scanner.set_size_range(options.min_size,
+                                   options.max_size > 0 ? options.max_size : UINTMAX_MAX);
+        }
+        if (options.older_than_hours > 0) {
+            scanner.set_older_than(std::chrono::hours(options.older_than_hours));
+        }
+        if (options.time_budget_ms > 0) {
+            scanner.set_time_budget(std::chrono::milliseconds(options.time_budget_ms));
+        }
+
+        bool cancelled = false;
+        if (options.on_target) {
+            // The scanner serializes target callbacks
+            scanner.set_target_callback([&](const TargetEntry& target) {
+                if (cancelled) return;
+                std::string path = target.path.string();
+                nuke_target entry{};
+                fill_target(target, path.c_str(), target.project_type.c_str(), &entry);
+                if (options.on_target(&entry, options.on_target_user) != 0) {
+                    cancelled = true;
+                    scanner.cancel();
+                }
+            });
+        }
+
+        ProgressCounters counters;
+        scanner.set_progress_counters(&counters);
+
+        auto scan = std::make_unique<nuke_scan>();
+        {
+            ProgressTicker ticker(counters, options.on_progress, options.on_progress_user,
+                                  options.progress_interval_ms);
+            scan->result = scanner.scan(plan.roots, options.max_depth);
+        }
+
+        auto& targets = scan->result.targets;
+        scan->result.total_count = targets.size();
+        scan->paths.reserve(targets.size());
+        scan->types.reserve(targets.size());
+        for (const auto& target : targets) {
+            scan->paths.push_back(target.path.string());
+            scan->types.push_back(target.project_type);
+        }
+        CostModel cost_model;
+        cost_model.load();
+        scan->predicted_delete_ms =
+            static_cast<std::uint64_t>(cost_model.predict(targets).total.count());
+
+        *out = scan.release();
+        return cancelled ? fail(NUKE_ERROR_CANCELLED, "stopped by the target callback") : NUKE_OK;
+    });
+}
+
+void nuke_scan_destroy(nuke_scan* scan) {
+    delete scan;
+}
+
+size_t nuke_scan_count(const nuke_scan* scan) {
+    return scan ? scan->result.targets.size() : 0;
+}
+
+nuke_status nuke_scan_target(const nuke_scan* scan, size_t index, nuke_target* out) {
+    if (!scan || !out) return fail(NUKE_ERROR_INVALID_ARGUMENT, "missing scan or out");
+    if (index >= scan->result.targets.size()) {
+        return fail(NUKE_ERROR_INVALID_ARGUMENT, "index out of range");
+    }
+    fill_target(scan->result.targets[index], scan->paths[index].c_str(),
+                scan->types[index].c_str(), out);
+    return NUKE_OK;
+}
+
+uint64_t nuke_scan_total_size(const nuke_scan* scan) {
+    return scan ? scan->result.total_size : 0;
+}
+
+uint64_t nuke_scan_total_shared(const nuke_scan* scan) {
+    return scan ? scan->result.total_shared : 0;
+}
+
+uint64_t nuke_scan_predicted_delete_ms(const nuke_scan* scan) {
+    return scan ? scan->predicted_delete_ms : 0;
+}
+
+int nuke_scan_complete(const nuke_scan* scan) {
+    return scan && scan->result.complete ? 1 : 0;
+}
+
+// ============================================================================
+// Deleting
+// ============================================================================
+
+void nuke_delete_options_init(nuke_delete_options* options) {
+    if (!options) return;
+    *options = nuke_delete_options{};
+    options->struct_size = sizeof(nuke_delete_options);
+}
+
+nuke_status nuke_delete(const nuke_config* config, const nuke_scan* scan,
+                        const nuke_delete_options* given, nuke_deletion* out) {
+    if (!config || !scan || !out) return fail(NUKE_ERROR_INVALID_ARGUMENT, "missing argument");
+    *out = nuke_deletion{};
+    return guarded([&] {
+        auto options = read_options(given, nuke_delete_options_init);
+
+        std::vector<TargetEntry> targets = scan->result.targets;
+        auto rejected = Safety(config->config).validate(targets);
+
+        CostModel cost_model;
+        cost_model.load();
+
+        Destroyer destroyer(config->config);
+        ProgressCounters counters;
+        destroyer.set_progress_counters(&counters);
+        DeletionResult result;
+        {
+            ProgressTicker ticker(counters, options.on_progress, options.on_progress_user,
+                                  options.progress_interval_ms);
+            result = destroyer.destroy_all(targets);
+        }
+        if (cost_model.observe(result)) {
+            cost_model.save();
+        }
+        if (options.record_stats) {
+            Stats::instance().load();
+            Stats::instance().record_deletion(result, targets);
+        }
+
+        out->deleted = result.deleted_count;
+        out->failed = result.failed_count;
+        out->skipped = result.skipped_count + rejected.size();
+        out->freed_bytes = result.freed_bytes;
+        out->duration_ms = static_cast<std::uint64_t>(result.duration.count());
+
+        if (!rejected.empty()) {
+            return fail(NUKE_ERROR_INCOMPLETE, rejected.front().target.path.string() + ": " +
+                                               rejected.front().reason);
+        }
+        if (!result.errors.empty()) {
+            return fail(NUKE_ERROR_INCOMPLETE, result.errors.front());
+        }
+        if (!result.skipped.empty()) {
+            return fail(NUKE_ERROR_INCOMPLETE, result.skipped.front());
+        }
+        return NUKE_OK;
+    });
+}
+
+// ============================================================================
+// Statistics
+// ============================================================================
+
+nuke_status nuke_stats_get(nuke_stats* out) {
+    if (!out) return fail(NUKE_ERROR_INVALID_ARGUMENT, "out is NULL");
+    return guarded([&] {
+        static thread_local std::string rank;
+        Stats::instance().load();
+        const auto& stats = Stats::instance().get();
+        rank = rank_to_string(stats.current_rank);
+        out->total_bytes_deleted = stats.total_bytes_deleted;
+        out->total_files_deleted = stats.total_files_deleted;
+        out->rank = rank.c_str();
+        return NUKE_OK;
+    });
+}
+
+} // extern "C"
@@ -0,0 +1,230 @@
+#include "nuke/core/candidate_list.hpp"
+#include "nuke/ui/logger.hpp"
+#include <fmt/core.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace nuke {
+
+namespace {
+    // mlocate.db(5): the magic, a big-endian configuration block size, the
+    // format version (0), a visibility flag and two bytes of padding
+    constexpr char MLOCATE_MAGIC[8] = {'\0', 'm', 'l', 'o', 'c', 'a', 't', 'e'};
+    constexpr std::size_t READ_CHUNK = 64 * 1024;
+
+    // Entry types within a directory record
+    constexpr int Subdirectory = 1;
+    constexpr int EndOfDirectory = 2;
+
+    std::uint32_t read_be32(const unsigned char* bytes) {
+        return (std::uint32_t(bytes[0]) << 24) | (std::uint32_t(bytes[1]) << 16) |
+               (std::uint32_t(bytes[2]) << 8) | std::uint32_t(bytes[3]);
+    }
+
+    // Keeps paths named like a target; the name is checked before anything
+    // is built, since nearly every entry fails it
+    class Collector {
+    public:
+        Collector(const Config& config, CandidateList& out) : config_(config), out_(out) {}
+
+        void add(const std::string& dir, const std::string& name, bool directory) {
+            out_.entries++;
+            if (!directory || name.empty() || !config_.is_target(name)) return;
+            keep(fs::path(dir) / name);
+        }
+
+        void add(std::string line) {
+            out_.entries++;
+            while (!line.empty() && (line.back() == '\r' || line.back() == '/')) {
+                line.pop_back();
+            }
+            if (line.empty()) return;
+            fs::path path(line);
+            if (!config_.is_target(path.filename().string())) return;
+            keep(path);
+        }
+
+    private:
+        void keep(const fs::path& path) {
+            std::error_code ec;
+            auto absolute = fs::absolute(path, ec);
+            if (!ec) out_.targets.push_back(absolute.lexically_normal());
+        }
+
+        const Config& config_;
+        CandidateList& out_;
+    };
+
+    bool read_mlocate(std::istream& in, Collector& collector, const std::string& source) {
+        auto& logger = Logger::instance();
+
+        unsigned char header[16];
+        if (!in.read(reinterpret_cast<char*>(header), sizeof(header))) {
+            logger.error("Truncated mlocate database: " + source);
+            return false;
+        }
+        if (header[12] != 0) {
+            logger.error(fmt::format("Unsupported mlocate database version {}: {}", header[12], source));
+            return false;
+        }
+        std::string db_root;
+        std::getline(in, db_root, '\0');
+        in.ignore(read_be32(header + 8));
+        if (!in || in.eof()) {
+            logger.error("Truncated mlocate database: " + source);
+            return false;
+        }
+
+        // One record per directory: its time (seconds, nanoseconds, padding),
+        // its path, then its entries up to an end marker
+        unsigned char dir_header[16];
+        std::string dir;
+        std::string name;
+        while (in.read(reinterpret_cast<char*>(dir_header), sizeof(dir_header))) {
+            std::getline(in, dir, '\0');
+            for (;;) {
+                int type = in.get();
+                if (type == EOF) {
+                    logger.error("Truncated mlocate database: " + source);
+                    return false;
+                }
+                if (type == EndOfDirectory) break;
+                std::getline(in, name, '\0');
+                collector.add(dir, name, type == Subdirectory);
+            }
+        }
+        if (in.gcount() != 0) {
+            logger.error("Truncated mlocate database: " + source);
+            return false;
+        }
+        return true;
+    }
+
+    // The separator is NUL when the first chunk holding either has one
+    std::string read_listing(std::istream& in, Collector& collector) {
+        std::string pending;
+        std::vector<char> buffer(READ_CHUNK);
+        char separator = '\0';
+        bool decided = false;
+
+        auto drain = [&](bool last) {
+            std::size_t begin = 0;
+            for (std::size_t end; (end = pending.find(separator, begin)) != std::string::npos;
+                 begin = end + 1) {
+                collector.add(pending.substr(begin, end - begin));
+            }
+            pending.erase(0, begin);
+            if (last && !pending.empty()) {
+                collector.add(std::move(pending));
+                pending.clear();
+            }
+        };
+
+        while (in.read(buffer.data(), static_cast<std::streamsize>(buffer.size())) || in.gcount() > 0) {
+            pending.append(buffer.data(), static_cast<std::size_t>(in.gcount()));
+            if (!decided) {
+                if (pending.find('\0') != std::string::npos) {
+                    decided = true;
+                } else if (pending.find('\n') != std::string::npos) {
+                    separator = '\n';
+                    decided = true;
+                } else {
+                    continue;  // One long path so far
+                }
+            }
+            drain(false);
+        }
+        if (!decided) separator = '\n';
+        drain(true);
+        return separator == '\0' ? "NUL-separated list" : "line-separated list";
+    }
+}
+
+// ============================================================================
+// Reading
+// ============================================================================
+
+bool CandidateList::read(const std::string& source, const Config& config, CandidateList& out) {
+    out = CandidateList{};
+    Collector collector(config, out);
+
+    if (source == "-") {
+        out.format = read_listing(std::cin, collector);
+    } else {
+        std::ifstream file(fs::path(source), std::ios::binary);
+        if (!file) {
+            Logger::instance().error("Cannot read candidates from: " + source);
+            return false;
+        }
+        char magic[sizeof(MLOCATE_MAGIC)] = {};
+        file.read(magic, sizeof(magic));
+        if (file.gcount() == sizeof(magic) && std::memcmp(magic, MLOCATE_MAGIC, sizeof(magic)) == 0) {
+            file.seekg(0);
+            if (!read_mlocate(file, collector, source)) {
+                return false;
+            }
+            out.format = "mlocate database";
+        } else {
+            file.clear();
+            file.seekg(0);
+            out.format = read_listing(file, collector);
+        }
+    }
+
+    // Sorted by components, a target's descendants follow it directly; the
+    // walk never enters a target, so neither does the list
+    std::sort(out.targets.begin(), out.targets.end());
+    std::vector<fs::path> kept;
+    for (auto& target : out.targets) {
+        if (!kept.empty() && is_within(target, kept.back())) continue;
+        kept.push_back(std::move(target));
+    }
+    out.targets = std::move(kept);
+    return true;
+}
+
+// ============================================================================
+// Planning
+// ============================================================================
+
+fs::path CandidateList::common_root() const {
+    if (targets.empty()) {
+        return {};
+    }
+    fs::path root = targets.front().parent_path();
+    for (const auto& target : targets) {
+        auto parent = target.parent_path();
+        auto [root_end, parent_end] = std::mismatch(root.begin(), root.end(), parent.begin(), parent.end());
+        if (root_end == root.end()) continue;
+        fs::path shared;
+        for (auto it = root.begin(); it != root_end; ++it) {
+            shared /= *it;
+        }
+        root = std::move(shared);
+    }
+    return root;
+}
+
+ScanCheckpoint CandidateList::plan(const std::vector<fs::path>& roots, const Config& config) const {
+    ScanCheckpoint start;
+    start.roots = roots;
+    for (const auto& target : targets) {
+        auto root = std::find_if(roots.begin(), roots.end(),
+                                 [&target](const fs::path& r) { return is_within(target, r); });
+        if (root == roots.end()) continue;
+
+        auto relative = target.parent_path().lexically_relative(*root);
+        bool ignored = std::any_of(relative.begin(), relative.end(), [&config](const fs::path& part) {
+            return config.is_ignored(part.string());
+        });
+        if (!ignored) {
+            start.pending.push_back({ScanCheckpoint::Kind::Target, 0, target});
+        }
+    }
+    return start;
+}
+
+} // namespace nuke
@@ -0,0 +1,148 @@
+#include "nuke/core/checkpoint.hpp"
+#include <fstream>
+#include <sstream>
+
+namespace nuke {
+
+// Paths go last on the line; only the line break and the escape character
+// itself need escaping.
+std::string escape_path(const fs::path& path) {
+    auto u8 = path.u8string();
+    std::string out;
+    out.reserve(u8.size());
+    for (char8_t c : u8) {
+        if (c == u8'\\') out += "\\\\";
+        else if (c == u8'\n') out += "\\n";
+        else out += static_cast<char>(c);
+    }
+    return out;
+}
+
+fs::path unescape_path(const std::string& text) {
+    std::u8string out;
+    out.reserve(text.size());
+    for (std::size_t i = 0; i < text.size(); ++i) {
+        if (text[i] == '\\' && i + 1 < text.size()) {
+            ++i;
+            out += text[i] == 'n' ? u8'\n' : static_cast<char8_t>(text[i]);
+        } else {
+            out += static_cast<char8_t>(text[i]);
+        }
+    }
+    return fs::path(out);
+}
+
+namespace {
+    // 2: found= lines carry the shared (hardlinked) bytes after size_error
+    // 3: ... and then the target's device and inode
+    constexpr int FORMAT_VERSION = 3;
+    
+    const char* kind_key(ScanCheckpoint::Kind kind) {
+        return kind == ScanCheckpoint::Kind::Directory ? "dir" : "target";
+    }
+}
+
+bool ScanCheckpoint::load(const fs::path& path) {
+    if (!fs::exists(path)) {
+        return false;
+    }
+
+    std::ifstream file(path, std::ios::binary);
+    return file && read(file);
+}
+
+bool ScanCheckpoint::read(std::istream& in) {
+    try {
+        *this = ScanCheckpoint{};
+        int version = 1;
+        std::string line;
+        while (std::getline(in, line)) {
+            if (line.empty() || line[0] == '#') continue;
+
+            auto pos = line.find('=');
+            if (pos == std::string::npos) continue;
+
+            std::string key = line.substr(0, pos);
+            std::istringstream value(line.substr(pos + 1));
+
+            if (key == "version") {
+                value >> version;
+            } else if (key == "root") {
+                roots.push_back(unescape_path(line.substr(pos + 1)));
+            } else if (key == "max_depth") {
+                value >> max_depth;
+            } else if (key == "dir" || key == "target") {
+                Pending item;
+                item.kind = key == "dir" ? Kind::Directory : Kind::Target;
+                std::string text;
+                value >> item.depth;
+                value.ignore(1);
+                std::getline(value, text);
+                item.path = unescape_path(text);
+                pending.push_back(std::move(item));
+            } else if (key == "found") {
+                TargetEntry target;
+                long long ticks = 0;
+                std::string text;
+                value >> target.size >> target.size_error;
+                if (version >= 2) {
+                    value >> target.shared_size;
+                }
+                if (version >= 3) {
+                    value >> target.id.dev >> target.id.ino;
+                }
+                value >> ticks >> target.project_type >> target.file_count >> target.dir_count;
+                value.ignore(1);
+                std::getline(value, text);
+                target.last_modified = std::chrono::system_clock::time_point(
+                    std::chrono::system_clock::duration(ticks));
+                target.path = unescape_path(text);
+                found.push_back(std::move(target));
+            }
+        }
+        return !roots.empty();
+    } catch (...) {
+        return false;
+    }
+}
+
+bool ScanCheckpoint::save(const fs::path& path) const {
+    try {
+        if (path.has_parent_path()) {
+            fs::create_directories(path.parent_path());
+        }
+
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file) return false;
+
+        file << "# NUKE scan checkpoint (resume with --resume)\n";
+        return write(file);
+    } catch (...) {
+        return false;
+    }
+}
+
+bool ScanCheckpoint::write(std::ostream& file) const {
+    try {
+        file << "version=" << FORMAT_VERSION << "\n";
+        for (const auto& root : roots) {
+            file << "root=" << escape_path(root) << "\n";
+        }
+        file << "max_depth=" << max_depth << "\n";
+        for (const auto& item : pending) {
+            file << kind_key(item.kind) << "=" << item.depth << "\t" << escape_path(item.path) << "\n";
+        }
+        for (const auto& target : found) {
+            file << "found=" << target.size << "\t" << target.size_error << "\t"
+                 << target.shared_size << "\t" << target.id.dev << "\t" << target.id.ino << "\t"
+                 << target.last_modified.time_since_epoch().count() << "\t"
+                 << target.project_type << "\t" << target.file_count << "\t"
+                 << target.dir_count << "\t" << escape_path(target.path) << "\n";
+        }
+        return static_cast<bool>(file);
+    } catch (...) {
+        return false;
+    }
+}
+
+} // namespace nuke
@@ -0,0 +1,417 @@
+#include "nuke/core/concurrency.hpp"
+#include "nuke/ui/logger.hpp"
+#include "nuke/utils/profiler.hpp"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <sys/stat.h>
+#include <sys/statfs.h>
+#include <sys/sysmacros.h>
+#endif
+
+namespace nuke {
+
+namespace {
+    // Submitters block past this many queued tasks
+    constexpr std::size_t MAX_QUEUED = 4096;
+
+    // Latency thresholds relative to the best per-op latency seen
+    constexpr double GROW_BELOW = 1.5;
+    constexpr double SHRINK_ABOVE = 2.0;
+    constexpr double BASELINE_DRIFT = 0.02;
+    // A window needs this long and at least `limit` completions, so one
+    // tiny target cannot swing the limit on its own
+    constexpr auto MIN_WINDOW = std::chrono::milliseconds(50);
+
+#ifndef _WIN32
+    std::string read_line(const fs::path& path) {
+        std::ifstream file(path);
+        std::string line;
+        std::getline(file, line);
+        return line;
+    }
+
+    bool is_network_fs(const fs::path& path) {
+        struct statfs info {};
+        if (statfs(path.c_str(), &info) != 0) {
+            return false;
+        }
+        switch (static_cast<unsigned long>(info.f_type)) {
+            case 0x6969UL:      // NFS
+            case 0x517BUL:      // SMB
+            case 0xFF534D42UL:  // CIFS
+            case 0xFE534D42UL:  // SMB2
+            case 0x65735546UL:  // FUSE (sshfs, rclone, ...)
+            case 0x00C36400UL:  // Ceph
+            case 0x5346414FUL:  // AFS
+            case 0x01021997UL:  // 9p
+                return true;
+            default:
+                return false;
+        }
+    }
+#endif
+}
+
+// ============================================================================
+// ConcurrencyController
+// ============================================================================
+
+ConcurrencyController& ConcurrencyController::instance() {
+    static ConcurrencyController controller;
+    return controller;
+}
+
+void ConcurrencyController::configure(const Config& config) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    int pinned = std::max(config.scan_threads(), 0);
+    if (pinned == pinned_) return;
+
+    pinned_ = pinned;
+    for (auto& [device, state] : devices_) {
+        state.limit = pinned_ > 0 ? pinned_ : state.info.initial;
+    }
+    if (pinned_ > 0) {
+        NUKE_DIAG("Concurrency pinned to {} by scan_threads", pinned_);
+    }
+}
+
+std::uint64_t ConcurrencyController::device_of(const fs::path& path) {
+#ifdef _WIN32
+    std::error_code ec;
+    auto absolute = fs::absolute(path, ec);
+    return std::hash<fs::path::string_type>{}((ec ? path : absolute).root_name().native());
+#else
+    struct stat info {};
+    {
+        NUKE_PROFILE(Stat);
+        if (::stat(path.c_str(), &info) != 0) return 0;
+    }
+    return static_cast<std::uint64_t>(info.st_dev);
+#endif
+}
+
+unsigned int ConcurrencyController::cpu_quota() {
+    unsigned int cpus = std::max(std::thread::hardware_concurrency(), 1u);
+#ifndef _WIN32
+    // cgroup v2: "0::/some/group"; every level's cpu.max can cap us
+    std::ifstream cgroup("/proc/self/cgroup");
+    std::string line;
+    while (std::getline(cgroup, line)) {
+        if (line.rfind("0::", 0) != 0) continue;
+
+        const fs::path mount = "/sys/fs/cgroup";
+        fs::path group = mount / fs::path(line.substr(3)).relative_path();
+        for (;;) {
+            std::istringstream max(read_line(group / "cpu.max"));
+            std::string quota;
+            double period = 0;
+            if (max >> quota >> period && quota != "max" && period > 0) {
+                double limit = std::ceil(std::stod(quota) / period);
+                cpus = std::min(cpus, static_cast<unsigned int>(std::max(limit, 1.0)));
+            }
+            if (group == mount || !group.has_relative_path() || group.parent_path() == group) break;
+            group = group.parent_path();
+        }
+        break;
+    }
+#endif
+    return cpus;
+}
+
+DeviceKind ConcurrencyController::device_kind(const fs::path& path, std::uint64_t device) {
+#ifdef _WIN32
+    (void)device;
+    std::error_code ec;
+    auto root = fs::absolute(path, ec).root_path();
+    if (!ec && GetDriveTypeW(root.c_str()) == DRIVE_REMOTE) {
+        return DeviceKind::Network;
+    }
+    return DeviceKind::Unknown;
+#else
+    if (is_network_fs(path)) {
+        return DeviceKind::Network;
+    }
+
+    // Partitions have no queue/ of their own; their parent disk does
+    auto dev = static_cast<dev_t>(device);
+    fs::path block = fs::path("/sys/dev/block") / (std::to_string(major(dev)) + ":" +
+                                                   std::to_string(minor(dev)));
+    std::error_code ec;
+    auto resolved = fs::canonical(block, ec);
+    if (ec) {
+        return DeviceKind::Unknown;  // tmpfs, overlay and other anonymous devices
+    }
+    for (const auto& dir : {resolved, resolved.parent_path()}) {
+        auto rotational = read_line(dir / "queue" / "rotational");
+        if (rotational == "1") return DeviceKind::Rotational;
+        if (rotational == "0") return DeviceKind::SolidState;
+    }
+    return DeviceKind::Unknown;
+#endif
+}
+
+ConcurrencyController::DeviceInfo ConcurrencyController::seed(DeviceKind kind,
+                                                              unsigned int cpu_count) const {
+    int cpus = static_cast<int>(cpu_count);
+    DeviceInfo info;
+    switch (kind) {
+        case DeviceKind::Rotational:
+            info = {kind, 2, 1, 8};
+            break;
+        case DeviceKind::Network:
+            // Mostly waiting on round trips, so the CPU quota matters little
+            info = {kind, 16, 4, 128};
+            break;
+        case DeviceKind::SolidState:
+        case DeviceKind::Unknown:
+            info = {kind, std::max(cpus, 2), 1, std::clamp(cpus * 4, 8, 64)};
+            break;
+    }
+    return info;
+}
+
+int ConcurrencyController::limit(std::uint64_t device, const fs::path& sample) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = devices_.find(device);
+        if (it != devices_.end()) return it->second.limit;
+    }
+
+    // Probe outside the lock; sysfs reads are cheap but not free
+    unsigned int cpus = cpu_quota();
+    auto info = seed(device_kind(sample, device), cpus);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto [it, inserted] = devices_.try_emplace(device);
+    if (inserted) {
+        it->second.info = info;
+        it->second.limit = pinned_ > 0 ? pinned_ : info.initial;
+        it->second.window_start = std::chrono::steady_clock::now();
+        NUKE_DIAG("Device {:x} ({}): concurrency {} (range {}-{}, cpu quota {}){}", device,
+                  device_kind_to_string(info.kind), it->second.limit, info.min, info.max,
+                  cpus, pinned_ > 0 ? ", pinned" : "");
+    }
+    return it->second.limit;
+}
+
+int ConcurrencyController::limit(std::uint64_t device) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = devices_.find(device);
+    return it != devices_.end() ? it->second.limit : 1;
+}
+
+int ConcurrencyController::max_limit() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    int result = 1;
+    for (const auto& [device, state] : devices_) {
+        result = std::max(result, state.limit);
+    }
+    return result;
+}
+
+void ConcurrencyController::complete(std::uint64_t device, std::size_t ops,
+                                     std::chrono::nanoseconds elapsed, int in_flight) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = devices_.find(device);
+    if (it == devices_.end()) return;
+
+    Device& state = it->second;
+    state.completions++;
+    if (ops > 0) {
+        state.ops += ops;
+        state.busy_ns += static_cast<double>(elapsed.count());
+    }
+    if (in_flight >= state.limit) {
+        state.saturated = true;
+    }
+
+    if (pinned_ == 0 && state.completions >= static_cast<std::size_t>(std::max(state.limit, 4)) &&
+        std::chrono::steady_clock::now() - state.window_start >= MIN_WINDOW) {
+        adjust(device, state);
+    }
+}
+
+void ConcurrencyController::adjust(std::uint64_t device, Device& state) {
+    auto now = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(now - state.window_start).count();
+
+    if (state.ops > 0 && seconds > 0) {
+        double per_op = state.busy_ns / static_cast<double>(state.ops);
+        double rate = static_cast<double>(state.ops) / seconds;
+
+        if (state.baseline_ns == 0 || per_op < state.baseline_ns) {
+            state.baseline_ns = per_op;
+        } else {
+            // Let the baseline creep towards the present so one lucky window
+            // (everything in cache) cannot hold the limit down for good
+            state.baseline_ns += (per_op - state.baseline_ns) * BASELINE_DRIFT;
+        }
+
+        int previous = state.limit;
+        if (per_op > state.baseline_ns * SHRINK_ABOVE) {
+            state.limit = std::max(state.info.min, std::min(state.limit - 1, state.limit * 3 / 4));
+        } else if (state.saturated && per_op <= state.baseline_ns * GROW_BELOW &&
+                   rate >= state.previous_rate * 0.95) {
+            state.limit = std::min(state.info.max, state.limit + 1);
+        }
+
+        if (state.limit != previous) {
+            NUKE_DIAG("Device {:x}: concurrency {} -> {} ({:.1f}us/op, best {:.1f}us, {:.0f} ops/s)",
+                      device, previous, state.limit, per_op / 1000.0, state.baseline_ns / 1000.0,
+                      rate);
+        }
+        state.previous_rate = rate;
+    }
+
+    state.ops = 0;
+    state.completions = 0;
+    state.busy_ns = 0;
+    state.saturated = false;
+    state.window_start = now;
+}
+
+void ConcurrencyController::enter(std::uint64_t device) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = devices_.find(device);
+    if (it == devices_.end()) return;
+
+    Device& state = it->second;
+    if (state.pools++ > 0) return;
+    state.baseline_ns = 0;
+    state.previous_rate = 0;
+    state.ops = 0;
+    state.completions = 0;
+    state.busy_ns = 0;
+    state.saturated = false;
+    state.window_start = std::chrono::steady_clock::now();
+}
+
+void ConcurrencyController::leave(std::uint64_t device) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = devices_.find(device);
+    if (it != devices_.end() && it->second.pools > 0) {
+        it->second.pools--;
+    }
+}
+
+void ConcurrencyController::log_summary() const {
+    if (!Logger::instance().enabled(Verbosity::Diagnostic)) return;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& [device, state] : devices_) {
+        if (pinned_ > 0) {
+            NUKE_DIAG("Device {:x} ({}): pinned at concurrency {}", device,
+                      device_kind_to_string(state.info.kind), state.limit);
+        } else {
+            NUKE_DIAG("Device {:x} ({}): settled at concurrency {} (best {:.1f}us/op)", device,
+                      device_kind_to_string(state.info.kind), state.limit,
+                      state.baseline_ns / 1000.0);
+        }
+    }
+}
+
+// ============================================================================
+// TaskPool
+// ============================================================================
+
+TaskPool::TaskPool(ConcurrencyController& controller) : controller_(controller) {}
+
+TaskPool::~TaskPool() {
+    wait();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    work_cv_.notify_all();
+    for (auto& worker : workers_) {
+        if (worker.joinable()) worker.join();
+    }
+    for (auto device : entered_) {
+        controller_.leave(device);
+    }
+}
+
+void TaskPool::submit(const fs::path& path, Task task) {
+    submit(ConcurrencyController::device_of(path), path, std::move(task));
+}
+
+void TaskPool::submit(std::uint64_t device, const fs::path& path, Task task) {
+    controller_.limit(device, path);  // Registers and seeds a new device
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (std::find(entered_.begin(), entered_.end(), device) == entered_.end()) {
+        entered_.push_back(device);
+        controller_.enter(device);
+    }
+    done_cv_.wait(lock, [this] { return queue_.size() < MAX_QUEUED; });
+    queue_.push_back({device, std::move(task)});
+    maybe_spawn();
+    lock.unlock();
+    work_cv_.notify_one();
+}
+
+void TaskPool::wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_cv_.wait(lock, [this] { return queue_.empty() && running_ == 0; });
+}
+
+void TaskPool::maybe_spawn() {
+    // Only as many threads as the most generous device limit allows, and
+    // only while queued work outnumbers the threads free to take it
+    std::size_t free = workers_.size() - running_;
+    if (queue_.size() > free &&
+        workers_.size() < static_cast<std::size_t>(controller_.max_limit())) {
+        workers_.emplace_back([this] { worker_loop(); });
+    }
+}
+
+bool TaskPool::take(Entry& entry) {
+    for (auto it = queue_.begin(); it != queue_.end(); ++it) {
+        if (in_flight_[it->device] < controller_.limit(it->device)) {
+            entry = std::move(*it);
+            queue_.erase(it);
+            return true;
+        }
+    }
+    return false;
+}
+
+void TaskPool::worker_loop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        Entry entry;
+        work_cv_.wait(lock, [&] { return stopping_ || take(entry); });
+        if (!entry.task) return;  // Stopping with nothing taken
+
+        running_++;
+        int in_flight = ++in_flight_[entry.device];
+        lock.unlock();
+
+        std::size_t ops = 0;
+        auto start = std::chrono::steady_clock::now();
+        try {
+            ops = entry.task();
+        } catch (const std::exception& e) {
+            NUKE_DIAG("Task failed: {}", e.what());
+        } catch (...) {}
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        controller_.complete(entry.device, ops,
+                             std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed),
+                             in_flight);
+
+        lock.lock();
+        in_flight_[entry.device]--;
+        running_--;
+        maybe_spawn();  // The limit may have grown
+        work_cv_.notify_all();
+        done_cv_.notify_all();
+    }
+}
+
+} // namespace nuke
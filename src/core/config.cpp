@@ -2,7 +2,12 @@
 #include <yaml-cpp/yaml.h>
 #include <fstream>
 #include <algorithm>
+#include <cstdlib>
+
+#ifdef _WIN32
+#include <Windows.h>
 #include <ShlObj.h>
+#endif
 
 namespace nuke {
 
@@ -42,15 +47,45 @@ void Config::set_defaults() {
         "Program Files (x86)"
     };
     
+    // Pseudo filesystems, automounts and network shares
+    skip_filesystems_ = {
+        "proc", "sysfs", "devtmpfs", "devpts", "cgroup", "cgroup2", "securityfs",
+        "debugfs", "tracefs", "pstore", "bpf", "configfs", "fusectl", "mqueue",
+        "hugetlbfs", "binfmt_misc", "efivarfs", "autofs", "fuse.*",
+        "nfs", "nfs4", "cifs", "smb3"
+    };
+    
+    protected_paths_.clear();
+    
+    // Rewritten by each build or install, unlike the folder's own mtime
+    staleness_markers_ = {
+        {"target", {".rustc_info.json", "CACHEDIR.TAG", "../Cargo.lock"}},
+        {"node_modules", {".package-lock.json", ".yarn-state.yml", ".modules.yaml", ".yarn-integrity",
+                          "../package-lock.json", "../yarn.lock", "../pnpm-lock.yaml"}},
+        {".venv", {"pyvenv.cfg", "../poetry.lock", "../uv.lock", "../requirements.txt"}},
+        {"venv", {"pyvenv.cfg", "../poetry.lock", "../uv.lock", "../requirements.txt"}},
+        {".next", {"BUILD_ID"}},
+    };
+    staleness_depth_ = 2;
+    
     strategy_ = Strategy::OsFast;
-    scan_threads_ = 8;
+    scan_threads_ = 0;
 }
 
 fs::path Config::get_default_config_path() {
+#ifdef _WIN32
     char path[MAX_PATH];
     if (SUCCEEDED(SHGetFolderPathA(nullptr, CSIDL_APPDATA, nullptr, 0, path))) {
         return fs::path(path) / "nuke" / "config.yaml";
     }
+#else
+    if (const char* config = std::getenv("XDG_CONFIG_HOME"); config && *config) {
+        return fs::path(config) / "nuke" / "config.yaml";
+    }
+    if (const char* home = std::getenv("HOME"); home && *home) {
+        return fs::path(home) / ".config" / "nuke" / "config.yaml";
+    }
+#endif
     return fs::path("config.yaml");
 }
 
@@ -58,6 +93,14 @@ fs::path Config::get_stats_path() {
     return get_default_config_path().parent_path() / "stats.txt";
 }
 
+fs::path Config::get_checkpoint_path() {
+    return get_default_config_path().parent_path() / "scan.checkpoint";
+}
+
+fs::path Config::get_cost_model_path() {
+    return get_default_config_path().parent_path() / "delete_rates.txt";
+}
+
 bool Config::load(const fs::path& path) {
     if (!fs::exists(path)) {
         return false;
@@ -80,6 +123,64 @@ bool Config::load(const fs::path& path) {
             }
         }
         
+        if (config["skip_filesystems"]) {
+            skip_filesystems_.clear();
+            for (const auto& type : config["skip_filesystems"]) {
+                skip_filesystems_.push_back(type.as<std::string>());
+            }
+        }
+        
+        if (config["protected_paths"]) {
+            protected_paths_.clear();
+            for (const auto& path : config["protected_paths"]) {
+                protected_paths_.push_back(path.as<std::string>());
+            }
+        }
+        
+        if (config["quotas"]) {
+            quotas_.clear();
+            for (const auto& node : config["quotas"]) {
+                QuotaPolicy quota;
+                if (node["type"]) quota.project_type = node["type"].as<std::string>();
+                if (node["root"]) quota.root = node["root"].as<std::string>();
+                if (node["max_size"]) quota.max_size = node["max_size"].as<std::string>();
+                quotas_.push_back(std::move(quota));
+            }
+        }
+        
+        if (config["guard"]) {
+            guards_.clear();
+            for (const auto& node : config["guard"]) {
+                GuardPolicy guard;
+                if (node["mount"]) guard.mount = node["mount"].as<std::string>();
+                if (node["low"]) guard.low = node["low"].as<std::string>();
+                if (node["high"]) guard.high = node["high"].as<std::string>();
+                if (node["roots"]) {
+                    for (const auto& root : node["roots"]) {
+                        guard.roots.push_back(root.as<std::string>());
+                    }
+                }
+                guards_.push_back(std::move(guard));
+            }
+        }
+        
+        if (config["staleness"]) {
+            auto staleness = config["staleness"];
+            if (staleness["probe_depth"]) {
+                staleness_depth_ = staleness["probe_depth"].as<int>();
+            }
+            // Listed folders replace the built-in markers; others keep them
+            if (staleness["markers"]) {
+                for (const auto& entry : staleness["markers"]) {
+                    std::vector<std::string> markers;
+                    for (const auto& marker : entry.second) {
+                        markers.push_back(marker.as<std::string>());
+                    }
+                    staleness_markers_[entry.first.as<std::string>()] = std::move(markers);
+                }
+            }
+        }
+        
         if (config["settings"]) {
             auto settings = config["settings"];
             
@@ -125,6 +226,54 @@ bool Config::save(const fs::path& path) const {
         }
         out << YAML::EndSeq;
         
+        out << YAML::Key << "skip_filesystems" << YAML::Value << YAML::BeginSeq;
+        for (const auto& type : skip_filesystems_) {
+            out << type;
+        }
+        out << YAML::EndSeq;
+        
+        out << YAML::Key << "protected_paths" << YAML::Value << YAML::BeginSeq;
+        for (const auto& protected_path : protected_paths_) {
+            out << protected_path;
+        }
+        out << YAML::EndSeq;
+        
+        out << YAML::Key << "quotas" << YAML::Value << YAML::BeginSeq;
+        for (const auto& quota : quotas_) {
+            out << YAML::BeginMap;
+            if (!quota.project_type.empty()) out << YAML::Key << "type" << YAML::Value << quota.project_type;
+            if (!quota.root.empty()) out << YAML::Key << "root" << YAML::Value << quota.root;
+            out << YAML::Key << "max_size" << YAML::Value << quota.max_size;
+            out << YAML::EndMap;
+        }
+        out << YAML::EndSeq;
+        
+        out << YAML::Key << "guard" << YAML::Value << YAML::BeginSeq;
+        for (const auto& guard : guards_) {
+            out << YAML::BeginMap;
+            out << YAML::Key << "mount" << YAML::Value << guard.mount;
+            out << YAML::Key << "low" << YAML::Value << guard.low;
+            out << YAML::Key << "high" << YAML::Value << guard.high;
+            if (!guard.roots.empty()) {
+                out << YAML::Key << "roots" << YAML::Value << YAML::BeginSeq;
+                for (const auto& root : guard.roots) out << root;
+                out << YAML::EndSeq;
+            }
+            out << YAML::EndMap;
+        }
+        out << YAML::EndSeq;
+        
+        out << YAML::Key << "staleness" << YAML::Value << YAML::BeginMap;
+        out << YAML::Key << "probe_depth" << YAML::Value << staleness_depth_;
+        out << YAML::Key << "markers" << YAML::Value << YAML::BeginMap;
+        for (const auto& [target, markers] : staleness_markers_) {
+            out << YAML::Key << target << YAML::Value << YAML::Flow << YAML::BeginSeq;
+            for (const auto& marker : markers) out << marker;
+            out << YAML::EndSeq;
+        }
+        out << YAML::EndMap;
+        out << YAML::EndMap;
+        
         out << YAML::Key << "settings" << YAML::Value << YAML::BeginMap;
         out << YAML::Key << "strategy" << YAML::Value 
             << (strategy_ == Strategy::Native ? "native" : "os-fast");
@@ -149,4 +298,36 @@ bool Config::is_ignored(const std::string& name) const {
     return std::find(ignore_.begin(), ignore_.end(), name) != ignore_.end();
 }
 
+bool Config::is_skipped_filesystem(const std::string& fs_type) const {
+    return std::any_of(skip_filesystems_.begin(), skip_filesystems_.end(),
+                       [&fs_type](const std::string& pattern) {
+        if (!pattern.empty() && pattern.back() == '*') {
+            return fs_type.compare(0, pattern.size() - 1, pattern, 0, pattern.size() - 1) == 0;
+        }
+        return fs_type == pattern;
+    });
+}
+
+std::uint64_t Config::scan_fingerprint() const {
+    // Every value ends in a NUL and every list in a newline, so moving an
+    // entry from one list to the next changes the hash
+    std::uint64_t hash = fnv1a("nuke-scan-config\n");
+    auto add_list = [&hash](const std::vector<std::string>& values) {
+        for (const auto& value : values) {
+            hash = fnv1a(value, hash);
+            hash = fnv1a(std::string_view("\0", 1), hash);
+        }
+        hash = fnv1a("\n", hash);
+    };
+    add_list(targets_);
+    add_list(ignore_);
+    add_list(skip_filesystems_);
+    add_list(protected_paths_);
+    for (const auto& [target, markers] : staleness_markers_) {
+        hash = fnv1a(std::string_view("\0", 1), fnv1a(target, hash));
+        add_list(markers);
+    }
+    return fnv1a(std::to_string(staleness_depth_), hash);
+}
+
 } // namespace nuke
@@ -0,0 +1,184 @@
+#include "nuke/core/cost_model.hpp"
+#include "nuke/core/concurrency.hpp"
+#include "nuke/core/config.hpp"
+#include "nuke/ui/logger.hpp"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+namespace nuke {
+
+namespace {
+    // A deletion shorter than this is mostly pool start-up and the first
+    // cold directory reads; it would teach the model the wrong rate
+    constexpr std::size_t MIN_OPERATIONS = 2000;
+    constexpr auto MIN_ELAPSED = std::chrono::milliseconds(200);
+    // Later runs still count for at least this much, so the rate follows a
+    // disk that fills up or a host that gets busier
+    constexpr double MIN_WEIGHT = 0.25;
+
+    // Unlinks per second with the pool's usual concurrency, until measured
+    double initial_rate(DeviceKind kind) {
+        switch (kind) {
+            case DeviceKind::SolidState: return 20000.0;
+            case DeviceKind::Rotational: return 1500.0;
+            case DeviceKind::Network: return 300.0;
+            case DeviceKind::Unknown: return 5000.0;
+        }
+        return 5000.0;
+    }
+
+    std::chrono::milliseconds to_millis(double seconds) {
+        return std::chrono::milliseconds(static_cast<long long>(seconds * 1000.0 + 0.5));
+    }
+
+    std::uint64_t device_of(const TargetEntry& target) {
+        return target.id.known() ? target.id.dev : ConcurrencyController::device_of(target.path);
+    }
+}
+
+bool CostModel::load() {
+    auto path = Config::get_cost_model_path();
+    if (!fs::exists(path)) {
+        return false;
+    }
+
+    try {
+        std::ifstream file(path);
+        if (!file) return false;
+
+        std::string line;
+        while (std::getline(file, line)) {
+            if (line.empty() || line[0] == '#') continue;
+
+            // rate=<unlinks per second>\t<runs>\t<device>
+            if (line.rfind("rate=", 0) != 0) continue;
+            std::istringstream fields(line.substr(5));
+            Rate rate;
+            std::string device;
+            if (!(fields >> rate.ops_per_second >> rate.runs)) continue;
+            fields.ignore(1);
+            std::getline(fields, device);
+            if (device.empty() || rate.ops_per_second <= 0) continue;
+            rates_[device] = rate;
+        }
+        return true;
+    } catch (...) {
+        return false;
+    }
+}
+
+bool CostModel::save() const {
+    auto path = Config::get_cost_model_path();
+
+    try {
+        fs::create_directories(path.parent_path());
+
+        std::ofstream file(path);
+        if (!file) return false;
+
+        file << "# NUKE deletion rates (unlinks per second, runs, device)\n";
+        for (const auto& [device, rate] : rates_) {
+            if (rate.runs == 0) continue;  // Still the initial guess
+            file << "rate=" << static_cast<std::uint64_t>(rate.ops_per_second) << "\t"
+                 << rate.runs << "\t" << device << "\n";
+        }
+        return file.good();
+    } catch (...) {
+        return false;
+    }
+}
+
+std::string CostModel::device_key(std::uint64_t device, const fs::path& sample) {
+    auto known = keys_.find(device);
+    if (known != keys_.end()) {
+        return known->second;
+    }
+
+    std::string key;
+#ifdef _WIN32
+    std::error_code ec;
+    auto absolute = fs::absolute(sample, ec);
+    key = "drive " + (ec ? sample : absolute).root_name().string();
+#else
+    if (!mounts_loaded_) {
+        mounts_ = MountTable::load();
+        mounts_loaded_ = true;
+    }
+    const MountInfo* mount = mounts_.containing(sample);
+    if (mount && mount->dev == device) {
+        key = mount->fs_type + " " + mount->source;
+    } else {
+        std::ostringstream fallback;
+        fallback << "dev " << std::hex << device;
+        key = fallback.str();
+    }
+#endif
+    keys_.emplace(device, key);
+    return key;
+}
+
+CostModel::Rate& CostModel::rate_for(std::uint64_t device, const fs::path& sample) {
+    auto [it, inserted] = rates_.try_emplace(device_key(device, sample));
+    if (inserted) {
+        it->second.ops_per_second =
+            initial_rate(ConcurrencyController::device_kind(sample, device));
+    }
+    return it->second;
+}
+
+DeletionForecast CostModel::predict(const std::vector<TargetEntry>& targets) {
+    DeletionForecast forecast;
+    forecast.targets.reserve(targets.size());
+
+    std::unordered_map<std::uint64_t, double> device_seconds;
+    for (const auto& target : targets) {
+        std::uint64_t device = device_of(target);
+        const Rate& rate = rate_for(device, target.path);
+        if (rate.runs == 0) {
+            forecast.calibrated = false;
+        }
+
+        std::size_t ops = operations(target);
+        double seconds = static_cast<double>(ops) / rate.ops_per_second;
+        device_seconds[device] += seconds;
+        forecast.targets.push_back(to_millis(seconds));
+        forecast.operations += ops;
+    }
+
+    // Each device has its own workers, so the slowest one decides
+    double slowest = 0;
+    for (const auto& [device, seconds] : device_seconds) {
+        slowest = std::max(slowest, seconds);
+    }
+    forecast.total = to_millis(slowest);
+    return forecast;
+}
+
+bool CostModel::observe(const DeletionResult& result) {
+    bool learned = false;
+    for (const auto& timing : result.devices) {
+        if (timing.operations < MIN_OPERATIONS || timing.elapsed < MIN_ELAPSED) {
+            continue;
+        }
+
+        double observed = static_cast<double>(timing.operations) /
+                          std::chrono::duration<double>(timing.elapsed).count();
+        Rate& rate = rate_for(timing.device, timing.sample);
+        if (rate.runs == 0) {
+            rate.ops_per_second = observed;
+        } else {
+            double weight = std::max(MIN_WEIGHT, 1.0 / static_cast<double>(rate.runs + 1));
+            rate.ops_per_second = rate.ops_per_second * (1.0 - weight) + observed * weight;
+        }
+        rate.runs++;
+        learned = true;
+
+        NUKE_DIAG("Delete rate for {}: {:.0f}/s observed, now {:.0f}/s over {} run(s)",
+                  device_key(timing.device, timing.sample), observed, rate.ops_per_second,
+                  rate.runs);
+    }
+    return learned;
+}
+
+} // namespace nuke
@@ -1,13 +1,224 @@
 #include "nuke/core/destroyer.hpp"
+#include "nuke/core/concurrency.hpp"
 #include "nuke/ui/logger.hpp"
+#include "nuke/utils/profiler.hpp"
 #include <chrono>
 #include <cstdlib>
+#include <mutex>
+#include <unordered_map>
+
+#ifdef _WIN32
 #include <Windows.h>
+#else
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 namespace nuke {
 
+namespace {
+    // Depth-first removal equivalent to fs::remove_all, but with every
+    // unlink/rmdir issued individually so --profile can attribute them.
+    void remove_contents(const fs::path& dir, std::error_code& ec) {
+        fs::directory_iterator it;
+        {
+            NUKE_PROFILE(OpenDir);
+            it = fs::directory_iterator(dir, ec);
+        }
+        
+        while (!ec && it != fs::directory_iterator()) {
+            const auto& entry = *it;
+            // The link's own type: is_directory follows it, and a dangling
+            // link would fail with ENOENT
+            fs::file_status status = entry.symlink_status(ec);
+            if (ec) return;
+            if (fs::is_directory(status)) {
+                remove_contents(entry.path(), ec);
+                if (ec) return;
+                NUKE_PROFILE(Rmdir);
+                fs::remove(entry.path(), ec);
+            } else {
+                NUKE_PROFILE(Unlink);
+                fs::remove(entry.path(), ec);
+            }
+            if (ec) return;
+            
+            NUKE_PROFILE(ReadDir);
+            it.increment(ec);
+        }
+    }
+    
+    void remove_tree(const fs::path& path, std::error_code& ec) {
+        fs::file_status status;
+        {
+            NUKE_PROFILE(Stat);
+            status = fs::symlink_status(path, ec);
+        }
+        if (ec) return;
+        
+        if (fs::is_directory(status)) {
+            remove_contents(path, ec);
+            if (ec) return;
+            NUKE_PROFILE(Rmdir);
+            fs::remove(path, ec);
+        } else {
+            NUKE_PROFILE(Unlink);
+            fs::remove(path, ec);
+        }
+    }
+    
+#ifndef _WIN32
+    // Closes on scope exit
+    struct Fd {
+        int fd = -1;
+        explicit Fd(int value) : fd(value) {}
+        Fd(const Fd&) = delete;
+        Fd& operator=(const Fd&) = delete;
+        ~Fd() { if (fd >= 0) ::close(fd); }
+    };
+    
+    int open_directory_at(int dir_fd, const char* name) {
+        NUKE_PROFILE(OpenDir);
+        return ::openat(dir_fd, name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    }
+    
+    // remove_contents on an open directory: every name is resolved relative
+    // to its parent's fd, never as a path, so nothing swapped in mid-way
+    // (a symlink for a directory) is followed. Stays on `dev`: a mount
+    // point inside the target is an error, not something to empty.
+    void remove_contents_at(int dir_fd, dev_t dev, std::error_code& ec) {
+        int list_fd = ::dup(dir_fd);
+        DIR* raw = list_fd >= 0 ? ::fdopendir(list_fd) : nullptr;
+        if (!raw) {
+            ec.assign(errno, std::generic_category());
+            if (list_fd >= 0) ::close(list_fd);
+            return;
+        }
+        std::unique_ptr<DIR, int (*)(DIR*)> dir(raw, ::closedir);
+        
+        for (;;) {
+            struct dirent* entry;
+            {
+                NUKE_PROFILE(ReadDir);
+                errno = 0;
+                entry = ::readdir(raw);
+            }
+            if (!entry) {
+                if (errno != 0) ec.assign(errno, std::generic_category());
+                return;
+            }
+            const char* name = entry->d_name;
+            if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) continue;
+            
+            bool is_dir = entry->d_type == DT_DIR;
+            if (entry->d_type == DT_UNKNOWN) {
+                struct stat info {};
+                NUKE_PROFILE(Stat);
+                is_dir = ::fstatat(dir_fd, name, &info, AT_SYMLINK_NOFOLLOW) == 0 && S_ISDIR(info.st_mode);
+            }
+            
+            if (is_dir) {
+                Fd child(open_directory_at(dir_fd, name));
+                struct stat info {};
+                if (child.fd < 0 || ::fstat(child.fd, &info) != 0) {
+                    ec.assign(errno, std::generic_category());
+                    return;
+                }
+                if (info.st_dev != dev) {
+                    ec = std::make_error_code(std::errc::cross_device_link);
+                    return;
+                }
+                remove_contents_at(child.fd, dev, ec);
+                if (ec) return;
+                NUKE_PROFILE(Rmdir);
+                if (::unlinkat(dir_fd, name, AT_REMOVEDIR) != 0) {
+                    ec.assign(errno, std::generic_category());
+                    return;
+                }
+            } else {
+                NUKE_PROFILE(Unlink);
+                if (::unlinkat(dir_fd, name, 0) != 0) {
+                    ec.assign(errno, std::generic_category());
+                    return;
+                }
+            }
+        }
+    }
+    
+    // Opens the target relative to its parent's fd without following a
+    // symlink in its place, checks it is the directory the scan saw, then
+    // deletes everything through fds. Whatever a path component points at by
+    // now, only that same directory is ever emptied.
+    Destroyer::Outcome destroy_anchored(const TargetEntry& target, std::string& reason) {
+        using Outcome = Destroyer::Outcome;
+        NUKE_DIAG("Using fd-anchored deletion for: {}", target.path.string());
+        auto fail = [&reason](int error) {
+            reason = std::generic_category().message(error);
+            return Outcome::Failed;
+        };
+        
+        fs::path parent = target.path.parent_path();
+        fs::path name = target.path.filename();
+        if (name.empty() || name == "." || name == "..") {
+            reason = "not a directory name";
+            return Outcome::Skipped;
+        }
+        
+        int raw_parent;
+        {
+            NUKE_PROFILE(OpenDir);
+            raw_parent = ::open(parent.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        }
+        if (raw_parent < 0) {
+            return errno == ENOENT ? Outcome::Deleted : fail(errno);  // Already gone
+        }
+        Fd parent_fd(raw_parent);
+        
+        Fd dir(open_directory_at(parent_fd.fd, name.c_str()));
+        if (dir.fd < 0) {
+            if (errno == ENOENT) return Outcome::Deleted;
+            if (errno == ELOOP || errno == ENOTDIR) {
+                reason = "no longer a directory (replaced by a symlink or file)";
+                return Outcome::Skipped;
+            }
+            return fail(errno);
+        }
+        
+        struct stat info {};
+        {
+            NUKE_PROFILE(Stat);
+            if (::fstat(dir.fd, &info) != 0) return fail(errno);
+        }
+        FileId found{static_cast<std::uint64_t>(info.st_dev), static_cast<std::uint64_t>(info.st_ino)};
+        if (target.id.known() && !(found == target.id)) {
+            reason = "a different directory than the one scanned";
+            return Outcome::Skipped;
+        }
+        
+        std::error_code ec;
+        remove_contents_at(dir.fd, info.st_dev, ec);
+        if (ec) {
+            if (ec == std::errc::cross_device_link) {
+                reason = "holds a mount point";
+                return Outcome::Failed;
+            }
+            return fail(ec.value());
+        }
+        
+        NUKE_PROFILE(Rmdir);
+        if (::unlinkat(parent_fd.fd, name.c_str(), AT_REMOVEDIR) != 0) {
+            return fail(errno);
+        }
+        return Outcome::Deleted;
+    }
+#endif
+}
+
 Destroyer::Destroyer(const Config& config) : config_(config) {
     void_path_ = get_void_path();
+    ConcurrencyController::instance().configure(config);
 }
 
 fs::path Destroyer::get_void_path() {
@@ -18,6 +229,12 @@ fs::path Destroyer::get_void_path() {
 }
 
 bool Destroyer::ensure_void_directory() {
+    // Shared by every robocopy running in parallel; prepare it once
+    std::lock_guard<std::mutex> lock(void_mutex_);
+    if (void_ready_) {
+        return true;
+    }
+    
     try {
         if (!fs::exists(void_path_)) {
             fs::create_directories(void_path_);
@@ -25,6 +242,7 @@ bool Destroyer::ensure_void_directory() {
         for (const auto& entry : fs::directory_iterator(void_path_)) {
             fs::remove_all(entry.path());
         }
+        void_ready_ = true;
         return true;
     } catch (const fs::filesystem_error& e) {
         Logger::instance().error("Failed to create void directory: " + std::string(e.what()));
@@ -33,8 +251,11 @@ bool Destroyer::ensure_void_directory() {
 }
 
 bool Destroyer::destroy(const fs::path& path) {
-    if (!fs::exists(path)) {
-        return true;
+    {
+        NUKE_PROFILE(Stat);
+        if (!fs::exists(path)) {
+            return true;
+        }
     }
     
     if (config_.strategy() == Strategy::Native) {
@@ -48,25 +269,83 @@ DeletionResult Destroyer::destroy_all(const std::vector<TargetEntry>& targets) {
     DeletionResult result;
     auto start = std::chrono::high_resolution_clock::now();
     
-    for (std::size_t i = 0; i < targets.size(); ++i) {
-        const auto& target = targets[i];
-        
-        if (progress_cb_) {
-            progress_cb_(target.path, i + 1, targets.size());
-        }
-        
-        if (destroy(target.path)) {
-            result.deleted_count++;
-            result.freed_bytes += target.size;
-        } else {
-            result.failed_count++;
-            result.errors.push_back("Failed to delete: " + target.path.string());
-            
-            if (error_cb_) {
-                error_cb_(target.path, "Deletion failed");
+    // Targets are independent, so they are removed in parallel, as many at
+    // once as the controller allows for each device. Callbacks and the
+    // result are serialized.
+    std::mutex result_mutex;
+    std::size_t started = 0;
+    // Per device: when its first target started and its last one finished
+    struct Span {
+        std::chrono::steady_clock::time_point first;
+        std::chrono::steady_clock::time_point last;
+    };
+    std::unordered_map<std::uint64_t, std::size_t> device_index;
+    std::vector<Span> spans;
+    {
+        TaskPool pool;
+        for (const auto& target : targets) {
+            // The scan already knows the device; saves a stat per target
+            std::uint64_t device = target.id.known() ? target.id.dev
+                                                     : ConcurrencyController::device_of(target.path);
+            auto [slot, added] = device_index.try_emplace(device, result.devices.size());
+            if (added) {
+                result.devices.push_back({device, target.path});
+                spans.push_back({});
             }
+            std::size_t index = slot->second;
+            
+            auto task = [&, this, index]() -> std::size_t {
+                {
+                    std::lock_guard<std::mutex> lock(result_mutex);
+                    Span& span = spans[index];
+                    if (span.first == std::chrono::steady_clock::time_point{}) {
+                        span.first = std::chrono::steady_clock::now();
+                    }
+                    if (progress_cb_) {
+                        progress_cb_(target.path, ++started, targets.size());
+                    }
+                }
+                
+                std::string reason;
+                auto outcome = destroy_target(target, reason);
+                
+                std::lock_guard<std::mutex> lock(result_mutex);
+                spans[index].last = std::chrono::steady_clock::now();
+                if (outcome == Outcome::Skipped) {
+                    result.skipped_count++;
+                    result.skipped.push_back(target.path.string() + ": " + reason);
+                    return 1;
+                }
+                if (outcome == Outcome::Deleted) {
+                    result.deleted_count++;
+                    result.freed_bytes += target.exclusive_size();
+                    result.devices[index].operations += target.file_count + target.dir_count + 1;
+                    
+                    if (counters_) {
+                        counters_->items.fetch_add(1, std::memory_order_relaxed);
+                        counters_->bytes.fetch_add(target.exclusive_size(), std::memory_order_relaxed);
+                    }
+                } else {
+                    result.failed_count++;
+                    result.errors.push_back("Failed to delete: " + target.path.string() +
+                                            (reason.empty() ? "" : " (" + reason + ")"));
+                    
+                    if (error_cb_) {
+                        error_cb_(target.path, reason.empty() ? "Deletion failed" : reason);
+                    }
+                }
+                // One unlink per file and one rmdir per directory
+                return target.file_count + target.dir_count + 1;
+            };
+            pool.submit(device, target.path, std::move(task));
         }
+        pool.wait();
     }
+    for (std::size_t i = 0; i < spans.size(); ++i) {
+        result.devices[i].elapsed =
+            std::chrono::duration_cast<std::chrono::milliseconds>(spans[i].last - spans[i].first);
+    }
+    ConcurrencyController::instance().log_summary();
     
     auto end = std::chrono::high_resolution_clock::now();
     result.duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
@@ -74,27 +353,41 @@ DeletionResult Destroyer::destroy_all(const std::vector<TargetEntry>& targets) {
     return result;
 }
 
+Destroyer::Outcome Destroyer::destroy_target(const TargetEntry& target, std::string& reason) {
+#ifdef _WIN32
+    (void)reason;
+    return destroy(target.path) ? Outcome::Deleted : Outcome::Failed;
+#else
+    return destroy_anchored(target, reason);
+#endif
+}
+
 bool Destroyer::destroy_native(const fs::path& path) {
-    Logger::instance().diagnostic("Using native deletion for: " + path.string());
+    NUKE_DIAG("Using native deletion for: {}", path.string());
     
     try {
         std::error_code ec;
-        fs::remove_all(path, ec);
+        remove_tree(path, ec);
         
         if (ec) {
-            Logger::instance().diagnostic("Native deletion error: " + ec.message());
+            NUKE_DIAG("Native deletion error: {}", ec.message());
             return false;
         }
         return true;
     } catch (const fs::filesystem_error& e) {
-        Logger::instance().diagnostic("Native deletion exception: " + std::string(e.what()));
+        NUKE_DIAG("Native deletion exception: {}", e.what());
         return false;
     }
 }
 
 bool Destroyer::destroy_fast(const fs::path& path) {
-    Logger::instance().diagnostic("Using fast deletion (robocopy) for: " + path.string());
+#ifdef _WIN32
+    NUKE_DIAG("Using fast deletion (robocopy) for: {}", path.string());
     return destroy_robocopy(path);
+#else
+    // No robocopy here; the native walk is the fast path
+    return destroy_native(path);
+#endif
 }
 
 bool Destroyer::destroy_robocopy(const fs::path& path) {
@@ -104,26 +397,31 @@ bool Destroyer::destroy_robocopy(const fs::path& path) {
     // 3. Remove the now-empty target directory
     
     if (!ensure_void_directory()) {
-        Logger::instance().diagnostic("Falling back to native deletion");
+        NUKE_DIAG("Falling back to native deletion");
         return destroy_native(path);
     }
     
-    Logger::instance().diagnostic("Running robocopy void strategy");
+    NUKE_DIAG("Running robocopy void strategy");
     
     // Build command: robocopy /MIR /MT:128 /R:0 /W:0 /NFL /NDL /NJH /NJS /nc /ns /np
     std::string cmd = "robocopy \"" + void_path_.string() + "\" \"" + path.string() + 
                       "\" /MIR /MT:128 /R:0 /W:0 /NFL /NDL /NJH /NJS /nc /ns /np > NUL 2>&1";
     
-    int status = std::system(cmd.c_str());
+    int status;
+    {
+        NUKE_PROFILE(Spawn);
+        status = std::system(cmd.c_str());
+    }
     
     // Robocopy returns various codes, 0-7 are generally success
     if (status > 7) {
-        Logger::instance().diagnostic("Robocopy failed with status " + std::to_string(status));
+        NUKE_DIAG("Robocopy failed with status {}", status);
         return destroy_native(path);
     }
     
     // Now remove the empty directory
     try {
+        NUKE_PROFILE(Rmdir);
         fs::remove(path);
         return true;
     } catch (...) {
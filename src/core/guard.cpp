@@ -0,0 +1,369 @@
+#include "nuke/core/guard.hpp"
+#include "nuke/core/concurrency.hpp"
+#include "nuke/core/destroyer.hpp"
+#include "nuke/core/root_set.hpp"
+#include "nuke/core/scanner.hpp"
+#include "nuke/ui/logger.hpp"
+#include <fmt/core.h>
+#include <algorithm>
+#include <thread>
+
+namespace nuke {
+
+namespace {
+    // Sleeps are cut into slices this long so stop() takes effect promptly
+    constexpr auto STOP_CHECK = std::chrono::milliseconds(100);
+
+    long long days_since_epoch(std::chrono::system_clock::time_point tp) {
+        return std::chrono::duration_cast<std::chrono::hours>(tp.time_since_epoch()).count() / 24;
+    }
+
+    // Strict weak order with the first to delete last: oldest day wins, and
+    // the largest within a day
+    bool delete_later(const TargetEntry& a, const TargetEntry& b) {
+        auto day_a = days_since_epoch(a.recency());
+        auto day_b = days_since_epoch(b.recency());
+        return day_a != day_b ? day_a > day_b : a.size < b.size;
+    }
+}
+
+// ============================================================================
+// Watermark
+// ============================================================================
+
+std::optional<Watermark> Watermark::parse(const std::string& text) {
+    Watermark mark;
+    if (!text.empty() && text.back() == '%') {
+        try {
+            std::size_t pos = 0;
+            mark.percent = std::stod(text.substr(0, text.size() - 1), &pos);
+            if (pos != text.size() - 1 || mark.percent < 0 || mark.percent > 100) return std::nullopt;
+        } catch (...) {
+            return std::nullopt;
+        }
+        return mark;
+    }
+    auto bytes = parse_bytes(text);
+    if (!bytes) return std::nullopt;
+    mark.bytes = *bytes;
+    return mark;
+}
+
+std::uintmax_t Watermark::resolve(std::uintmax_t capacity) const {
+    if (percent > 0) {
+        return static_cast<std::uintmax_t>(static_cast<double>(capacity) * percent / 100.0);
+    }
+    return bytes;
+}
+
+// ============================================================================
+// DiskGuard
+// ============================================================================
+
+DiskGuard::DiskGuard(const Config& config, GuardOptions options)
+    : config_(config), options_(options), safety_(config) {
+    cost_model_.load();
+}
+
+DiskGuard::~DiskGuard() {
+    stop();
+}
+
+bool DiskGuard::configure(std::string& error) {
+    watches_.clear();
+    const auto& guards = config_.guards();
+    for (std::size_t i = 0; i < guards.size(); ++i) {
+        const auto& guard = guards[i];
+        Watch watch;
+        watch.label = guard.mount;
+
+        auto low = Watermark::parse(guard.low);
+        auto high = Watermark::parse(guard.high);
+        if (!low || !high) {
+            error = fmt::format("Guard {}: invalid watermark '{}' (use e.g. 10% or 20GB)", i + 1,
+                                low ? guard.high : guard.low);
+            return false;
+        }
+        watch.low = *low;
+        watch.high = *high;
+
+        std::error_code ec;
+        watch.mount = fs::weakly_canonical(fs::absolute(Safety::expand_home(guard.mount)), ec);
+        if (ec || guard.mount.empty() || !fs::exists(watch.mount, ec)) {
+            error = fmt::format("Guard {}: mount '{}' does not exist", i + 1, guard.mount);
+            return false;
+        }
+        auto space = fs::space(watch.mount, ec);
+        if (ec) {
+            error = fmt::format("Guard {}: cannot read free space on '{}'", i + 1, guard.mount);
+            return false;
+        }
+        if (watch.high.resolve(space.capacity) < watch.low.resolve(space.capacity)) {
+            error = fmt::format("Guard {}: high watermark is below the low one", i + 1);
+            return false;
+        }
+        watch.device = ConcurrencyController::device_of(watch.mount);
+
+        for (const auto& root : guard.roots.empty() ? std::vector<std::string>{guard.mount} : guard.roots) {
+            fs::path path = fs::weakly_canonical(fs::absolute(Safety::expand_home(root)), ec);
+            if (ec) {
+                error = fmt::format("Guard {}: cannot resolve root '{}'", i + 1, root);
+                return false;
+            }
+            if (auto reason = safety_.check_root(path); !reason.empty()) {
+                error = fmt::format("Guard {}: {}", i + 1, reason);
+                return false;
+            }
+            watch.roots.push_back(std::move(path));
+        }
+        watches_.push_back(std::move(watch));
+    }
+    return true;
+}
+
+void DiskGuard::refresh() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        deleted_.clear();
+    }
+
+    // One pass over every watch's roots; RootSet drops the nested ones
+    std::vector<std::string> inputs;
+    for (const auto& watch : watches_) {
+        for (const auto& root : watch.roots) inputs.push_back(root.string());
+    }
+    auto root_set = RootSet::plan(inputs);
+
+    Scanner scanner(config_);
+    {
+        std::lock_guard<std::mutex> lock(scanner_mutex_);
+        if (stopping_.load()) return;
+        scanner_ = &scanner;
+    }
+    auto result = scanner.scan(root_set.roots);
+    {
+        std::lock_guard<std::mutex> lock(scanner_mutex_);
+        scanner_ = nullptr;
+    }
+    if (!result.complete) {
+        return;  // Stopped; the old lists stay
+    }
+
+    for (const auto& rejection : safety_.validate(result.targets)) {
+        NUKE_DETAIL("Never a candidate: {}: {}", rejection.target.path.string(), rejection.reason);
+    }
+
+    // Only targets on the watched filesystem free space there
+    std::vector<std::vector<TargetEntry>> lists(watches_.size());
+    for (const auto& target : result.targets) {
+        for (std::size_t w = 0; w < watches_.size(); ++w) {
+            const auto& watch = watches_[w];
+            if (watch.device != 0 && target.id.known() && target.id.dev != watch.device) continue;
+            if (std::any_of(watch.roots.begin(), watch.roots.end(),
+                            [&target](const fs::path& root) { return is_within(target.path, root); })) {
+                lists[w].push_back(target);
+            }
+        }
+    }
+    for (auto& list : lists) {
+        std::sort(list.begin(), list.end(), delete_later);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (std::size_t w = 0; w < watches_.size(); ++w) {
+        auto& list = lists[w];
+        // Deleted while this scan ran
+        list.erase(std::remove_if(list.begin(), list.end(),
+                                  [this](const TargetEntry& target) {
+                                      return std::find(deleted_.begin(), deleted_.end(), target.path) !=
+                                             deleted_.end();
+                                  }),
+                   list.end());
+        std::uintmax_t bytes = 0;
+        for (const auto& target : list) bytes += target.exclusive_size();
+        NUKE_DETAIL("{}: {} candidates ({}) in {}ms", watches_[w].label, list.size(), format_bytes(bytes),
+                    result.scan_duration.count());
+        watches_[w].candidates = std::move(list);
+    }
+    deleted_.clear();
+    refreshed_ = true;
+    refreshes_++;
+}
+
+void DiskGuard::poll() {
+    auto& logger = Logger::instance();
+    for (auto& watch : watches_) {
+        std::error_code ec;
+        auto space = fs::space(watch.mount, ec);
+        if (ec) {
+            logger.warning("Cannot read free space on " + watch.label + ": " + ec.message());
+            continue;
+        }
+        auto low = watch.low.resolve(space.capacity);
+        auto high = watch.high.resolve(space.capacity);
+
+        if (space.available >= high) {
+            if (watch.pressed) {
+                logger.normal(fmt::format("{}: {} free, back above the high watermark", watch.label,
+                                          format_bytes(space.available)));
+            }
+            watch.pressed = false;
+            watch.rescan_after = 0;
+            watch.exhausted = false;
+            continue;
+        }
+        if (!watch.pressed && space.available >= low) {
+            continue;
+        }
+        if (!watch.pressed) {
+            logger.warning(fmt::format("{}: {} free, below the low watermark ({}); reclaiming up to {}",
+                                       watch.label, format_bytes(space.available), format_bytes(low),
+                                       format_bytes(high)));
+            watch.pressed = true;
+            reclaim(watch, space.available, high);
+        } else if (!options_.dry_run) {
+            // Still short after the last round (or filling again): keep going
+            reclaim(watch, space.available, high);
+        }
+    }
+}
+
+void DiskGuard::reclaim(Watch& watch, std::uintmax_t available, std::uintmax_t goal) {
+    auto& logger = Logger::instance();
+
+    // The bytes still needed, taken from the front of the list
+    std::vector<TargetEntry> batch;
+    bool rescan = false;
+    bool exhausted = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!refreshed_) {
+            logger.warning(watch.label + ": the first candidate scan is still running");
+            return;
+        }
+        std::uintmax_t planned = 0;
+        while (available + planned < goal && !watch.candidates.empty()) {
+            batch.push_back(std::move(watch.candidates.back()));
+            watch.candidates.pop_back();
+            planned += batch.back().exclusive_size();
+        }
+        if (options_.dry_run) {
+            // Nothing goes, so the same targets stay first in line
+            for (auto it = batch.rbegin(); it != batch.rend(); ++it) watch.candidates.push_back(*it);
+        }
+        // One rescan per pressure episode; a full disk with nothing left
+        // to delete must not keep the refresher walking back to back
+        if (batch.empty() && watch.rescan_after == 0) {
+            watch.rescan_after = refreshes_ + 1;
+            rescan = true;
+        } else if (batch.empty() && !watch.exhausted && refreshes_ >= watch.rescan_after) {
+            watch.exhausted = true;
+            exhausted = true;
+        }
+    }
+    if (rescan) {
+        logger.warning(watch.label + ": no candidates left; rescanning");
+        refresh_now_.store(true);
+    } else if (exhausted) {
+        logger.warning(watch.label + ": still below the high watermark with nothing left to delete; "
+                       "waiting for the next scheduled rescan");
+    }
+    if (batch.empty()) {
+        return;
+    }
+
+    // Configs and mounts can change between a refresh and now
+    for (const auto& rejection : safety_.validate(batch)) {
+        logger.warning("Skipping " + rejection.target.path.string() + ": " + rejection.reason);
+    }
+
+    std::uintmax_t planned = 0;
+    for (const auto& target : batch) planned += target.exclusive_size();
+    if (options_.dry_run) {
+        for (const auto& target : batch) {
+            logger.normal(fmt::format("  would delete {} ({}, last used {} ago)", target.path.string(),
+                                      format_bytes(target.exclusive_size()), format_age(target.recency())));
+        }
+        logger.normal(fmt::format("{}: would free {} in {} folders (dry run)", watch.label,
+                                  format_bytes(planned), batch.size()));
+        return;
+    }
+
+    Destroyer destroyer(config_);
+    auto result = destroyer.destroy_all(batch);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& target : batch) deleted_.push_back(target.path);
+    }
+    if (cost_model_.observe(result)) {
+        cost_model_.save();
+    }
+
+    logger.normal(fmt::format("{}: freed {} in {} folders ({}ms)", watch.label,
+                              format_bytes(result.freed_bytes), result.deleted_count,
+                              result.duration.count()));
+    for (const auto& error : result.errors) logger.warning(error);
+    for (const auto& skipped : result.skipped) NUKE_DETAIL("Skipped {}", skipped);
+}
+
+bool DiskGuard::sleep_for(std::chrono::milliseconds duration) {
+    auto until = std::chrono::steady_clock::now() + duration;
+    while (!stopping_.load()) {
+        auto now = std::chrono::steady_clock::now();
+        if (now >= until || refresh_now_.load()) return true;
+        std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(STOP_CHECK, until - now));
+    }
+    return false;
+}
+
+void DiskGuard::cancel_scan() {
+    std::lock_guard<std::mutex> lock(scanner_mutex_);
+    if (scanner_) {
+        scanner_->cancel();
+    }
+}
+
+void DiskGuard::run() {
+    // The scan runs beside the polls, so pressure is answered even while a
+    // slow refresh walks the roots
+    std::thread refresher([this] {
+        do {
+            refresh_now_.store(false);
+            refresh();
+        } while (sleep_for(options_.refresh));
+    });
+
+    while (!stopping_.load()) {
+        poll();
+        auto until = std::chrono::steady_clock::now() + options_.interval;
+        while (!stopping_.load() && std::chrono::steady_clock::now() < until) {
+            std::this_thread::sleep_for(STOP_CHECK);
+        }
+    }
+    cancel_scan();
+    refresher.join();
+}
+
+void DiskGuard::run_once() {
+    std::atomic<bool> scanned{false};
+    std::thread refresher([this, &scanned] {
+        refresh();
+        scanned.store(true);
+    });
+    while (!scanned.load()) {
+        if (stopping_.load()) cancel_scan();
+        std::this_thread::sleep_for(STOP_CHECK);
+    }
+    refresher.join();
+    if (!stopping_.load()) {
+        poll();
+    }
+}
+
+// Only the flag: a signal handler may not take locks, so the loops notice
+// it and cancel the scan themselves
+void DiskGuard::stop() {
+    stopping_.store(true);
+}
+
+} // namespace nuke
@@ -0,0 +1,113 @@
+#include "nuke/core/inode_set.hpp"
+
+namespace nuke {
+
+namespace {
+    constexpr std::size_t INITIAL_SLOTS = 1024;
+
+    // splitmix64 finalizer; inode numbers are dense, so mix them well
+    std::uint64_t mix(const FileId& id) {
+        std::uint64_t x = id.ino ^ (id.dev * 0x9e3779b97f4a7c15ULL);
+        x ^= x >> 30;
+        x *= 0xbf58476d1ce4e5b9ULL;
+        x ^= x >> 27;
+        x *= 0x94d049bb133111ebULL;
+        x ^= x >> 31;
+        return x;
+    }
+}
+
+bool InodeSet::insert(const FileId& id) {
+    if (!id.known()) return false;
+    // Keep the load under 3/4 so probe runs stay short
+    if ((size_ + 1) * 4 > slots_.size() * 3) {
+        grow();
+    }
+    std::size_t mask = slots_.size() - 1;
+    for (std::size_t i = mix(id) & mask;; i = (i + 1) & mask) {
+        if (!slots_[i].known()) {
+            slots_[i] = id;
+            size_++;
+            return true;
+        }
+        if (slots_[i] == id) return false;
+    }
+}
+
+bool InodeSet::contains(const FileId& id) const {
+    if (!id.known() || slots_.empty()) return false;
+    std::size_t mask = slots_.size() - 1;
+    for (std::size_t i = mix(id) & mask;; i = (i + 1) & mask) {
+        if (!slots_[i].known()) return false;
+        if (slots_[i] == id) return true;
+    }
+}
+
+void InodeSet::clear() {
+    slots_.clear();
+    size_ = 0;
+}
+
+void InodeSet::grow() {
+    std::vector<FileId> old = std::move(slots_);
+    slots_.assign(old.empty() ? INITIAL_SLOTS : old.size() * 2, FileId{});
+    std::size_t mask = slots_.size() - 1;
+    for (const auto& id : old) {
+        if (!id.known()) continue;
+        std::size_t i = mix(id) & mask;
+        while (slots_[i].known()) i = (i + 1) & mask;
+        slots_[i] = id;
+    }
+}
+
+// ============================================================================
+// LinkTracker
+// ============================================================================
+
+void LinkTracker::add(const FileId& id, std::uint32_t links, std::uint32_t seen,
+                      std::uintmax_t bytes) {
+    if (!id.known()) return;
+    auto hash = mix(id);
+    Stripe& stripe = stripes_[hash % STRIPES];
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+
+    if ((stripe.size + 1) * 4 > stripe.slots.size() * 3) {
+        std::vector<Entry> old = std::move(stripe.slots);
+        stripe.slots.assign(old.empty() ? INITIAL_SLOTS / 16 : old.size() * 2, Entry{});
+        std::size_t mask = stripe.slots.size() - 1;
+        for (const auto& entry : old) {
+            if (!entry.id.known()) continue;
+            std::size_t i = (mix(entry.id) / STRIPES) & mask;
+            while (stripe.slots[i].id.known()) i = (i + 1) & mask;
+            stripe.slots[i] = entry;
+        }
+    }
+
+    std::size_t mask = stripe.slots.size() - 1;
+    for (std::size_t i = (hash / STRIPES) & mask;; i = (i + 1) & mask) {
+        Entry& entry = stripe.slots[i];
+        if (!entry.id.known()) {
+            entry = {id, links, seen, bytes};
+            stripe.size++;
+            return;
+        }
+        if (entry.id == id) {
+            entry.seen += seen;
+            return;
+        }
+    }
+}
+
+LinkTracker::Totals LinkTracker::totals() const {
+    Totals totals;
+    for (const auto& stripe : stripes_) {
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+        for (const auto& entry : stripe.slots) {
+            if (!entry.id.known()) continue;
+            (entry.seen >= entry.links ? totals.covered : totals.uncovered) += entry.bytes;
+        }
+    }
+    return totals;
+}
+
+} // namespace nuke
@@ -0,0 +1,100 @@
+#include "nuke/core/mount_table.hpp"
+#include "nuke/ui/logger.hpp"
+#include <fstream>
+#include <sstream>
+
+#ifndef _WIN32
+#include <sys/sysmacros.h>
+#endif
+
+namespace nuke {
+
+namespace {
+    // mountinfo writes space, tab, newline and backslash as \ooo
+    std::string unescape_octal(const std::string& text) {
+        std::string out;
+        out.reserve(text.size());
+        for (std::size_t i = 0; i < text.size(); ++i) {
+            if (text[i] == '\\' && i + 3 < text.size() &&
+                text[i + 1] >= '0' && text[i + 1] <= '3' &&
+                text[i + 2] >= '0' && text[i + 2] <= '7' &&
+                text[i + 3] >= '0' && text[i + 3] <= '7') {
+                out += static_cast<char>((text[i + 1] - '0') * 64 + (text[i + 2] - '0') * 8 +
+                                         (text[i + 3] - '0'));
+                i += 3;
+            } else {
+                out += text[i];
+            }
+        }
+        return out;
+    }
+}
+
+MountTable MountTable::load() {
+#ifdef _WIN32
+    return {};
+#else
+    std::ifstream file("/proc/self/mountinfo");
+    if (!file) {
+        NUKE_DIAG("No /proc/self/mountinfo; mount points are not recognized");
+        return {};
+    }
+    auto table = parse(file);
+    NUKE_DIAG("Mount table: {} mounts", table.mounts_.size());
+    return table;
+#endif
+}
+
+MountTable MountTable::parse(std::istream& in) {
+    MountTable table;
+    std::string line;
+    while (std::getline(in, line)) {
+        // id parent major:minor root mount_point options [optional...] - type source super
+        std::istringstream fields(line);
+        std::string id, parent, devno, root, mount_point, options, field;
+        if (!(fields >> id >> parent >> devno >> root >> mount_point >> options)) continue;
+        while (fields >> field && field != "-") {}
+
+        MountInfo mount;
+        if (!(fields >> mount.fs_type)) continue;
+        fields >> mount.source;
+
+        auto colon = devno.find(':');
+        if (colon == std::string::npos) continue;
+        try {
+            auto major = std::stoul(devno.substr(0, colon));
+            auto minor = std::stoul(devno.substr(colon + 1));
+#ifdef _WIN32
+            mount.dev = (static_cast<std::uint64_t>(major) << 32) | minor;
+#else
+            mount.dev = static_cast<std::uint64_t>(makedev(major, minor));
+#endif
+        } catch (...) {
+            continue;
+        }
+        mount.mount_point = fs::path(unescape_octal(mount_point));
+        mount.fs_root = fs::path(unescape_octal(root));
+        mount.source = unescape_octal(mount.source);
+
+        // Later lines are mounted on top of earlier ones at the same path
+        table.by_path_[mount.mount_point.native()] = table.mounts_.size();
+        table.mounts_.push_back(std::move(mount));
+    }
+    return table;
+}
+
+const MountInfo* MountTable::find(const fs::path& mount_point) const {
+    if (by_path_.empty()) return nullptr;
+    auto it = by_path_.find(mount_point.native());
+    return it != by_path_.end() ? &mounts_[it->second] : nullptr;
+}
+
+const MountInfo* MountTable::containing(const fs::path& path) const {
+    if (by_path_.empty()) return nullptr;
+    for (fs::path dir = path;; dir = dir.parent_path()) {
+        if (auto* mount = find(dir)) return mount;
+        if (!dir.has_relative_path()) return nullptr;
+    }
+}
+
+} // namespace nuke
@@ -0,0 +1,319 @@
+#include "nuke/core/protocol.hpp"
+#include <cerrno>
+#include <cstring>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace nuke {
+namespace protocol {
+
+// ============================================================================
+// Writer / Reader
+// ============================================================================
+void Writer::u16(std::uint16_t value) {
+    for (int i = 0; i < 2; ++i) u8(static_cast<std::uint8_t>(value >> (8 * i)));
+}
+
+void Writer::u32(std::uint32_t value) {
+    for (int i = 0; i < 4; ++i) u8(static_cast<std::uint8_t>(value >> (8 * i)));
+}
+
+void Writer::u64(std::uint64_t value) {
+    for (int i = 0; i < 8; ++i) u8(static_cast<std::uint8_t>(value >> (8 * i)));
+}
+
+void Writer::str(std::string_view value) {
+    u32(static_cast<std::uint32_t>(value.size()));
+    data_.append(value);
+}
+
+void Writer::path(const fs::path& value) {
+    auto u8 = value.u8string();
+    str(std::string_view(reinterpret_cast<const char*>(u8.data()), u8.size()));
+}
+
+bool Reader::take(std::size_t n) {
+    if (!ok_ || data_.size() - pos_ < n) {
+        ok_ = false;
+        return false;
+    }
+    return true;
+}
+
+std::uint8_t Reader::u8() {
+    if (!take(1)) return 0;
+    return static_cast<std::uint8_t>(data_[pos_++]);
+}
+
+std::uint16_t Reader::u16() {
+    std::uint16_t value = 0;
+    for (int i = 0; i < 2; ++i) value |= static_cast<std::uint16_t>(u8()) << (8 * i);
+    return value;
+}
+
+std::uint32_t Reader::u32() {
+    std::uint32_t value = 0;
+    for (int i = 0; i < 4; ++i) value |= static_cast<std::uint32_t>(u8()) << (8 * i);
+    return value;
+}
+
+std::uint64_t Reader::u64() {
+    std::uint64_t value = 0;
+    for (int i = 0; i < 8; ++i) value |= static_cast<std::uint64_t>(u8()) << (8 * i);
+    return value;
+}
+
+std::string Reader::str() {
+    std::uint32_t size = u32();
+    if (!take(size)) return {};
+    std::string value(data_.substr(pos_, size));
+    pos_ += size;
+    return value;
+}
+
+fs::path Reader::path() {
+    auto text = str();
+    return fs::path(std::u8string(text.begin(), text.end()));
+}
+
+// ============================================================================
+// Frames
+// ============================================================================
+void append_frame(std::string& out, MessageType type, const std::string& payload) {
+    Writer header;
+    header.u32(static_cast<std::uint32_t>(payload.size()));
+    header.u8(static_cast<std::uint8_t>(type));
+    out += header.data();
+    out += payload;
+}
+
+bool write_frame(int fd, MessageType type, const std::string& payload) {
+    if (payload.size() > MAX_FRAME) return false;
+
+    std::string frame;
+    frame.reserve(payload.size() + 5);
+    append_frame(frame, type, payload);
+    return write_all(fd, frame);
+}
+
+#ifdef _WIN32
+
+bool write_all(int, const std::string&) {
+    return false;
+}
+
+bool read_frame(int, MessageType&, std::string&) {
+    return false;
+}
+
+#else
+
+namespace {
+    bool send_all(int fd, const char* data, std::size_t size) {
+        while (size > 0) {
+            ssize_t n = ::send(fd, data, size, MSG_NOSIGNAL);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            data += n;
+            size -= static_cast<std::size_t>(n);
+        }
+        return true;
+    }
+
+    bool recv_all(int fd, char* data, std::size_t size) {
+        while (size > 0) {
+            ssize_t n = ::recv(fd, data, size, 0);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            data += n;
+            size -= static_cast<std::size_t>(n);
+        }
+        return true;
+    }
+}
+
+bool write_all(int fd, const std::string& data) {
+    return send_all(fd, data.data(), data.size());
+}
+
+bool read_frame(int fd, MessageType& type, std::string& payload) {
+    char header[5];
+    if (!recv_all(fd, header, sizeof(header))) return false;
+
+    Reader in(std::string_view(header, sizeof(header)));
+    std::uint32_t size = in.u32();
+    type = static_cast<MessageType>(in.u8());
+    if (size > MAX_FRAME) return false;
+
+    payload.resize(size);
+    return recv_all(fd, payload.data(), size);
+}
+
+#endif
+
+} // namespace protocol
+
+// ============================================================================
+// Messages
+// ============================================================================
+namespace {
+    std::int64_t to_nanoseconds(std::chrono::system_clock::time_point tp) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(tp.time_since_epoch()).count();
+    }
+
+    std::chrono::system_clock::time_point from_nanoseconds(std::int64_t ns) {
+        return std::chrono::system_clock::time_point(
+            std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(ns)));
+    }
+
+    void encode_strings(protocol::Writer& out, const std::vector<std::string>& values) {
+        out.u32(static_cast<std::uint32_t>(values.size()));
+        for (const auto& value : values) out.str(value);
+    }
+
+    bool decode_strings(protocol::Reader& in, std::vector<std::string>& values) {
+        std::uint32_t count = in.u32();
+        values.clear();
+        for (std::uint32_t i = 0; i < count && in.ok(); ++i) {
+            values.push_back(in.str());
+        }
+        return in.ok();
+    }
+}
+
+std::string ScanRequest::key() const {
+    protocol::Writer out;
+    encode(out);
+    std::string key = out.data();
+    // fresh only decides whether a cached result may answer, not what the
+    // walk produces
+    key.erase(0, 1);
+    return key;
+}
+
+void ScanRequest::encode(protocol::Writer& out) const {
+    out.u8(fresh ? 1 : 0);
+    out.u64(config);
+    out.u8(static_cast<std::uint8_t>((one_file_system ? 1 : 0) | (estimate ? 2 : 0)));
+    out.u32(static_cast<std::uint32_t>(max_depth));
+    out.u64(min_bytes);
+    out.u64(max_bytes);
+    out.u64(top);
+    out.u32(older_than_hours);
+    out.u32(static_cast<std::uint32_t>(roots.size()));
+    for (const auto& root : roots) out.path(root);
+}
+
+bool ScanRequest::decode(protocol::Reader& in) {
+    fresh = in.u8() != 0;
+    config = in.u64();
+    std::uint8_t flags = in.u8();
+    one_file_system = (flags & 1) != 0;
+    estimate = (flags & 2) != 0;
+    max_depth = static_cast<std::int32_t>(in.u32());
+    min_bytes = in.u64();
+    max_bytes = in.u64();
+    top = in.u64();
+    older_than_hours = in.u32();
+    std::uint32_t count = in.u32();
+    roots.clear();
+    for (std::uint32_t i = 0; i < count && in.ok(); ++i) {
+        roots.push_back(in.path());
+    }
+    return in.ok();
+}
+
+void encode_target(protocol::Writer& out, const TargetEntry& target) {
+    out.path(target.path);
+    out.str(target.project_type);
+    out.u64(target.size);
+    out.u64(target.shared_size);
+    out.u64(target.size_error);
+    out.u64(target.file_count);
+    out.u64(target.dir_count);
+    out.i64(to_nanoseconds(target.last_modified));
+    out.i64(to_nanoseconds(target.last_used));
+    out.u64(target.id.dev);
+    out.u64(target.id.ino);
+}
+
+bool decode_target(protocol::Reader& in, TargetEntry& target) {
+    target.path = in.path();
+    target.project_type = in.str();
+    target.size = in.u64();
+    target.shared_size = in.u64();
+    target.size_error = in.u64();
+    target.file_count = static_cast<std::size_t>(in.u64());
+    target.dir_count = static_cast<std::size_t>(in.u64());
+    target.last_modified = from_nanoseconds(in.i64());
+    target.last_used = from_nanoseconds(in.i64());
+    target.id.dev = in.u64();
+    target.id.ino = in.u64();
+    return in.ok();
+}
+
+void encode_scan_summary(protocol::Writer& out, const ScanResult& result, bool cached, bool shared) {
+    out.u8(static_cast<std::uint8_t>((result.complete ? 1 : 0) | (result.estimated ? 2 : 0) |
+                                     (cached ? 4 : 0) | (shared ? 8 : 0)));
+    out.u64(result.total_size);
+    out.u64(result.total_shared);
+    out.u64(result.total_size_error);
+    out.u64(result.total_count);
+    out.u64(static_cast<std::uint64_t>(result.scan_duration.count()));
+    out.u32(static_cast<std::uint32_t>(result.roots.size()));
+    for (const auto& root : result.roots) {
+        out.path(root.root);
+        out.u64(root.total_size);
+        out.u64(root.total_count);
+    }
+}
+
+bool decode_scan_summary(protocol::Reader& in, ScanReply& reply) {
+    auto& result = reply.result;
+    std::uint8_t flags = in.u8();
+    result.complete = (flags & 1) != 0;
+    result.estimated = (flags & 2) != 0;
+    reply.cached = (flags & 4) != 0;
+    reply.shared = (flags & 8) != 0;
+    result.total_size = in.u64();
+    result.total_shared = in.u64();
+    result.total_size_error = in.u64();
+    result.total_count = static_cast<std::size_t>(in.u64());
+    result.scan_duration = std::chrono::milliseconds(in.u64());
+    std::uint32_t count = in.u32();
+    result.roots.clear();
+    for (std::uint32_t i = 0; i < count && in.ok(); ++i) {
+        RootTotal root;
+        root.root = in.path();
+        root.total_size = in.u64();
+        root.total_count = static_cast<std::size_t>(in.u64());
+        result.roots.push_back(std::move(root));
+    }
+    return in.ok();
+}
+
+void encode_deletion(protocol::Writer& out, const DeletionResult& result) {
+    out.u64(result.deleted_count);
+    out.u64(result.failed_count);
+    out.u64(result.skipped_count);
+    out.u64(result.freed_bytes);
+    out.u64(static_cast<std::uint64_t>(result.duration.count()));
+    encode_strings(out, result.errors);
+    encode_strings(out, result.skipped);
+}
+
+bool decode_deletion(protocol::Reader& in, DeletionResult& result) {
+    result.deleted_count = static_cast<std::size_t>(in.u64());
+    result.failed_count = static_cast<std::size_t>(in.u64());
+    result.skipped_count = static_cast<std::size_t>(in.u64());
+    result.freed_bytes = in.u64();
+    result.duration = std::chrono::milliseconds(in.u64());
+    return decode_strings(in, result.errors) && decode_strings(in, result.skipped);
+}
+
+} // namespace nuke
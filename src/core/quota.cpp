@@ -0,0 +1,121 @@
+#include "nuke/core/quota.hpp"
+#include "nuke/utils/safety.hpp"
+#include <fmt/core.h>
+#include <algorithm>
+#include <numeric>
+
+namespace nuke {
+
+// ============================================================================
+// Quota Budgets
+// ============================================================================
+
+bool QuotaBudget::covers(const TargetEntry& target) const {
+    if (type && string_to_project_type(target.project_type) != *type) {
+        return false;
+    }
+    return root.empty() || is_within(target.path, root);
+}
+
+bool QuotaBudget::from_config(const std::vector<QuotaPolicy>& policies, std::vector<QuotaBudget>& out,
+                              std::string& error) {
+    out.clear();
+    for (std::size_t i = 0; i < policies.size(); ++i) {
+        const auto& policy = policies[i];
+        QuotaBudget budget;
+
+        auto max_bytes = policy.max_size.empty() ? std::nullopt : parse_bytes(policy.max_size);
+        if (!max_bytes) {
+            error = fmt::format("Quota {}: invalid max_size '{}'", i + 1, policy.max_size);
+            return false;
+        }
+        budget.max_bytes = *max_bytes;
+
+        if (!policy.project_type.empty()) {
+            auto type = string_to_project_type(policy.project_type);
+            if (type == ProjectType::Unknown && policy.project_type != "unknown") {
+                error = fmt::format("Quota {}: unknown type '{}' (node, rust, python, dotnet, generic)",
+                                    i + 1, policy.project_type);
+                return false;
+            }
+            budget.type = type;
+        }
+
+        if (!policy.root.empty()) {
+            std::error_code ec;
+            budget.root = fs::weakly_canonical(fs::absolute(Safety::expand_home(policy.root)), ec);
+            if (ec) {
+                error = fmt::format("Quota {}: cannot resolve root '{}'", i + 1, policy.root);
+                return false;
+            }
+        }
+
+        budget.label = policy.project_type.empty() ? "all types" : policy.project_type;
+        if (!policy.root.empty()) {
+            budget.label += " under " + policy.root;
+        }
+        out.push_back(std::move(budget));
+    }
+    return true;
+}
+
+// ============================================================================
+// Eviction Plan
+// ============================================================================
+
+QuotaPlan plan_evictions(const std::vector<QuotaBudget>& budgets,
+                         const std::vector<TargetEntry>& targets) {
+    QuotaPlan plan;
+
+    std::vector<std::uint32_t> lru(targets.size());
+    std::iota(lru.begin(), lru.end(), 0u);
+    std::sort(lru.begin(), lru.end(), [&targets](std::uint32_t a, std::uint32_t b) {
+        auto ra = targets[a].recency();
+        auto rb = targets[b].recency();
+        return ra != rb ? ra < rb : targets[a].size > targets[b].size;
+    });
+
+    std::vector<bool> evicted(targets.size(), false);
+    std::vector<bool> covered(targets.size(), false);
+
+    for (const auto& budget : budgets) {
+        std::uintmax_t remaining = 0;
+        for (std::size_t i = 0; i < targets.size(); ++i) {
+            covered[i] = budget.covers(targets[i]);
+            if (covered[i] && !evicted[i]) remaining += targets[i].size;
+        }
+        for (auto i : lru) {
+            if (remaining <= budget.max_bytes) break;
+            if (evicted[i] || !covered[i]) continue;
+            evicted[i] = true;
+            remaining -= targets[i].size;
+        }
+    }
+
+    // Reported once everything is settled: a later budget's evictions can
+    // also relieve an earlier one
+    for (const auto& budget : budgets) {
+        QuotaUsage usage;
+        usage.budget = &budget;
+        for (std::size_t i = 0; i < targets.size(); ++i) {
+            if (!budget.covers(targets[i])) continue;
+            usage.targets++;
+            usage.used_bytes += targets[i].size;
+            if (evicted[i]) {
+                usage.evicted++;
+                usage.evicted_bytes += targets[i].size;
+            }
+        }
+        plan.usage.push_back(usage);
+    }
+
+    // One list, least recently used first, whichever budget chose it
+    for (auto i : lru) {
+        if (!evicted[i]) continue;
+        plan.evict.push_back(targets[i]);
+        plan.evict_bytes += targets[i].size;
+    }
+    return plan;
+}
+
+} // namespace nuke
@@ -0,0 +1,127 @@
+#include "nuke/core/root_set.hpp"
+#include "nuke/ui/logger.hpp"
+#include "nuke/utils/profiler.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <utility>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <sys/stat.h>
+#endif
+
+namespace nuke {
+
+namespace {
+    // The volume serial and file index on Windows
+    std::optional<FileId> file_identity(const fs::path& path) {
+        NUKE_PROFILE(Stat);
+#ifdef _WIN32
+        HANDLE handle = CreateFileW(path.c_str(), 0,
+                                    FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                    nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, nullptr);
+        if (handle == INVALID_HANDLE_VALUE) return std::nullopt;
+        BY_HANDLE_FILE_INFORMATION info{};
+        bool ok = GetFileInformationByHandle(handle, &info) != 0;
+        CloseHandle(handle);
+        if (!ok) return std::nullopt;
+        return FileId{info.dwVolumeSerialNumber,
+                      (static_cast<std::uint64_t>(info.nFileIndexHigh) << 32) | info.nFileIndexLow};
+#else
+        struct stat info {};
+        if (::stat(path.c_str(), &info) != 0) return std::nullopt;
+        return FileId{static_cast<std::uint64_t>(info.st_dev), static_cast<std::uint64_t>(info.st_ino)};
+#endif
+    }
+
+    std::string trim(const std::string& s) {
+        auto first = s.find_first_not_of(" \t\r");
+        if (first == std::string::npos) return {};
+        auto last = s.find_last_not_of(" \t\r");
+        return s.substr(first, last - first + 1);
+    }
+}
+
+bool RootSet::read_manifest(const std::string& source, std::vector<std::string>& out) {
+    std::ifstream file;
+    if (source != "-") {
+        file.open(fs::path(source));
+        if (!file) {
+            Logger::instance().error("Cannot read roots from: " + source);
+            return false;
+        }
+    }
+    std::istream& in = source == "-" ? std::cin : file;
+
+    std::string line;
+    while (std::getline(in, line)) {
+        line = trim(line);
+        if (line.empty() || line[0] == '#') continue;
+        out.push_back(std::move(line));
+    }
+    return true;
+}
+
+RootSet RootSet::plan(const std::vector<std::string>& inputs) {
+    RootSet set;
+
+    struct Candidate {
+        std::size_t order;
+        std::string input;
+        fs::path path;
+    };
+    std::vector<Candidate> candidates;
+    std::vector<std::pair<FileId, std::string>> seen;
+
+    for (const auto& input : inputs) {
+        std::error_code ec;
+        fs::path path;
+        {
+            NUKE_PROFILE(Canonicalize);
+            path = fs::weakly_canonical(fs::absolute(fs::path(input), ec), ec);
+        }
+        if (ec || !fs::is_directory(path, ec)) {
+            set.dropped.push_back({input, "not a directory", true});
+            continue;
+        }
+
+        // Same directory under another name: a symlinked path, a bind mount
+        auto id = file_identity(path);
+        if (id) {
+            auto it = std::find_if(seen.begin(), seen.end(),
+                                   [&id](const auto& entry) { return entry.first == *id; });
+            if (it != seen.end()) {
+                set.dropped.push_back({input, "same directory as " + it->second, false});
+                continue;
+            }
+            seen.emplace_back(*id, input);
+        }
+        candidates.push_back({candidates.size(), input, std::move(path)});
+    }
+
+    // Sorted by components, a root's descendants follow it directly, so
+    // each candidate only has to be checked against the last one kept.
+    std::sort(candidates.begin(), candidates.end(),
+              [](const Candidate& a, const Candidate& b) { return a.path < b.path; });
+    std::vector<Candidate> kept;
+    for (auto& candidate : candidates) {
+        if (!kept.empty() && is_within(candidate.path, kept.back().path)) {
+            set.dropped.push_back({candidate.input, "inside " + kept.back().input, false});
+            continue;
+        }
+        kept.push_back(std::move(candidate));
+    }
+
+    std::sort(kept.begin(), kept.end(),
+              [](const Candidate& a, const Candidate& b) { return a.order < b.order; });
+    for (auto& candidate : kept) {
+        set.roots.push_back(std::move(candidate.path));
+    }
+    return set;
+}
+
+} // namespace nuke
@@ -1,61 +1,451 @@
 #include "nuke/core/scanner.hpp"
 #include "nuke/ui/logger.hpp"
+#include "nuke/utils/profiler.hpp"
+#include <algorithm>
 #include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <cmath>
+#include <deque>
+#include <functional>
+#include <random>
+#include <unordered_map>
+
+#ifndef _WIN32
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#endif
 
 namespace nuke {
 
-Scanner::Scanner(const Config& config) : config_(config) {}
+namespace {
+    template <typename Iterator>
+    void advance(Iterator& it) {
+        NUKE_PROFILE(ReadDir);
+        ++it;
+    }
+    
+    std::string utf8_string(const fs::path& path) {
+        auto u8 = path.u8string();
+        return std::string(u8.begin(), u8.end());
+    }
+    
+    // estimate_directory budget: directories read, files stat'ed per
+    // directory, and random probes below the breadth-first part
+    constexpr std::size_t ESTIMATE_DIRS = 512;
+    constexpr std::size_t ESTIMATE_FILES_PER_DIR = 8;
+    constexpr std::size_t ESTIMATE_PROBES = 256;
+    constexpr double Z_95 = 1.96;
+    
+    // Welford's running mean / variance
+    struct RunningStats {
+        std::size_t n = 0;
+        double mean = 0;
+        double m2 = 0;
+        
+        void add(double x) {
+            ++n;
+            double delta = x - mean;
+            mean += delta / static_cast<double>(n);
+            m2 += delta * (x - mean);
+        }
+        double variance() const { return n > 1 ? m2 / static_cast<double>(n - 1) : 0.0; }
+    };
+    
+    std::uintmax_t to_unsigned(double value) {
+        return value > 0 ? static_cast<std::uintmax_t>(std::llround(value)) : 0;
+    }
+    
+    bool is_separator(fs::path::value_type c) {
+        return c == fs::path::preferred_separator || c == '/';
+    }
+    
+    // Past this many queued directories the scan goes depth first, so the
+    // frontier of a very wide tree cannot grow without bound.
+    constexpr std::size_t FRONTIER_LIMIT = 1 << 20;
+    
+    bool is_project_marker(const std::string& name) {
+        static const char* const markers[] = {
+            "package.json", "Cargo.toml", "pyproject.toml", "setup.py", "requirements.txt",
+            "go.mod", "pom.xml", "build.gradle", "CMakeLists.txt", "Makefile"
+        };
+        for (const char* marker : markers) {
+            if (name == marker) return true;
+        }
+        auto ends_with = [&name](std::string_view suffix) {
+            return name.size() >= suffix.size() &&
+                   name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0;
+        };
+        return ends_with(".csproj") || ends_with(".sln");
+    }
+    
+#ifndef _WIN32
+    // The root directory of every btrfs subvolume has this inode, and its own
+    // st_dev, so readdir's d_ino alone does not identify it
+    constexpr ino_t BTRFS_SUBVOLUME_INO = 256;
+    
+    FileId id_of(const struct stat& info) {
+        return {static_cast<std::uint64_t>(info.st_dev), static_cast<std::uint64_t>(info.st_ino)};
+    }
+    
+    bool stat_at(int dir_fd, const char* name, bool follow, struct stat& info) {
+        NUKE_PROFILE(Stat);
+        return ::fstatat(dir_fd, name, &info, follow ? 0 : AT_SYMLINK_NOFOLLOW) == 0;
+    }
+    
+    std::chrono::system_clock::time_point time_of(const struct timespec& ts) {
+        auto since_epoch = std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+        return std::chrono::system_clock::time_point(
+            std::chrono::duration_cast<std::chrono::system_clock::duration>(since_epoch));
+    }
+#endif
+    
+    struct FileUsage {
+        std::uintmax_t bytes = 0;
+        std::uint32_t links = 1;
+        FileId id;
+        std::chrono::system_clock::time_point used{};  // Newer of atime and mtime
+    };
+    
+    // One lstat, where file_size() was one stat. st_blocks is what the file
+    // occupies (less for sparse files, rounded up to blocks for small ones).
+    // Windows reports the logical size and no links.
+    bool file_usage(const fs::directory_entry& entry, FileUsage& usage) {
+        NUKE_PROFILE(Stat);
+#ifdef _WIN32
+        std::error_code ec;
+        usage.bytes = entry.file_size(ec);
+        if (ec) return false;
+        auto ftime = entry.last_write_time(ec);
+        if (!ec) usage.used = std::chrono::clock_cast<std::chrono::system_clock>(ftime);
+        return true;
+#else
+        struct stat info {};
+        if (::lstat(entry.path().c_str(), &info) != 0) return false;
+        usage.bytes = static_cast<std::uintmax_t>(info.st_blocks) * 512;
+        usage.links = static_cast<std::uint32_t>(info.st_nlink);
+        usage.id = id_of(info);
+        usage.used = std::max(time_of(info.st_atim), time_of(info.st_mtim));
+        return true;
+#endif
+    }
+    
+    // A subdirectory on another filesystem than the target (a bind mount,
+    // an automounted share, a btrfs subvolume): the Destroyer refuses to
+    // cross into it, so its bytes would never be freed. One lstat per
+    // directory; Windows mounts are not told apart.
+    bool crosses_device(const fs::directory_entry& entry, std::uint64_t device) {
+#ifdef _WIN32
+        (void)entry;
+        (void)device;
+        return false;
+#else
+        if (device == 0) return false;
+        struct stat info {};
+        NUKE_PROFILE(Stat);
+        return ::lstat(entry.path().c_str(), &info) == 0 &&
+               static_cast<std::uint64_t>(info.st_dev) != device;
+#endif
+    }
+}
+
+Scanner::Scanner(const Config& config) : config_(config), staleness_(config) {
+    ConcurrencyController::instance().configure(config);
+}
 
 ScanResult Scanner::scan(const fs::path& root, int max_depth) {
+    return scan(std::vector<fs::path>{root}, max_depth);
+}
+
+ScanResult Scanner::scan(const std::vector<fs::path>& roots, int max_depth) {
+    ScanCheckpoint start;
+    start.max_depth = max_depth;
+    for (const auto& root : roots) {
+        // "dir/" and "dir" must name the same root node
+        start.roots.push_back(root.has_filename() ? root : root.parent_path());
+        start.pending.push_back({ScanCheckpoint::Kind::Directory, 0, start.roots.back()});
+    }
+    return run(start);
+}
+
+ScanResult Scanner::resume(const ScanCheckpoint& checkpoint) {
+    return run(checkpoint);
+}
+
+ScanResult Scanner::run(const ScanCheckpoint& start) {
     ScanResult result;
-    auto start = std::chrono::high_resolution_clock::now();
+    auto begin = std::chrono::high_resolution_clock::now();
     
     found_count_ = 0;
     
-    Logger::instance().diagnostic("Scanner::scan starting for: " + root.string());
+    // Roots only need to be reachable when there is work left in them;
+    // merging shard results (targets only) works without the filesystem
+    if (!start.pending.empty()) {
+        std::size_t usable = 0;
+        for (const auto& root : start.roots) {
+            NUKE_DIAG("Scanner::scan starting for: {}", root.string());
+            
+            if (!fs::exists(root)) {
+                Logger::instance().error("Path does not exist: " + root.string());
+            } else if (!fs::is_directory(root)) {
+                Logger::instance().error("Path is not a directory: " + root.string());
+            } else {
+                usable++;
+            }
+        }
+        if (usable == 0) {
+            return result;
+        }
+    }
     
-    if (!fs::exists(root)) {
-        Logger::instance().error("Path does not exist: " + root.string());
-        return result;
+    roots_ = start.roots;
+    root_devs_.clear();
+    for (const auto& root : roots_) {
+        root_devs_.push_back(ConcurrencyController::device_of(root));
+    }
+    mounts_ = MountTable::load();
+    visited_.clear();
+    result.roots.clear();
+    for (const auto& root : roots_) {
+        result.roots.push_back({root, 0, 0});
+    }
+    max_depth_ = start.max_depth;
+    frontier_ = {};
+    work_seq_ = 0;
+    unfinished_.clear();
+    checkpoint_ = ScanCheckpoint{};
+    store_nodes_.clear();
+    store_.reset();
+    top_heap_.clear();
+    error_squares_ = 0;
+    // A target dropped by the size selection would still count towards
+    // links shared between targets, so only track them when all are kept
+    links_.reset();
+    if (size_targets_ && !estimate_ && min_bytes_ == 0 && max_bytes_ == UINTMAX_MAX && top_n_ == 0) {
+        links_ = std::make_unique<LinkTracker>();
+    }
+    if (retain_targets_ || top_n_ > 0) {
+        store_ = std::make_shared<TargetStore>();
     }
     
-    if (!fs::is_directory(root)) {
-        Logger::instance().error("Path is not a directory: " + root.string());
-        return result;
+    // Targets found before a checkpoint count, but were already reported
+    for (const auto& target : start.found) {
+        record_target(target, string_to_project_type(target.project_type), false, result);
+    }
+    for (const auto& item : start.pending) {
+        push_work(item.path, item.depth, item.kind, 0.0);
+    }
+    
+    // The budget simply cancels the scan when it runs out
+    std::mutex budget_mutex;
+    std::condition_variable budget_cv;
+    bool finished = false;
+    std::thread watchdog;
+    if (time_budget_) {
+        watchdog = std::thread([&] {
+            std::unique_lock<std::mutex> lock(budget_mutex);
+            if (!budget_cv.wait_for(lock, *time_budget_, [&] { return finished; })) {
+                NUKE_DIAG("Time budget of {}ms used up", time_budget_->count());
+                cancel();
+            }
+        });
+    }
+    
+    // This thread walks the tree; sizing the targets it finds is the bulk
+    // of the I/O and goes to the pool, as wide as each device allows.
+    // Unsized targets cost nothing, so they stay on this thread.
+    std::optional<TaskPool> pool;
+    if (size_targets_) {
+        pool.emplace();
+        sizers_ = &*pool;
     }
     
     try {
-        scan_recursive(root, 0, max_depth, result.targets);
-        Logger::instance().diagnostic("scan_recursive complete. Found " + std::to_string(result.targets.size()) + " targets");
+        while (!frontier_.empty() && !cancelled_.load(std::memory_order_relaxed)) {
+            WorkItem item = frontier_.top();
+            frontier_.pop();
+            if (item.kind == ScanCheckpoint::Kind::Target) {
+                dispatch_target(item.path, item.path.filename().string(), item.depth, item.id, result);
+            } else {
+                visit_directory(item, result);
+            }
+        }
     } catch (const std::exception& e) {
-        Logger::instance().error("Exception in scan_recursive: " + std::string(e.what()));
+        Logger::instance().error("Exception in scan: " + std::string(e.what()));
     }
     
-    for (const auto& entry : result.targets) {
-        result.total_size += entry.size;
+    if (pool) {
+        pool->wait();
+        sizers_ = nullptr;
+        ConcurrencyController::instance().log_summary();
     }
-    result.total_count = result.targets.size();
+    
+    // Files hardlinked only between targets go once every target does; the
+    // per-target shared figures count a file once per target it is in
+    if (links_) {
+        auto links = links_->totals();
+        NUKE_DIAG("Hardlinks shared between targets: {} bytes, with outside files: {} bytes",
+                  links.covered, links.uncovered);
+        result.total_size += links.covered;
+        result.total_shared = links.uncovered;
+        if (result.roots.size() == 1) {
+            result.roots.front().total_size += links.covered;  // Not split between several roots
+        }
+        links_.reset();
+    }
+    NUKE_DIAG("Scan loop complete. Found {} targets", result.total_count);
+    
+    if (watchdog.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(budget_mutex);
+            finished = true;
+        }
+        budget_cv.notify_one();
+        watchdog.join();
+    }
+    
+    // Whatever is left becomes the checkpoint, most promising first
+    result.complete = frontier_.empty() && unfinished_.empty();
+    if (!result.complete) {
+        checkpoint_.roots = roots_;
+        checkpoint_.max_depth = max_depth_;
+        checkpoint_.pending = std::move(unfinished_);
+        while (!frontier_.empty()) {
+            const auto& item = frontier_.top();
+            checkpoint_.pending.push_back({item.kind, item.depth, item.path});
+            frontier_.pop();
+        }
+    }
+    
+    if (store_ && top_n_ > 0) {
+        // Drop evicted rows, then report the survivors largest first
+        compact_store();
+        result.total_size = 0;
+        result.total_shared = 0;
+        result.total_count = store_->size();
+        for (auto& subtotal : result.roots) {
+            subtotal.total_size = 0;
+            subtotal.total_count = 0;
+        }
+        error_squares_ = 0;
+        for (std::size_t row = 0; row < store_->size(); ++row) {
+            auto& subtotal = result.roots[root_of(store_->paths().path(store_->node(row)))];
+            auto exclusive = store_->bytes(row) - store_->shared(row);
+            subtotal.total_size += exclusive;
+            subtotal.total_count++;
+            result.total_size += exclusive;
+            result.total_shared += store_->shared(row);
+            error_squares_ += static_cast<double>(store_->size_error(row)) * store_->size_error(row);
+        }
+        if (target_cb_) {
+            for (auto row : store_->order_by(SortBy::Size)) {
+                target_cb_(store_->entry(row));
+            }
+        }
+    }
+    
+    if (!result.complete && store_) {
+        checkpoint_.found = store_->entries();
+    }
+    if (!retain_targets_) {
+        store_.reset();
+    }
+    
+    // Independent per-target bounds add in quadrature
+    result.estimated = estimate_ && size_targets_;
+    result.total_size_error = to_unsigned(std::sqrt(error_squares_));
+    
+    if (store_) {
+        if (materialize_targets_) {
+            result.targets = store_->entries();
+        }
+        result.store = std::move(store_);
+    }
+    store_nodes_.clear();
     
     auto end = std::chrono::high_resolution_clock::now();
-    result.scan_duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+    result.scan_duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - begin);
     
-    Logger::instance().diagnostic("Scanner::scan complete. Total size: " + std::to_string(result.total_size));
+    NUKE_DIAG("Scanner::scan complete. Total size: {}", result.total_size);
     
     return result;
 }
 
-void Scanner::scan_recursive(const fs::path& path, int current_depth, int max_depth,
-                             std::vector<TargetEntry>& results) {
-    if (max_depth >= 0 && current_depth > max_depth) {
+void Scanner::push_work(fs::path path, int depth, ScanCheckpoint::Kind kind, double yield,
+                        FileId id) {
+    WorkItem item;
+    item.path = std::move(path);
+    item.depth = depth;
+    item.kind = kind;
+    item.yield = yield;
+    item.id = id;
+    if (frontier_.size() < FRONTIER_LIMIT) {
+        item.priority = depth - std::min(yield, 2.0);
+        item.seq = work_seq_++;
+    } else {
+        // Frontier too large: go depth first until it drains
+        item.priority = -1e9;
+        item.seq = UINT64_MAX - work_seq_++;
+    }
+    frontier_.push(std::move(item));
+}
+
+void Scanner::visit_directory(const WorkItem& item, ScanResult& result) {
+    struct Child {
+        fs::path path;
+        std::string name;
+        FileId id;
+    };
+    std::vector<Child> targets;
+    std::vector<Child> subdirs;
+    bool has_marker = false;
+    
+    // Resumed work and the roots come without an identity from a parent
+    FileId self = item.id;
+    if (!self.known() && std::find(roots_.begin(), roots_.end(), item.path) == roots_.end() &&
+        !may_enter(item.path, self)) {
         return;
     }
     
+    auto add_directory = [&](fs::path path, std::string name, FileId id) {
+        if (config_.is_ignored(name) || !may_enter(path, id)) {
+            return;
+        }
+        auto& list = config_.is_target(name) ? targets : subdirs;
+        list.push_back({std::move(path), std::move(name), id});
+    };
+    auto check_marker = [&has_marker](const std::string& name) {
+        if (!has_marker && is_project_marker(name)) {
+            has_marker = true;
+        }
+    };
+    
+#ifdef _WIN32
     try {
-        for (const auto& entry : fs::directory_iterator(path, 
-                fs::directory_options::skip_permission_denied)) {
+        fs::directory_iterator it;
+        {
+            NUKE_PROFILE(OpenDir);
+            it = fs::directory_iterator(item.path, fs::directory_options::skip_permission_denied);
+        }
+        
+        for (; it != fs::directory_iterator(); advance(it)) {
+            if (cancelled_.load(std::memory_order_relaxed)) {
+                // Read it again on resume rather than track a half-read directory
+                std::lock_guard<std::mutex> lock(results_mutex_);
+                unfinished_.push_back({item.kind, item.depth, item.path});
+                return;
+            }
+            
+            const auto& entry = *it;
+            if (counters_) {
+                counters_->entries.fetch_add(1, std::memory_order_relaxed);
+            }
             
             try {
                 if (!entry.is_directory()) {
+                    check_marker(entry.path().filename().string());
                     continue;
                 }
                 
@@ -69,98 +459,589 @@ void Scanner::scan_recursive(const fs::path& path, int current_depth, int max_de
                     name = std::string(u8name.begin(), u8name.end());
                 }
                 
-                if (config_.is_ignored(name)) {
-                    continue;
-                }
-                
-                if (config_.is_target(name)) {
-                    if (!passes_age_filter(entry.path())) {
-                        continue;
-                    }
-                    
-                    TargetEntry target;
-                    target.path = entry.path();
-                    target.size = get_directory_size(entry.path());
-                    target.project_type = detect_project_type(name);
-                    
-                    try {
-                        auto ftime = fs::last_write_time(entry.path());
-                        target.last_modified = std::chrono::clock_cast<std::chrono::system_clock>(ftime);
-                    } catch (...) {
-                        target.last_modified = std::chrono::system_clock::now();
-                    }
-                    
-                    results.push_back(target);
-                    found_count_++;
-                    
-                    if (progress_cb_) {
-                        progress_cb_(entry.path(), found_count_);
-                    }
-                } else {
-                    scan_recursive(entry.path(), current_depth + 1, max_depth, results);
-                }
+                add_directory(entry.path(), std::move(name), FileId{});
             } catch (const std::exception& e) {
                 // Skip entries that cause errors (e.g., Unicode conversion issues)
-                Logger::instance().diagnostic("Skipping entry: " + std::string(e.what()));
+                NUKE_DIAG("Skipping entry: {}", e.what());
                 continue;
             }
         }
     } catch (const std::exception& e) {
-        Logger::instance().diagnostic("Scan error: " + std::string(e.what()));
+        NUKE_DIAG("Scan error: {}", e.what());
+    }
+#else
+    // readdir hands over each entry's type and inode, so a plain
+    // subdirectory is identified as (this directory's device, d_ino) without
+    // a stat. Only symlinks and unknown types (which need a stat to be
+    // classified at all), mount points and btrfs subvolumes are stat'ed.
+    DIR* raw = nullptr;
+    {
+        NUKE_PROFILE(OpenDir);
+        raw = ::opendir(item.path.c_str());
+    }
+    if (!raw) {
+        NUKE_DIAG("Scan error: cannot open {}", item.path.string());
+        return;
+    }
+    std::unique_ptr<DIR, int (*)(DIR*)> dir(raw, ::closedir);
+    int fd = ::dirfd(raw);
+    
+    if (!self.known()) {
+        struct stat info {};
+        NUKE_PROFILE(Stat);
+        if (::fstat(fd, &info) == 0) {
+            self = id_of(info);
+            if (!visited_.insert(self)) {
+                NUKE_DETAIL("Already visited: {}", item.path.string());
+                return;
+            }
+        }
+    }
+    
+    for (;;) {
+        if (cancelled_.load(std::memory_order_relaxed)) {
+            // Read it again on resume rather than track a half-read directory
+            std::lock_guard<std::mutex> lock(results_mutex_);
+            unfinished_.push_back({item.kind, item.depth, item.path});
+            return;
+        }
+        
+        struct dirent* entry;
+        {
+            NUKE_PROFILE(ReadDir);
+            entry = ::readdir(raw);
+        }
+        if (!entry) break;
+        
+        std::string name = entry->d_name;
+        if (name == "." || name == "..") continue;
+        if (counters_) {
+            counters_->entries.fetch_add(1, std::memory_order_relaxed);
+        }
+        
+        FileId id{self.dev, static_cast<std::uint64_t>(entry->d_ino)};
+        bool is_dir = entry->d_type == DT_DIR;
+        if (entry->d_type == DT_LNK || entry->d_type == DT_UNKNOWN ||
+            (is_dir && entry->d_ino == BTRFS_SUBVOLUME_INO)) {
+            struct stat info {};
+            if (!stat_at(fd, entry->d_name, entry->d_type != DT_UNKNOWN, info)) continue;
+            is_dir = S_ISDIR(info.st_mode);
+            id = id_of(info);
+        }
+        
+        if (!is_dir) {
+            check_marker(name);
+            continue;
+        }
+        fs::path path = item.path / name;
+        add_directory(std::move(path), std::move(name), id);
+    }
+#endif
+    
+    // Projects cluster: directories beside targets or build files are
+    // likely to hold more, so their subdirectories jump the queue a little.
+    double yield = 0.5 * item.yield + (targets.empty() ? 0.0 : 1.0) + (has_marker ? 0.5 : 0.0);
+    if (max_depth_ < 0 || item.depth + 1 <= max_depth_) {
+        for (auto& subdir : subdirs) {
+            push_work(std::move(subdir.path), item.depth + 1, ScanCheckpoint::Kind::Directory, yield,
+                      subdir.id);
+        }
+    }
+    
+    for (auto& target : targets) {
+        dispatch_target(std::move(target.path), std::move(target.name), item.depth, target.id,
+                        result);
     }
 }
 
-bool Scanner::passes_age_filter(const fs::path& path) const {
-    if (!older_than_.has_value()) {
-        return true;
+// Mount points are recognized from the mount table without a syscall; only
+// those the walk may enter are stat'ed, for their device and root inode.
+bool Scanner::may_enter(const fs::path& path, FileId& id) {
+    if (auto* mount = mounts_.find(path)) {
+        if (config_.is_skipped_filesystem(mount->fs_type)) {
+            NUKE_DETAIL("Skipping {} mount: {}", mount->fs_type, path.string());
+            return false;
+        }
+#ifndef _WIN32
+        struct stat info {};
+        {
+            NUKE_PROFILE(Stat);
+            if (::stat(path.c_str(), &info) != 0) return false;
+        }
+        id = id_of(info);
+#endif
+    }
+    
+    // Mount points and btrfs subvolumes carry their own device
+    if (one_file_system_ && id.known() && id.dev != root_devs_[root_of(path)]) {
+        NUKE_DETAIL("Not crossing into another filesystem: {}", path.string());
+        return false;
+    }
+    if (id.known() && !visited_.insert(id)) {
+        NUKE_DETAIL("Already visited: {}", path.string());
+        return false;
+    }
+    return true;
+}
+
+void Scanner::dispatch_target(fs::path path, std::string name, int depth, FileId id,
+                              ScanResult& result) {
+    if (!sizers_) {
+        visit_target(path, name, depth, result);
+        return;
+    }
+    auto task = [this, path, name = std::move(name), depth, &result] {
+        return visit_target(path, name, depth, result);
+    };
+    // The walk already knows the device; saves a stat per target
+    if (id.known()) {
+        sizers_->submit(id.dev, path, std::move(task));
+    } else {
+        sizers_->submit(path, std::move(task));
+    }
+}
+
+std::size_t Scanner::visit_target(const fs::path& path, const std::string& name, int depth,
+                                  ScanResult& result) {
+    auto defer = [&] {
+        // Not sized (or only partly); size it again on resume
+        std::lock_guard<std::mutex> lock(results_mutex_);
+        unfinished_.push_back({ScanCheckpoint::Kind::Target, depth, path});
+    };
+    if (cancelled_.load(std::memory_order_relaxed)) {
+        defer();
+        return 0;
+    }
+    // The stat yields the identity the Destroyer checks before deleting, and
+    // drops resumed or listed targets that are gone or no longer directories
+#ifdef _WIN32
+    std::error_code type_ec;
+    if (!fs::is_directory(path, type_ec)) {
+        NUKE_DETAIL("Not a directory: {}", path.string());
+        return 1;
+    }
+#else
+    struct stat info {};
+    {
+        NUKE_PROFILE(Stat);
+        if (::stat(path.c_str(), &info) != 0 || !S_ISDIR(info.st_mode)) {
+            NUKE_DETAIL("Not a directory: {}", path.string());
+            return 1;
+        }
     }
+#endif
+    if (!passes_age_filter(path, name)) {
+        return 1;
+    }
+    
+    DirectoryStats stats;
+    if (size_targets_) {
+        stats = estimate_
+            ? estimate_directory(path, counters_, &cancelled_)
+            : measure_directory(path, counters_, &cancelled_, max_bytes_, links_.get());
+        if (cancelled_.load(std::memory_order_relaxed)) {
+            defer();
+            return stats.files + stats.dirs;
+        }
+    }
+    std::size_t ops = stats.files + stats.dirs + 1;
     
+    TargetEntry target;
+    target.path = path;
+    target.size = stats.bytes;
+    target.size_error = stats.bytes_error;
+    target.shared_size = stats.shared_bytes;
+    target.file_count = stats.files;
+    target.dir_count = stats.dirs;
+#ifdef _WIN32
     try {
-        auto last_write = fs::last_write_time(path);
-        auto now = fs::file_time_type::clock::now();
-        auto age = std::chrono::duration_cast<std::chrono::hours>(now - last_write);
-        
-        return age >= older_than_.value();
+        NUKE_PROFILE(Stat);
+        auto ftime = fs::last_write_time(path);
+        target.last_modified = std::chrono::clock_cast<std::chrono::system_clock>(ftime);
     } catch (...) {
+        target.last_modified = std::chrono::system_clock::now();
+    }
+#else
+    target.last_modified = time_of(info.st_mtim);
+    target.id = id_of(info);
+#endif
+    target.last_used = std::max(target.last_modified, stats.newest);
+    
+    auto type = detect_project_type(name);
+    target.project_type = project_type_to_string(type);
+    
+    std::lock_guard<std::mutex> lock(results_mutex_);
+    if (size_targets_ && (stats.exceeded || !admits(stats.bytes))) {
+        NUKE_DETAIL("Outside size selection: {}", path.string());
+        return ops;
+    }
+    record_target(target, type, true, result);
+    
+    if (counters_) {
+        counters_->items.fetch_add(1, std::memory_order_relaxed);
+        counters_->bytes.fetch_add(stats.bytes, std::memory_order_relaxed);
+    }
+    if (progress_cb_) {
+        progress_cb_(path, found_count_);
+    }
+    return ops;
+}
+
+void Scanner::record_target(const TargetEntry& target, ProjectType type, bool notify,
+                            ScanResult& result) {
+    if (store_) {
+        auto node = store_->paths().add(materialize_path(target.path.parent_path()),
+                                        utf8_string(target.path.filename()));
+        auto row = store_->add_target(node, type, target.size, target.file_count, target.dir_count,
+                                      target.last_modified, target.size_error, target.shared_size,
+                                      target.id, target.last_used);
+        store_->roll_up(node, target.size);
+        if (top_n_ > 0) {
+            push_top(static_cast<std::uint32_t>(row));
+        }
+    }
+    
+    result.total_size += target.exclusive_size();
+    result.total_shared += target.shared_size;
+    result.total_count++;
+    auto& subtotal = result.roots[root_of(target.path)];
+    subtotal.total_size += target.exclusive_size();
+    subtotal.total_count++;
+    error_squares_ += static_cast<double>(target.size_error) * target.size_error;
+    found_count_++;
+    
+    if (notify && target_cb_ && top_n_ == 0) {
+        target_cb_(target);
+    }
+}
+
+std::uint32_t Scanner::materialize_path(const fs::path& dir) {
+    auto it = store_nodes_.find(dir.native());
+    if (it != store_nodes_.end()) {
+        return it->second;
+    }
+    
+    std::uint32_t node;
+    if (std::find(roots_.begin(), roots_.end(), dir) != roots_.end() ||
+        dir.parent_path() == dir || dir.empty()) {
+        node = store_->paths().add(PathArena::NO_PARENT, utf8_string(dir));
+    } else {
+        auto parent = materialize_path(dir.parent_path());
+        node = store_->paths().add(parent, utf8_string(dir.filename()));
+    }
+    store_nodes_.emplace(dir.native(), node);
+    return node;
+}
+
+std::size_t Scanner::root_of(const fs::path& path) const {
+    // Roots never overlap, so the first one that prefixes the path owns it
+    const auto& native = path.native();
+    for (std::size_t i = 0; i < roots_.size(); ++i) {
+        const auto& root = roots_[i].native();
+        if (native.compare(0, root.size(), root) != 0) continue;
+        if (native.size() == root.size() || root.empty() ||
+            is_separator(native[root.size()]) || is_separator(root.back())) {
+            return i;
+        }
+    }
+    return 0;
+}
+
+bool Scanner::admits(std::uintmax_t bytes) const {
+    if (bytes < min_bytes_ || bytes > max_bytes_) {
+        return false;
+    }
+    // Once the heap is full, only targets larger than the K-th one matter
+    if (top_n_ > 0 && top_heap_.size() >= top_n_) {
+        return bytes > store_->bytes(top_heap_.front());
+    }
+    return true;
+}
+
+void Scanner::push_top(std::uint32_t row) {
+    auto larger = [this](std::uint32_t a, std::uint32_t b) {
+        return store_->bytes(a) > store_->bytes(b);
+    };
+    top_heap_.push_back(row);
+    std::push_heap(top_heap_.begin(), top_heap_.end(), larger);
+    if (top_heap_.size() > top_n_) {
+        std::pop_heap(top_heap_.begin(), top_heap_.end(), larger);
+        top_heap_.pop_back();
+    }
+    
+    // Evicted rows are dead weight; reclaim them once they outnumber the heap
+    if (store_->size() - top_heap_.size() >= std::max<std::size_t>(top_n_, 4096)) {
+        compact_store();
+    }
+}
+
+void Scanner::compact_store() {
+    auto node_map = store_->compact(top_heap_);
+    for (std::uint32_t i = 0; i < top_heap_.size(); ++i) {
+        top_heap_[i] = i;
+    }
+    for (auto it = store_nodes_.begin(); it != store_nodes_.end();) {
+        it->second = node_map[it->second];
+        if (it->second == PathArena::NO_PARENT) {
+            it = store_nodes_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+bool Scanner::passes_age_filter(const fs::path& path, const std::string& name) const {
+    if (!older_than_.has_value()) {
+        return true;
+    }
+    
+    // Unreadable targets pass; sizing reports them
+    auto last_activity = staleness_.last_activity(path, name);
+    if (!last_activity) {
         return true;
     }
+    auto age = std::chrono::duration_cast<std::chrono::hours>(
+        std::chrono::system_clock::now() - *last_activity);
+    return age >= older_than_.value();
 }
 
-std::uintmax_t Scanner::get_directory_size(const fs::path& path) {
-    std::uintmax_t size = 0;
+std::uintmax_t Scanner::get_directory_size(const fs::path& path, ProgressCounters* counters) {
+    return measure_directory(path, counters).bytes;
+}
+
+DirectoryStats Scanner::measure_directory(const fs::path& path, ProgressCounters* counters,
+                                         const std::atomic<bool>* cancel,
+                                         std::uintmax_t stop_above, LinkTracker* links) {
+    DirectoryStats stats;
+    std::size_t entries = 0;
+    
+    // Files with several links: counted once, and only freed with the tree
+    // when every link was found inside it
+    struct Linked {
+        std::uint32_t links = 0;
+        std::uint32_t seen = 0;
+        std::uintmax_t bytes = 0;
+    };
+    std::unordered_map<FileId, Linked, FileIdHash> linked;
+    auto device = ConcurrencyController::device_of(path);
     
     try {
-        for (const auto& entry : fs::recursive_directory_iterator(path,
-                fs::directory_options::skip_permission_denied)) {
+        fs::recursive_directory_iterator it;
+        {
+            NUKE_PROFILE(OpenDir);
+            it = fs::recursive_directory_iterator(path, fs::directory_options::skip_permission_denied);
+        }
+        
+        for (; it != fs::recursive_directory_iterator(); advance(it)) {
+            if (cancel && cancel->load(std::memory_order_relaxed)) {
+                break;
+            }
+            
+            const auto& entry = *it;
+            ++entries;
             if (entry.is_regular_file()) {
-                try {
-                    size += entry.file_size();
-                } catch (...) {}
+                stats.files++;
+                FileUsage usage;
+                if (file_usage(entry, usage)) {
+                    stats.newest = std::max(stats.newest, usage.used);
+                    if (usage.links > 1) {
+                        auto [it, inserted] =
+                            linked.try_emplace(usage.id, Linked{usage.links, 0, usage.bytes});
+                        it->second.seen++;
+                        if (inserted) stats.bytes += usage.bytes;
+                    } else {
+                        stats.bytes += usage.bytes;
+                    }
+                }
+                if (stats.bytes > stop_above) {
+                    stats.exceeded = true;
+                    break;
+                }
+            } else if (entry.is_directory()) {
+                if (!entry.is_symlink() && crosses_device(entry, device)) {
+                    it.disable_recursion_pending();
+                    continue;
+                }
+                stats.dirs++;
             }
         }
     } catch (...) {}
     
-    return size;
+    for (const auto& [id, file] : linked) {
+        if (file.seen < file.links) {
+            stats.shared_bytes += file.bytes;
+            if (links) links->add(id, file.links, file.seen, file.bytes);
+        }
+    }
+    
+    if (counters) {
+        counters->entries.fetch_add(entries, std::memory_order_relaxed);
+    }
+    return stats;
+}
+
+DirectoryStats Scanner::estimate_directory(const fs::path& path, ProgressCounters* counters,
+                                          const std::atomic<bool>* cancel) {
+    DirectoryStats stats;
+    std::minstd_rand rng(static_cast<unsigned>(std::hash<std::string>{}(path.string())));
+    std::size_t entries = 0;
+    std::size_t reads = 0;
+    
+    struct DirSample {
+        double bytes = 0;     // Sampled files plus the sample mean for the rest
+        double variance = 0;  // Of `bytes`, from the file-size sample
+        std::size_t files = 0;
+        std::size_t linked_dirs = 0;
+        std::vector<fs::path> children;
+    };
+    
+    // One readdir, and a stat of at most ESTIMATE_FILES_PER_DIR files
+    std::vector<fs::directory_entry> sample;
+    auto device = ConcurrencyController::device_of(path);
+    auto read_dir = [&](const fs::path& dir) {
+        DirSample result;
+        sample.clear();
+        ++reads;
+        try {
+            fs::directory_iterator it;
+            {
+                NUKE_PROFILE(OpenDir);
+                it = fs::directory_iterator(dir, fs::directory_options::skip_permission_denied);
+            }
+            for (; it != fs::directory_iterator(); advance(it)) {
+                const auto& entry = *it;
+                ++entries;
+                if (entry.is_regular_file()) {
+                    ++result.files;
+                    // Reservoir sampling: uniform over the directory in one pass
+                    if (sample.size() < ESTIMATE_FILES_PER_DIR) {
+                        sample.push_back(entry);
+                    } else {
+                        std::uniform_int_distribution<std::size_t> slot(0, result.files - 1);
+                        auto j = slot(rng);
+                        if (j < sample.size()) sample[j] = entry;
+                    }
+                } else if (entry.is_directory()) {
+                    if (entry.is_symlink()) {
+                        ++result.linked_dirs;  // Counted like measure_directory, never followed
+                    } else if (!crosses_device(entry, device)) {
+                        result.children.push_back(entry.path());
+                    }
+                }
+            }
+        } catch (...) {}
+        
+        RunningStats sizes;
+        for (const auto& entry : sample) {
+            FileUsage usage;
+            if (file_usage(entry, usage)) {
+                sizes.add(static_cast<double>(usage.bytes));
+                stats.newest = std::max(stats.newest, usage.used);
+            }
+        }
+        if (sizes.n > 0) {
+            double n = static_cast<double>(sizes.n);
+            double total = static_cast<double>(result.files);
+            result.bytes = sizes.mean * total;
+            // Of the total N * mean from n of N files drawn without
+            // replacement: N^2 (1 - n/N) s^2 / n, the correction applied once
+            result.variance = total * total * (1.0 - n / total) * sizes.variance() / n;
+        }
+        return result;
+    };
+    
+    // Top of the tree, breadth first and exactly (up to file sampling)
+    double bytes = 0;
+    double variance = 0;
+    double files = 0;
+    double dirs = 0;
+    std::deque<fs::path> frontier{path};
+    while (!frontier.empty() && reads < ESTIMATE_DIRS * 3 / 4) {
+        if (cancel && cancel->load(std::memory_order_relaxed)) break;
+        auto dir = read_dir(frontier.front());
+        frontier.pop_front();
+        bytes += dir.bytes;
+        variance += dir.variance;
+        files += static_cast<double>(dir.files);
+        dirs += static_cast<double>(dir.linked_dirs) + (reads > 1 ? 1 : 0);
+        for (auto& child : dir.children) frontier.push_back(std::move(child));
+    }
+    
+    // The rest: Knuth's estimator. Each probe walks one random path down from
+    // a random frontier directory, weighting what it sees by the product of
+    // the branching factors it passed. Probes are unbiased; their spread
+    // gives the error bound. Directories are read once and shared.
+    if (!frontier.empty()) {
+        std::unordered_map<fs::path::string_type, DirSample> cache;
+        RunningStats probe_bytes;
+        RunningStats probe_files;
+        RunningStats probe_dirs;
+        std::uniform_int_distribution<std::size_t> pick_root(0, frontier.size() - 1);
+        
+        while ((reads < ESTIMATE_DIRS || probe_bytes.n < 2) && probe_bytes.n < ESTIMATE_PROBES) {
+            if (cancel && cancel->load(std::memory_order_relaxed)) break;
+            
+            double weight = static_cast<double>(frontier.size());
+            fs::path node = frontier[pick_root(rng)];
+            double b = 0, f = 0, d = 0;
+            for (;;) {
+                auto it = cache.find(node.native());
+                if (it == cache.end()) {
+                    it = cache.emplace(node.native(), read_dir(node)).first;
+                }
+                const DirSample& dir = it->second;
+                b += weight * dir.bytes;
+                f += weight * static_cast<double>(dir.files);
+                d += weight * static_cast<double>(1 + dir.linked_dirs);
+                if (dir.children.empty()) break;
+                
+                std::uniform_int_distribution<std::size_t> pick_child(0, dir.children.size() - 1);
+                weight *= static_cast<double>(dir.children.size());
+                node = dir.children[pick_child(rng)];
+            }
+            probe_bytes.add(b);
+            probe_files.add(f);
+            probe_dirs.add(d);
+        }
+        
+        if (probe_bytes.n > 0) {
+            double n = static_cast<double>(probe_bytes.n);
+            bytes += probe_bytes.mean;
+            files += probe_files.mean;
+            dirs += probe_dirs.mean;
+            variance += probe_bytes.variance() / n;
+        }
+    }
+    
+    stats.bytes = to_unsigned(bytes);
+    stats.bytes_error = to_unsigned(Z_95 * std::sqrt(variance));
+    stats.files = to_unsigned(files);
+    stats.dirs = to_unsigned(dirs);
+    
+    if (counters) {
+        counters->entries.fetch_add(entries, std::memory_order_relaxed);
+    }
+    return stats;
 }
 
-std::string Scanner::detect_project_type(const std::string& folder_name) {
+ProjectType Scanner::detect_project_type(const std::string& folder_name) {
     if (folder_name == "node_modules" || folder_name == ".next" || 
         folder_name == ".nuxt" || folder_name == ".parcel-cache") {
-        return "node";
+        return ProjectType::Node;
     }
     if (folder_name == "target") {
-        return "rust";
+        return ProjectType::Rust;
     }
     if (folder_name == "__pycache__" || folder_name == ".venv" || folder_name == "venv") {
-        return "python";
+        return ProjectType::Python;
     }
     if (folder_name == "bin" || folder_name == "obj") {
-        return "dotnet";
+        return ProjectType::Dotnet;
     }
     if (folder_name == "build" || folder_name == "dist") {
-        return "generic";
+        return ProjectType::Generic;
     }
-    return "unknown";
+    return ProjectType::Unknown;
 }
 
 } // namespace nuke
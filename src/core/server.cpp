@@ -0,0 +1,716 @@
+#include "nuke/core/server.hpp"
+#include "nuke/core/cost_model.hpp"
+#include "nuke/core/destroyer.hpp"
+#include "nuke/core/scanner.hpp"
+#include "nuke/ui/logger.hpp"
+#include "nuke/utils/safety.hpp"
+#include <fmt/core.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace nuke {
+
+namespace {
+    // A client that stops reading (or never sends its request) is dropped
+    // after this long rather than holding a connection slot forever
+    constexpr int SOCKET_TIMEOUT_SECONDS = 60;
+    // Targets encoded per wake-up while streaming a walk
+    constexpr std::size_t STREAM_BATCH = 256;
+
+    void send_error(int fd, const std::string& message) {
+        protocol::Writer out;
+        out.str(message);
+        protocol::write_frame(fd, protocol::MessageType::Error, out.data());
+    }
+
+    std::string join_paths(const std::vector<fs::path>& paths) {
+        std::string joined;
+        for (const auto& path : paths) {
+            joined += (joined.empty() ? "" : ", ") + path.string();
+        }
+        return joined;
+    }
+
+    // One path equal to or inside the other
+    bool nested(const fs::path& a, const fs::path& b) {
+        auto ai = a.begin();
+        auto bi = b.begin();
+        for (; ai != a.end() && bi != b.end(); ++ai, ++bi) {
+            if (*ai != *bi) return false;
+        }
+        return true;
+    }
+
+    // Lock keys end in a separator, so "a/b/" is a prefix of exactly the
+    // keys at or below a/b
+    std::string lock_key(const fs::path& path) {
+        std::string key = path.lexically_normal().generic_string();
+        if (key.empty() || key.back() != '/') key += '/';
+        return key;
+    }
+
+    bool overlaps(const std::set<std::string>& wanted, const std::set<std::string>& held) {
+        for (const auto& key : wanted) {
+            // An ancestor of key (or key itself) is held
+            for (std::size_t pos = key.find('/'); pos != std::string::npos; pos = key.find('/', pos + 1)) {
+                if (held.count(key.substr(0, pos + 1))) return true;
+            }
+            // Something below key is held
+            auto below = held.lower_bound(key);
+            if (below != held.end() && below->compare(0, key.size(), key) == 0) return true;
+        }
+        return false;
+    }
+
+#ifndef _WIN32
+    bool make_address(const fs::path& path, sockaddr_un& addr) {
+        std::string text = path.string();
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if (text.empty() || text.size() >= sizeof(addr.sun_path)) return false;
+        std::memcpy(addr.sun_path, text.c_str(), text.size() + 1);
+        return true;
+    }
+
+    int open_socket() {
+        int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd >= 0) ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+        return fd;
+    }
+
+    // The fallback socket is in /tmp, where another user can bind the name
+    // first, read every request and answer with forged targets
+    bool peer_is_us(int fd) {
+#ifdef __linux__
+        ucred peer{};
+        socklen_t size = sizeof(peer);
+        if (::getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &peer, &size) != 0) return false;
+        return peer.uid == ::getuid();
+#else
+        uid_t uid;
+        gid_t gid;
+        if (::getpeereid(fd, &uid, &gid) != 0) return false;
+        return uid == ::getuid();
+#endif
+    }
+#endif
+
+    struct SocketCloser {
+        int fd;
+        ~SocketCloser() {
+#ifndef _WIN32
+            if (fd >= 0) ::close(fd);
+#endif
+        }
+    };
+}
+
+// ============================================================================
+// Scan Server
+// ============================================================================
+ScanServer::ScanServer(const Config& config, ServerOptions options)
+    : config_(config), fingerprint_(config.scan_fingerprint()), options_(std::move(options)) {
+    if (options_.socket_path.empty()) {
+        options_.socket_path = default_socket_path();
+    }
+    options_.max_walks = std::max<std::size_t>(options_.max_walks, 1);
+    options_.max_clients = std::max<std::size_t>(options_.max_clients, 1);
+}
+
+ScanServer::~ScanServer() {
+#ifndef _WIN32
+    if (int fd = listen_fd_.load(); fd >= 0) {
+        ::close(fd);
+        ::unlink(options_.socket_path.c_str());
+    }
+#endif
+}
+
+fs::path ScanServer::default_socket_path() {
+    if (const char* socket = std::getenv("NUKE_SOCKET"); socket && *socket) {
+        return fs::path(socket);
+    }
+#ifdef _WIN32
+    return {};
+#else
+    if (const char* runtime = std::getenv("XDG_RUNTIME_DIR"); runtime && *runtime) {
+        return fs::path(runtime) / "nuke.sock";
+    }
+    return fs::path(fmt::format("/tmp/nuke-{}.sock", ::getuid()));
+#endif
+}
+
+bool ScanServer::listen() {
+    auto& logger = Logger::instance();
+#ifdef _WIN32
+    logger.error("nuke serve needs Unix domain sockets, which this build does not support");
+    return false;
+#else
+    sockaddr_un addr;
+    if (!make_address(options_.socket_path, addr)) {
+        logger.error("Socket path is empty or too long: " + options_.socket_path.string());
+        return false;
+    }
+
+    if (ScanClient(options_.socket_path).available()) {
+        logger.error("A server is already running on " + options_.socket_path.string());
+        return false;
+    }
+
+    // Left behind by a server that did not shut down; anything else at the
+    // path is not ours to remove
+    struct stat st;
+    if (::lstat(addr.sun_path, &st) == 0) {
+        if (!S_ISSOCK(st.st_mode)) {
+            logger.error("Not a socket: " + options_.socket_path.string());
+            return false;
+        }
+        ::unlink(addr.sun_path);
+    }
+
+    int fd = open_socket();
+    if (fd < 0) {
+        logger.error(std::string("Cannot create socket: ") + std::strerror(errno));
+        return false;
+    }
+
+    // Only the owner may connect: requests delete with the server's rights
+    mode_t old_mask = ::umask(0077);
+    int bound = ::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    ::umask(old_mask);
+    if (bound != 0 || ::listen(fd, 64) != 0) {
+        logger.error("Cannot listen on " + options_.socket_path.string() + ": " + std::strerror(errno));
+        ::close(fd);
+        return false;
+    }
+
+    listen_fd_ = fd;
+    return true;
+#endif
+}
+
+void ScanServer::stop() {
+    stopping_.store(true);
+#ifndef _WIN32
+    // Wakes accept(); shutdown is async-signal-safe, close would race run()
+    if (int fd = listen_fd_.load(); fd >= 0) {
+        ::shutdown(fd, SHUT_RDWR);
+    }
+#endif
+}
+
+void ScanServer::run() {
+#ifndef _WIN32
+    auto& logger = Logger::instance();
+
+    while (!stopping_.load()) {
+        int fd = ::accept(listen_fd_, nullptr, nullptr);
+        if (fd < 0) {
+            if (stopping_.load()) break;
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            if (errno == EMFILE || errno == ENFILE) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                continue;
+            }
+            logger.error(std::string("accept failed: ") + std::strerror(errno));
+            break;
+        }
+        ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+        timeval timeout{SOCKET_TIMEOUT_SECONDS, 0};
+        ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+        {
+            std::unique_lock<std::mutex> lock(state_mutex_);
+            state_cv_.wait(lock, [this] { return clients_ < options_.max_clients; });
+            ++clients_;
+        }
+        std::thread([this, fd] {
+            serve_connection(fd);
+            ::close(fd);
+            // Notified under the lock: once run() sees the count drop, the
+            // server may be destroyed
+            std::lock_guard<std::mutex> lock(state_mutex_);
+            --clients_;
+            state_cv_.notify_all();
+        }).detach();
+    }
+
+    // Running walks return what they found; waiting ones do not start
+    std::unique_lock<std::mutex> lock(state_mutex_);
+    for (Scanner* scanner : scanners_) {
+        scanner->cancel();
+    }
+    state_cv_.notify_all();
+    state_cv_.wait(lock, [this] { return clients_ == 0 && walks_ == 0; });
+    lock.unlock();
+
+    ::close(listen_fd_.exchange(-1));
+    ::unlink(options_.socket_path.c_str());
+#endif
+}
+
+void ScanServer::serve_connection(int fd) {
+    protocol::MessageType type;
+    std::string payload;
+    if (!protocol::read_frame(fd, type, payload)) {
+        return;  // A probe from ScanClient::available(), or a dead client
+    }
+
+    protocol::Reader in(payload);
+    if (in.u16() != protocol::VERSION) {
+        send_error(fd, "Client and server speak different protocol versions; restart 'nuke serve'");
+        return;
+    }
+
+    try {
+        switch (type) {
+            case protocol::MessageType::Handshake: handle_handshake(fd, in); break;
+            case protocol::MessageType::ScanRequest: handle_scan(fd, in); break;
+            case protocol::MessageType::DeleteRequest: handle_delete(fd, in); break;
+            default: send_error(fd, "Unknown request"); break;
+        }
+    } catch (const std::exception& e) {
+        send_error(fd, std::string("Server error: ") + e.what());
+    }
+}
+
+void ScanServer::handle_handshake(int fd, protocol::Reader& in) {
+    in.u64();  // The client compares
+    if (!in.done()) {
+        send_error(fd, "Malformed handshake");
+        return;
+    }
+    protocol::Writer out;
+    out.u64(fingerprint_);
+    protocol::write_frame(fd, protocol::MessageType::Handshake, out.data());
+}
+
+void ScanServer::handle_scan(int fd, protocol::Reader& in) {
+    ScanRequest request;
+    if (!request.decode(in) || !in.done() || request.roots.empty()) {
+        send_error(fd, "Malformed scan request");
+        return;
+    }
+    // Targets, ignore list and markers come from the server's config; a
+    // client with another one would get results a local scan never finds
+    if (request.config != fingerprint_) {
+        send_error(fd, "The server scans with a different configuration; restart 'nuke serve' "
+                       "or use --no-server");
+        return;
+    }
+
+    Safety safety(config_);
+    for (const auto& root : request.roots) {
+        if (!root.is_absolute()) {
+            send_error(fd, "Root is not an absolute path: " + root.string());
+            return;
+        }
+        if (auto reason = safety.check_root(root); !reason.empty()) {
+            send_error(fd, reason);
+            return;
+        }
+    }
+
+    bool cached = false;
+    bool shared = false;
+    auto inventory = obtain(request, cached, shared);
+
+    // Stream targets as the walk finds them; joiners catch up from the start
+    std::size_t sent = 0;
+    std::string batch;
+    for (;;) {
+        std::unique_lock<std::mutex> lock(inventory->mutex);
+        inventory->cv.wait(lock, [&] { return sent < inventory->targets.size() || inventory->done; });
+        std::size_t end = std::min(inventory->targets.size(), sent + STREAM_BATCH);
+        for (; sent < end; ++sent) {
+            protocol::Writer out;
+            encode_target(out, inventory->targets[sent]);
+            protocol::append_frame(batch, protocol::MessageType::Target, out.data());
+        }
+        bool finished = inventory->done && sent == inventory->targets.size();
+        lock.unlock();
+
+        if (!batch.empty()) {
+            if (!protocol::write_all(fd, batch)) return;
+            batch.clear();
+        }
+        if (finished) break;
+    }
+
+    // done is set once, under the mutex observed above; nothing changes after
+    if (!inventory->error.empty()) {
+        send_error(fd, inventory->error);
+        return;
+    }
+    protocol::Writer out;
+    encode_scan_summary(out, inventory->summary, cached, shared);
+    protocol::write_frame(fd, protocol::MessageType::ScanSummary, out.data());
+
+    NUKE_DETAIL("scan {}: {} targets{}", join_paths(request.roots), sent,
+                cached ? " (inventory)" : shared ? " (joined a walk)" : "");
+}
+
+std::shared_ptr<ScanServer::Inventory> ScanServer::obtain(const ScanRequest& request, bool& cached,
+                                                          bool& shared) {
+    std::string key = request.key();
+    auto now = std::chrono::steady_clock::now();
+
+    std::lock_guard<std::mutex> lock(inventory_mutex_);
+
+    // Expired answers would otherwise stay for the life of the server
+    for (auto it = inventory_.begin(); it != inventory_.end();) {
+        std::lock_guard<std::mutex> entry_lock(it->second->mutex);
+        bool expired = it->second->done && now - it->second->finished >= options_.ttl;
+        it = expired ? inventory_.erase(it) : std::next(it);
+    }
+
+    if (auto it = inventory_.find(key); it != inventory_.end()) {
+        auto inventory = it->second;
+        std::lock_guard<std::mutex> entry_lock(inventory->mutex);
+        if (!inventory->done) {
+            shared = true;
+            return inventory;
+        }
+        if (!request.fresh && inventory->error.empty() && inventory->summary.complete) {
+            cached = true;
+            return inventory;
+        }
+    }
+
+    auto inventory = std::make_shared<Inventory>();
+    inventory->roots = request.roots;
+    inventory_[key] = inventory;
+    {
+        std::lock_guard<std::mutex> state_lock(state_mutex_);
+        ++walks_;
+    }
+    std::thread(&ScanServer::walk, this, request, inventory).detach();
+    return inventory;
+}
+
+void ScanServer::walk(ScanRequest request, std::shared_ptr<Inventory> inventory) {
+    ScanResult result;
+    std::string error;
+    try {
+        Scanner scanner(config_);
+        scanner.set_size_range(request.min_bytes, request.max_bytes);
+        scanner.set_top(static_cast<std::size_t>(request.top));
+        scanner.set_one_file_system(request.one_file_system);
+        scanner.set_estimate(request.estimate);
+        if (request.older_than_hours > 0) {
+            scanner.set_older_than(std::chrono::hours(request.older_than_hours));
+        }
+        // The inventory keeps the rows; the scanner only totals them
+        scanner.set_retain_targets(false);
+        scanner.set_target_callback([&inventory](const TargetEntry& target) {
+            {
+                std::lock_guard<std::mutex> lock(inventory->mutex);
+                inventory->targets.push_back(target);
+            }
+            inventory->cv.notify_all();
+        });
+
+        // Distinct walks take turns for a slot, so a burst of requests does
+        // not multiply the load on the disks
+        bool start = false;
+        {
+            std::unique_lock<std::mutex> lock(state_mutex_);
+            state_cv_.wait(lock, [this] { return walking_ < options_.max_walks || stopping_.load(); });
+            if (!stopping_.load()) {
+                ++walking_;
+                scanners_.push_back(&scanner);
+                start = true;
+            }
+        }
+
+        if (start) {
+            try {
+                result = scanner.scan(request.roots, request.max_depth);
+            } catch (const std::exception& e) {
+                error = std::string("Scan failed: ") + e.what();
+            }
+            std::lock_guard<std::mutex> lock(state_mutex_);
+            --walking_;
+            scanners_.erase(std::find(scanners_.begin(), scanners_.end(), &scanner));
+        } else {
+            error = "The server is shutting down";
+        }
+    } catch (const std::exception& e) {
+        error = std::string("Scan failed: ") + e.what();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(inventory->mutex);
+        result.targets.clear();
+        result.store.reset();
+        inventory->summary = std::move(result);
+        inventory->error = std::move(error);
+        inventory->finished = std::chrono::steady_clock::now();
+        inventory->done = true;
+    }
+    inventory->cv.notify_all();
+
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    --walks_;
+    state_cv_.notify_all();
+}
+
+void ScanServer::handle_delete(int fd, protocol::Reader& in) {
+    std::uint32_t count = in.u32();
+    std::vector<TargetEntry> targets;
+    for (std::uint32_t i = 0; i < count && in.ok(); ++i) {
+        TargetEntry target;
+        if (decode_target(in, target)) {
+            targets.push_back(std::move(target));
+        }
+    }
+    if (!in.done()) {
+        send_error(fd, "Malformed delete request");
+        return;
+    }
+
+    // The client checked too, but the server deletes with its own rights
+    auto rejected = Safety(config_).validate(targets);
+
+    auto locked = lock_paths(targets);
+    DeletionResult result;
+    try {
+        result = Destroyer(config_).destroy_all(targets);
+    } catch (...) {
+        unlock_paths(locked);
+        invalidate(targets);
+        throw;
+    }
+    unlock_paths(locked);
+    // Also after a partial failure: the trees are no longer what was walked
+    invalidate(targets);
+
+    for (const auto& rejection : rejected) {
+        result.skipped.push_back(rejection.target.path.string() + ": " + rejection.reason);
+        result.skipped_count++;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(delete_mutex_);
+        CostModel cost_model;
+        cost_model.load();
+        if (cost_model.observe(result)) {
+            cost_model.save();
+        }
+    }
+
+    protocol::Writer out;
+    encode_deletion(out, result);
+    protocol::write_frame(fd, protocol::MessageType::DeletionSummary, out.data());
+
+    NUKE_DETAIL("delete: {} deleted, {} failed, {} skipped", result.deleted_count,
+                result.failed_count, result.skipped_count);
+}
+
+void ScanServer::invalidate(const std::vector<TargetEntry>& deleted) {
+    std::lock_guard<std::mutex> lock(inventory_mutex_);
+    for (auto it = inventory_.begin(); it != inventory_.end();) {
+        // roots never change after the entry is created
+        bool stale = std::any_of(it->second->roots.begin(), it->second->roots.end(),
+            [&deleted](const fs::path& root) {
+                return std::any_of(deleted.begin(), deleted.end(), [&root](const TargetEntry& target) {
+                    return nested(root, target.path);
+                });
+            });
+        // A running walk still answers the requests already waiting on it
+        it = stale ? inventory_.erase(it) : std::next(it);
+    }
+}
+
+std::list<ScanServer::PathSet>::iterator ScanServer::lock_paths(const std::vector<TargetEntry>& targets) {
+    PathSet wanted;
+    for (const auto& target : targets) {
+        wanted.insert(lock_key(target.path));
+    }
+
+    std::unique_lock<std::mutex> lock(delete_mutex_);
+    delete_cv_.wait(lock, [&] {
+        return std::none_of(deleting_.begin(), deleting_.end(),
+                            [&wanted](const PathSet& held) { return overlaps(wanted, held); });
+    });
+    deleting_.push_back(std::move(wanted));
+    return std::prev(deleting_.end());
+}
+
+void ScanServer::unlock_paths(std::list<PathSet>::iterator locked) {
+    {
+        std::lock_guard<std::mutex> lock(delete_mutex_);
+        deleting_.erase(locked);
+    }
+    delete_cv_.notify_all();
+}
+
+// ============================================================================
+// Scan Client
+// ============================================================================
+ScanClient::ScanClient(fs::path socket_path) : socket_path_(std::move(socket_path)) {}
+
+int ScanClient::open() const {
+#ifdef _WIN32
+    return -1;
+#else
+    sockaddr_un addr;
+    if (!make_address(socket_path_, addr)) {
+        return -1;
+    }
+    int fd = open_socket();
+    if (fd < 0) {
+        return -1;
+    }
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    if (!peer_is_us(fd)) {
+        Logger::instance().warning("Ignoring " + socket_path_.string() +
+                                   ": the server listening there runs as another user");
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+#endif
+}
+
+bool ScanClient::available() const {
+    SocketCloser socket{open()};
+    return socket.fd >= 0;
+}
+
+bool ScanClient::matches(std::uint64_t fingerprint) {
+    SocketCloser socket{open()};
+    if (socket.fd < 0) {
+        error_ = "No server listening on " + socket_path_.string();
+        return false;
+    }
+
+    protocol::Writer out;
+    out.u16(protocol::VERSION);
+    out.u64(fingerprint);
+    protocol::MessageType type;
+    std::string payload;
+    if (!protocol::write_frame(socket.fd, protocol::MessageType::Handshake, out.data()) ||
+        !protocol::read_frame(socket.fd, type, payload)) {
+        error_ = "Lost the connection to the server";
+        return false;
+    }
+    protocol::Reader in(payload);
+    if (type == protocol::MessageType::Error) {
+        error_ = in.str();
+        return false;
+    }
+    std::uint64_t theirs = in.u64();
+    if (type != protocol::MessageType::Handshake || !in.done()) {
+        error_ = "Unexpected reply from the server";
+        return false;
+    }
+    if (theirs != fingerprint) {
+        error_ = "The server scans with a different configuration";
+        return false;
+    }
+    return true;
+}
+
+bool ScanClient::scan(const ScanRequest& request, const TargetCallback& on_target, ScanReply& reply) {
+    SocketCloser socket{open()};
+    if (socket.fd < 0) {
+        error_ = "No server listening on " + socket_path_.string();
+        return false;
+    }
+
+    protocol::Writer out;
+    out.u16(protocol::VERSION);
+    request.encode(out);
+    if (!protocol::write_frame(socket.fd, protocol::MessageType::ScanRequest, out.data())) {
+        error_ = "Cannot send the request to the server";
+        return false;
+    }
+
+    reply = ScanReply{};
+    protocol::MessageType type;
+    std::string payload;
+    while (protocol::read_frame(socket.fd, type, payload)) {
+        protocol::Reader in(payload);
+        switch (type) {
+            case protocol::MessageType::Target: {
+                TargetEntry target;
+                if (!decode_target(in, target)) break;
+                if (on_target) {
+                    on_target(target);
+                } else {
+                    reply.result.targets.push_back(std::move(target));
+                }
+                continue;
+            }
+            case protocol::MessageType::ScanSummary:
+                if (!decode_scan_summary(in, reply)) break;
+                return true;
+            case protocol::MessageType::Error:
+                error_ = in.str();
+                return false;
+            default:
+                break;
+        }
+        error_ = "Unexpected reply from the server";
+        return false;
+    }
+    error_ = "Lost the connection to the server";
+    return false;
+}
+
+bool ScanClient::destroy(const std::vector<TargetEntry>& targets, DeletionResult& result) {
+    SocketCloser socket{open()};
+    if (socket.fd < 0) {
+        error_ = "No server listening on " + socket_path_.string();
+        return false;
+    }
+
+    protocol::Writer out;
+    out.u16(protocol::VERSION);
+    out.u32(static_cast<std::uint32_t>(targets.size()));
+    for (const auto& target : targets) {
+        encode_target(out, target);
+    }
+    if (!protocol::write_frame(socket.fd, protocol::MessageType::DeleteRequest, out.data())) {
+        error_ = "Cannot send the request to the server";
+        return false;
+    }
+
+    // No reply until every target is done; that can take a while
+    protocol::MessageType type;
+    std::string payload;
+    if (!protocol::read_frame(socket.fd, type, payload)) {
+        error_ = "Lost the connection to the server";
+        return false;
+    }
+    protocol::Reader in(payload);
+    if (type == protocol::MessageType::Error) {
+        error_ = in.str();
+        return false;
+    }
+    result = DeletionResult{};
+    if (type != protocol::MessageType::DeletionSummary || !decode_deletion(in, result)) {
+        error_ = "Unexpected reply from the server";
+        return false;
+    }
+    return true;
+}
+
+} // namespace nuke
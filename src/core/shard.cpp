@@ -0,0 +1,286 @@
+#include "nuke/core/shard.hpp"
+#include "nuke/core/mount_table.hpp"
+#include "nuke/ui/logger.hpp"
+#include "nuke/utils/profiler.hpp"
+#include <fmt/core.h>
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <sstream>
+
+namespace nuke {
+
+namespace {
+    struct Listing {
+        std::vector<fs::path> dirs;
+        std::vector<fs::path> targets;
+    };
+
+    // Classifies entries exactly as Scanner::visit_directory does, sorted so
+    // every machine sees the same order
+    Listing list_directory(const fs::path& dir, const Config& config, const MountTable& mounts) {
+        Listing listing;
+        try {
+            fs::directory_iterator it;
+            {
+                NUKE_PROFILE(OpenDir);
+                it = fs::directory_iterator(dir, fs::directory_options::skip_permission_denied);
+            }
+            for (; it != fs::directory_iterator(); ++it) {
+                try {
+                    if (!it->is_directory()) continue;
+                    auto name = it->path().filename().string();
+                    if (config.is_ignored(name)) continue;
+                    if (auto* mount = mounts.find(it->path());
+                        mount && config.is_skipped_filesystem(mount->fs_type)) {
+                        continue;
+                    }
+                    (config.is_target(name) ? listing.targets : listing.dirs).push_back(it->path());
+                } catch (...) {}
+            }
+        } catch (const std::exception& e) {
+            NUKE_DIAG("Shard plan: cannot read {}: {}", dir.string(), e.what());
+        }
+        std::sort(listing.dirs.begin(), listing.dirs.end());
+        std::sort(listing.targets.begin(), listing.targets.end());
+        return listing;
+    }
+
+    std::string unit_key(std::size_t root_index, const fs::path& root, const fs::path& path) {
+        auto relative = path.lexically_relative(root).generic_u8string();
+        if (relative == u8".") relative.clear();
+        return std::to_string(root_index) + ":" + std::string(relative.begin(), relative.end());
+    }
+}
+
+// ============================================================================
+// ShardSpec
+// ============================================================================
+
+std::optional<ShardSpec> ShardSpec::parse(const std::string& text) {
+    auto slash = text.find('/');
+    if (slash == std::string::npos) return std::nullopt;
+    try {
+        std::size_t used = 0;
+        auto index = std::stoul(text.substr(0, slash), &used);
+        if (used != slash) return std::nullopt;
+        auto count = std::stoul(text.substr(slash + 1), &used);
+        if (used != text.size() - slash - 1) return std::nullopt;
+        if (count == 0 || index >= count || count > UINT32_MAX) return std::nullopt;
+        return ShardSpec{static_cast<std::uint32_t>(index), static_cast<std::uint32_t>(count)};
+    } catch (...) {
+        return std::nullopt;
+    }
+}
+
+std::string ShardSpec::to_string() const {
+    return std::to_string(index) + "/" + std::to_string(count);
+}
+
+// ============================================================================
+// ShardPlan
+// ============================================================================
+
+ShardPlan ShardPlan::build(const std::vector<fs::path>& roots, int max_depth, std::uint32_t shards,
+                           const Config& config) {
+    ShardPlan plan;
+    plan.roots = roots;
+    plan.max_depth = max_depth;
+    plan.shards = std::max<std::uint32_t>(shards, 1);
+
+    struct Candidate {
+        ScanCheckpoint::Kind kind;
+        int depth;
+        fs::path path;
+        std::size_t root;
+        Listing listing;  // Read once, reused if this unit is split
+    };
+    std::vector<Candidate> candidates;
+    auto mounts = MountTable::load();
+    for (std::size_t r = 0; r < roots.size(); ++r) {
+        candidates.push_back({ScanCheckpoint::Kind::Directory, 0, roots[r], r,
+                              list_directory(roots[r], config, mounts)});
+    }
+
+    // A split only reaches subdirectories the scan itself would visit
+    auto splittable = [max_depth](const Candidate& c) {
+        return c.kind == ScanCheckpoint::Kind::Directory && c.depth < MAX_SPLIT_DEPTH &&
+               (max_depth < 0 || c.depth + 1 <= max_depth) &&
+               !(c.listing.dirs.empty() && c.listing.targets.empty());
+    };
+    auto fanout = [](const Candidate& c) { return c.listing.dirs.size() + c.listing.targets.size(); };
+
+    std::size_t wanted = plan.shards > 1 ? plan.shards * UNITS_PER_SHARD : 1;
+    while (candidates.size() < wanted) {
+        auto best = candidates.end();
+        for (auto it = candidates.begin(); it != candidates.end(); ++it) {
+            if (!splittable(*it)) continue;
+            if (best == candidates.end() || fanout(*it) > fanout(*best) ||
+                (fanout(*it) == fanout(*best) && it->path < best->path)) {
+                best = it;
+            }
+        }
+        if (best == candidates.end()) break;
+
+        Candidate parent = std::move(*best);
+        candidates.erase(best);
+        for (auto& target : parent.listing.targets) {
+            candidates.push_back({ScanCheckpoint::Kind::Target, parent.depth, std::move(target),
+                                  parent.root, {}});
+        }
+        for (auto& dir : parent.listing.dirs) {
+            auto listing = list_directory(dir, config, mounts);
+            candidates.push_back({ScanCheckpoint::Kind::Directory, parent.depth + 1, std::move(dir),
+                                  parent.root, std::move(listing)});
+        }
+    }
+
+    for (auto& candidate : candidates) {
+        Unit unit;
+        unit.kind = candidate.kind;
+        unit.depth = candidate.depth;
+        unit.key = unit_key(candidate.root, roots[candidate.root], candidate.path);
+        unit.path = std::move(candidate.path);
+        unit.owner = static_cast<std::uint32_t>(fnv1a(unit.key) % plan.shards);
+        plan.units.push_back(std::move(unit));
+    }
+    std::sort(plan.units.begin(), plan.units.end(),
+              [](const Unit& a, const Unit& b) { return a.key < b.key; });
+
+    std::uint64_t hash = fnv1a(std::to_string(plan.shards) + "/" + std::to_string(max_depth));
+    for (const auto& unit : plan.units) {
+        hash = fnv1a(fmt::format("\n{}{}{}", static_cast<int>(unit.kind), unit.depth, unit.key), hash);
+    }
+    plan.fingerprint = hash;
+
+    NUKE_DIAG("Shard plan: {} units over {} shards (fingerprint {:016x})", plan.units.size(),
+              plan.shards, plan.fingerprint);
+    return plan;
+}
+
+ScanCheckpoint ShardPlan::checkpoint_for(std::uint32_t shard) const {
+    ScanCheckpoint start;
+    start.roots = roots;
+    start.max_depth = max_depth;
+    for (const auto& unit : units) {
+        if (unit.owner == shard) {
+            start.pending.push_back({unit.kind, unit.depth, unit.path});
+        }
+    }
+    return start;
+}
+
+// ============================================================================
+// ShardResult
+// ============================================================================
+
+bool ShardResult::load(const fs::path& path) {
+    try {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) return false;
+        std::stringstream content;
+        content << file.rdbuf();
+
+        *this = ShardResult{};
+        bool has_spec = false;
+        std::string line;
+        while (std::getline(content, line)) {
+            auto pos = line.find('=');
+            if (line.empty() || line[0] == '#' || pos == std::string::npos) continue;
+
+            std::string key = line.substr(0, pos);
+            std::string value = line.substr(pos + 1);
+            if (key == "shard") {
+                auto parsed = ShardSpec::parse(value);
+                if (!parsed) return false;
+                spec = *parsed;
+                has_spec = true;
+            } else if (key == "plan") {
+                std::istringstream fields(value);
+                fields >> std::hex >> fingerprint >> std::dec >> plan_units;
+            } else if (key == "duration_ms") {
+                duration = std::chrono::milliseconds(std::stoll(value));
+            } else if (key == "unit") {
+                auto key = unescape_path(value).u8string();
+                covered.emplace_back(key.begin(), key.end());
+            }
+        }
+
+        content.clear();
+        content.seekg(0);
+        return has_spec && state.read(content);
+    } catch (...) {
+        return false;
+    }
+}
+
+bool ShardResult::save(const fs::path& path) const {
+    try {
+        if (path.has_parent_path()) {
+            fs::create_directories(path.parent_path());
+        }
+
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file) return false;
+
+        file << "# NUKE shard result (combine with 'nuke merge')\n";
+        file << "shard=" << spec.to_string() << "\n";
+        file << "plan=" << fmt::format("{:016x}", fingerprint) << " " << plan_units << "\n";
+        file << "duration_ms=" << duration.count() << "\n";
+        for (const auto& key : covered) {
+            file << "unit=" << escape_path(fs::path(std::u8string(key.begin(), key.end()))) << "\n";
+        }
+        return state.write(file);
+    } catch (...) {
+        return false;
+    }
+}
+
+std::vector<std::string> verify_shards(const std::vector<ShardResult>& shards) {
+    std::vector<std::string> problems;
+    if (shards.empty()) {
+        problems.push_back("No shard results given");
+        return problems;
+    }
+
+    const ShardResult& first = shards.front();
+    std::map<std::uint32_t, std::size_t> seen;
+    std::map<std::string, std::uint32_t> owners;
+    for (const auto& shard : shards) {
+        if (shard.spec.count != first.spec.count || shard.fingerprint != first.fingerprint ||
+            shard.state.roots != first.state.roots) {
+            problems.push_back(fmt::format("Shard {} followed a different plan than shard {} "
+                                           "(the tree changed or the options differ)",
+                                           shard.spec.to_string(), first.spec.to_string()));
+            continue;
+        }
+        if (seen[shard.spec.index]++ > 0) {
+            problems.push_back(fmt::format("Shard {} given more than once", shard.spec.to_string()));
+            continue;
+        }
+        if (!shard.state.pending.empty()) {
+            problems.push_back(fmt::format("Shard {} is incomplete ({} directories left)",
+                                           shard.spec.to_string(), shard.state.pending.size()));
+        }
+        for (const auto& key : shard.covered) {
+            auto [it, inserted] = owners.emplace(key, shard.spec.index);
+            if (!inserted) {
+                problems.push_back(fmt::format("'{}' scanned by shards {} and {}", key, it->second,
+                                               shard.spec.index));
+            }
+        }
+    }
+
+    for (std::uint32_t i = 0; i < first.spec.count; ++i) {
+        if (seen.find(i) == seen.end()) {
+            problems.push_back(fmt::format("Shard {}/{} is missing", i, first.spec.count));
+        }
+    }
+    if (problems.empty() && owners.size() != first.plan_units) {
+        problems.push_back(fmt::format("Shards cover {} of {} planned units", owners.size(),
+                                       first.plan_units));
+    }
+    return problems;
+}
+
+} // namespace nuke
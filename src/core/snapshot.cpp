@@ -0,0 +1,484 @@
+#include "nuke/core/snapshot.hpp"
+#include "nuke/core/target_store.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstdio>
+#include <cstring>
+#include <numeric>
+#include <utility>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace nuke {
+
+namespace {
+    constexpr char MAGIC[8] = {'N', 'U', 'K', 'E', 'S', 'N', 'A', 'P'};
+
+    enum Section : std::uint32_t {
+        BYTES, SHARED, MTIMES, FILES, DIRS, TYPES, RESTARTS, PATHS, SECTION_COUNT
+    };
+
+    constexpr std::uint32_t COMPLETE = 1;
+    constexpr std::uint32_t ESTIMATED = 2;
+
+    struct SectionEntry {
+        std::uint64_t offset;
+        std::uint64_t size;
+    };
+
+    struct Header {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t flags;
+        std::uint64_t count;
+        std::int64_t created;        // Unix seconds
+        std::uint64_t total_size;    // ScanResult::total_size
+        std::uint64_t file_size;     // Catches a truncated copy
+        std::uint32_t restart_interval;
+        std::uint32_t reserved;
+        SectionEntry sections[SECTION_COUNT];
+    };
+    static_assert(sizeof(Header) % 8 == 0);
+
+    constexpr bool little_endian = std::endian::native == std::endian::little;
+
+    std::size_t align8(std::size_t n) {
+        return (n + 7) & ~std::size_t{7};
+    }
+
+    void put_varint(std::string& out, std::uint64_t value) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<char>(value));
+    }
+
+    bool get_varint(const std::uint8_t*& pos, const std::uint8_t* end, std::uint64_t& value) {
+        value = 0;
+        for (int shift = 0; shift < 64 && pos < end; shift += 7) {
+            std::uint8_t byte = *pos++;
+            value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) return true;
+        }
+        return false;
+    }
+
+    std::string utf8(const fs::path& path) {
+        auto u8 = path.u8string();
+        return std::string(u8.begin(), u8.end());
+    }
+
+    std::int64_t to_unix_seconds(std::chrono::system_clock::time_point tp) {
+        return std::chrono::duration_cast<std::chrono::seconds>(tp.time_since_epoch()).count();
+    }
+
+    // Columns gathered from either shape of ScanResult
+    struct Rows {
+        std::vector<std::string> paths;
+        std::vector<std::uint64_t> bytes, shared;
+        std::vector<std::int64_t> mtimes;
+        std::vector<std::uint32_t> files, dirs;
+        std::vector<std::uint8_t> types;
+
+        void add(std::string path, std::uint64_t size, std::uint64_t shared_size,
+                 std::chrono::system_clock::time_point mtime, std::size_t file_count,
+                 std::size_t dir_count, ProjectType type) {
+            paths.push_back(std::move(path));
+            bytes.push_back(size);
+            shared.push_back(shared_size);
+            mtimes.push_back(to_unix_seconds(mtime));
+            files.push_back(static_cast<std::uint32_t>(std::min<std::size_t>(file_count, UINT32_MAX)));
+            dirs.push_back(static_cast<std::uint32_t>(std::min<std::size_t>(dir_count, UINT32_MAX)));
+            types.push_back(static_cast<std::uint8_t>(type));
+        }
+    };
+
+    template <typename T>
+    void append_column(std::string& out, const std::vector<T>& values,
+                       const std::vector<std::uint32_t>& order, SectionEntry& section) {
+        out.resize(align8(out.size()));
+        section.offset = out.size();
+        section.size = values.size() * sizeof(T);
+        std::size_t at = out.size();
+        out.resize(at + section.size);
+        for (auto row : order) {
+            std::memcpy(&out[at], &values[row], sizeof(T));
+            at += sizeof(T);
+        }
+    }
+}
+
+// ============================================================================
+// Writing
+// ============================================================================
+bool Snapshot::save(const fs::path& file, const ScanResult& result) {
+    if constexpr (!little_endian) {
+        return false;
+    }
+
+    Rows rows;
+    if (result.store) {
+        const TargetStore& store = *result.store;
+        for (std::size_t i = 0; i < store.size(); ++i) {
+            rows.add(utf8(store.paths().path(store.node(i))), store.bytes(i), store.shared(i),
+                     store.last_modified(i), store.files(i), store.dirs(i),
+                     store.type(i));
+        }
+    } else {
+        for (const auto& target : result.targets) {
+            rows.add(utf8(target.path), target.size, target.shared_size, target.last_modified,
+                     target.file_count, target.dir_count, string_to_project_type(target.project_type));
+        }
+    }
+
+    std::vector<std::uint32_t> order(rows.paths.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&rows](std::uint32_t a, std::uint32_t b) {
+        return rows.paths[a] < rows.paths[b];
+    });
+
+    Header header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.flags = (result.complete ? COMPLETE : 0u) | (result.estimated ? ESTIMATED : 0u);
+    header.count = order.size();
+    header.created = to_unix_seconds(std::chrono::system_clock::now());
+    header.total_size = result.total_size;
+    header.restart_interval = RESTART_INTERVAL;
+
+    std::string out(sizeof(Header), '\0');
+    append_column(out, rows.bytes, order, header.sections[BYTES]);
+    append_column(out, rows.shared, order, header.sections[SHARED]);
+    append_column(out, rows.mtimes, order, header.sections[MTIMES]);
+    append_column(out, rows.files, order, header.sections[FILES]);
+    append_column(out, rows.dirs, order, header.sections[DIRS]);
+    append_column(out, rows.types, order, header.sections[TYPES]);
+
+    // Front-coded paths, with a restart point every RESTART_INTERVAL
+    std::string paths;
+    std::vector<std::uint64_t> restarts;
+    std::string_view previous;
+    for (std::size_t i = 0; i < order.size(); ++i) {
+        std::string_view path = rows.paths[order[i]];
+        std::size_t prefix = 0;
+        if (i % RESTART_INTERVAL == 0) {
+            restarts.push_back(paths.size());
+        } else {
+            auto limit = std::min(path.size(), previous.size());
+            while (prefix < limit && path[prefix] == previous[prefix]) ++prefix;
+        }
+        put_varint(paths, prefix);
+        put_varint(paths, path.size() - prefix);
+        paths.append(path.substr(prefix));
+        previous = path;
+    }
+    std::vector<std::uint32_t> identity(restarts.size());
+    std::iota(identity.begin(), identity.end(), 0);
+    append_column(out, restarts, identity, header.sections[RESTARTS]);
+    out.resize(align8(out.size()));
+    header.sections[PATHS] = {out.size(), paths.size()};
+    out += paths;
+
+    header.file_size = out.size();
+    std::memcpy(out.data(), &header, sizeof(Header));
+
+    // A reader (or a diff from cron) never sees a half-written file
+    fs::path temp = file;
+    temp += ".tmp";
+    std::FILE* handle = std::fopen(temp.string().c_str(), "wb");
+    if (!handle) {
+        return false;
+    }
+    bool written = std::fwrite(out.data(), 1, out.size(), handle) == out.size();
+    written = std::fclose(handle) == 0 && written;
+
+    std::error_code ec;
+    if (written) {
+        fs::rename(temp, file, ec);
+    }
+    if (!written || ec) {
+        fs::remove(temp, ec);
+        return false;
+    }
+    return true;
+}
+
+// ============================================================================
+// Mapping
+// ============================================================================
+Snapshot::~Snapshot() {
+    unmap();
+}
+
+Snapshot::Snapshot(Snapshot&& other) noexcept {
+    *this = std::move(other);
+}
+
+Snapshot& Snapshot::operator=(Snapshot&& other) noexcept {
+    if (this != &other) {
+        unmap();
+        error_ = std::move(other.error_);
+        base_ = std::exchange(other.base_, nullptr);
+        length_ = std::exchange(other.length_, 0);
+        mapping_ = std::exchange(other.mapping_, nullptr);
+        count_ = std::exchange(other.count_, 0);
+        bytes_ = other.bytes_;
+        shared_ = other.shared_;
+        mtimes_ = other.mtimes_;
+        files_ = other.files_;
+        dirs_ = other.dirs_;
+        types_ = other.types_;
+        restarts_ = other.restarts_;
+        paths_ = other.paths_;
+        paths_size_ = other.paths_size_;
+    }
+    return *this;
+}
+
+void Snapshot::unmap() {
+    if (!base_) return;
+#ifdef _WIN32
+    UnmapViewOfFile(base_);
+    CloseHandle(static_cast<HANDLE>(mapping_));
+#else
+    ::munmap(const_cast<std::uint8_t*>(base_), length_);
+#endif
+    base_ = nullptr;
+    mapping_ = nullptr;
+    length_ = 0;
+    count_ = 0;
+}
+
+bool Snapshot::load(const fs::path& file) {
+    unmap();
+    error_.clear();
+
+    if constexpr (!little_endian) {
+        error_ = "Snapshots can only be read on little-endian machines";
+        return false;
+    }
+
+#ifdef _WIN32
+    HANDLE handle = CreateFileW(file.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+                                OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) {
+        error_ = "Cannot open " + file.string();
+        return false;
+    }
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(handle, &file_size) || file_size.QuadPart < static_cast<LONGLONG>(sizeof(Header))) {
+        CloseHandle(handle);
+        error_ = "Not a snapshot: " + file.string();
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingW(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(handle);
+    const void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (!view) {
+        if (mapping) CloseHandle(mapping);
+        error_ = "Cannot map " + file.string();
+        return false;
+    }
+    base_ = static_cast<const std::uint8_t*>(view);
+    length_ = static_cast<std::size_t>(file_size.QuadPart);
+    mapping_ = mapping;
+#else
+    int fd = ::open(file.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        error_ = "Cannot open " + file.string();
+        return false;
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(Header))) {
+        ::close(fd);
+        error_ = "Not a snapshot: " + file.string();
+        return false;
+    }
+    void* view = ::mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (view == MAP_FAILED) {
+        error_ = "Cannot map " + file.string();
+        return false;
+    }
+    base_ = static_cast<const std::uint8_t*>(view);
+    length_ = static_cast<std::size_t>(st.st_size);
+#endif
+
+    Header header;
+    std::memcpy(&header, base_, sizeof(Header));
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) {
+        error_ = "Not a snapshot: " + file.string();
+    } else if (header.version != VERSION) {
+        error_ = "Unsupported snapshot version " + std::to_string(header.version) + ": " + file.string();
+    } else if (header.file_size != length_ || header.restart_interval != RESTART_INTERVAL) {
+        error_ = "Truncated or damaged snapshot: " + file.string();
+    }
+
+    // Every column must lie inside the file, aligned, and hold count entries
+    std::uint64_t count = header.count;
+    std::uint64_t blocks = (count + RESTART_INTERVAL - 1) / RESTART_INTERVAL;
+    const std::uint64_t widths[SECTION_COUNT] = {8, 8, 8, 4, 4, 1, 8, 0};
+    for (std::uint32_t s = 0; s < SECTION_COUNT && error_.empty(); ++s) {
+        const auto& section = header.sections[s];
+        std::uint64_t expected = s == RESTARTS ? blocks * 8 : count * widths[s];
+        bool fits = section.offset % 8 == 0 && section.offset >= sizeof(Header) &&
+                    section.offset <= length_ && section.size <= length_ - section.offset;
+        if (!fits || (s != PATHS && section.size != expected) || count > length_) {
+            error_ = "Truncated or damaged snapshot: " + file.string();
+        }
+    }
+    if (!error_.empty()) {
+        unmap();
+        return false;
+    }
+
+    auto at = [this, &header](Section s) { return base_ + header.sections[s].offset; };
+    count_ = static_cast<std::size_t>(count);
+    bytes_ = reinterpret_cast<const std::uint64_t*>(at(BYTES));
+    shared_ = reinterpret_cast<const std::uint64_t*>(at(SHARED));
+    mtimes_ = reinterpret_cast<const std::int64_t*>(at(MTIMES));
+    files_ = reinterpret_cast<const std::uint32_t*>(at(FILES));
+    dirs_ = reinterpret_cast<const std::uint32_t*>(at(DIRS));
+    types_ = at(TYPES);
+    restarts_ = reinterpret_cast<const std::uint64_t*>(at(RESTARTS));
+    paths_ = at(PATHS);
+    paths_size_ = static_cast<std::size_t>(header.sections[PATHS].size);
+    return true;
+}
+
+std::chrono::system_clock::time_point Snapshot::created() const {
+    Header header;
+    std::memcpy(&header, base_, sizeof(Header));
+    return std::chrono::system_clock::time_point(std::chrono::seconds(header.created));
+}
+
+std::uint64_t Snapshot::total_size() const {
+    Header header;
+    std::memcpy(&header, base_, sizeof(Header));
+    return header.total_size;
+}
+
+bool Snapshot::complete() const {
+    Header header;
+    std::memcpy(&header, base_, sizeof(Header));
+    return (header.flags & COMPLETE) != 0;
+}
+
+bool Snapshot::estimated() const {
+    Header header;
+    std::memcpy(&header, base_, sizeof(Header));
+    return (header.flags & ESTIMATED) != 0;
+}
+
+// ============================================================================
+// Paths
+// ============================================================================
+Snapshot::Cursor::Cursor(const Snapshot& snapshot, std::size_t start)
+    : snapshot_(&snapshot), index_(start - start % RESTART_INTERVAL) {
+    skip_ = start - index_;
+    if (index_ < snapshot.count_) {
+        std::uint64_t offset = snapshot.restarts_[index_ / RESTART_INTERVAL];
+        if (offset <= snapshot.paths_size_) {
+            pos_ = snapshot.paths_ + offset;
+        }
+    }
+}
+
+bool Snapshot::Cursor::next() {
+    while (skip_ > 0) {
+        if (!decode()) return false;
+        --skip_;
+    }
+    return decode();
+}
+
+bool Snapshot::Cursor::decode() {
+    if (!pos_ || index_ >= snapshot_->count_) return false;
+
+    const std::uint8_t* end = snapshot_->paths_ + snapshot_->paths_size_;
+    std::uint64_t prefix = 0;
+    std::uint64_t suffix = 0;
+    if (!get_varint(pos_, end, prefix) || !get_varint(pos_, end, suffix) ||
+        prefix > path_.size() || suffix > static_cast<std::uint64_t>(end - pos_) ||
+        (index_ % RESTART_INTERVAL == 0 && prefix != 0)) {
+        pos_ = nullptr;
+        return false;
+    }
+    path_.resize(static_cast<std::size_t>(prefix));
+    path_.append(reinterpret_cast<const char*>(pos_), static_cast<std::size_t>(suffix));
+    pos_ += suffix;
+    ++index_;
+    return true;
+}
+
+std::string Snapshot::path(std::size_t i) const {
+    Cursor cursor(*this, i);
+    return cursor.next() ? std::string(cursor.path()) : std::string();
+}
+
+// ============================================================================
+// Diff
+// ============================================================================
+SnapshotDiff diff_snapshots(const Snapshot& before, const Snapshot& after, std::uint64_t min_delta) {
+    SnapshotDiff diff;
+    Snapshot::Cursor old_cursor(before);
+    Snapshot::Cursor new_cursor(after);
+    bool has_old = old_cursor.next();
+    bool has_new = new_cursor.next();
+
+    auto change = [&diff](SnapshotChange::Kind kind, std::string_view path, std::uint64_t old_bytes,
+                          std::uint64_t new_bytes, ProjectType type) {
+        diff.changes.push_back({kind, std::string(path), old_bytes, new_bytes, type});
+    };
+
+    while (has_old || has_new) {
+        int order = !has_old ? 1 : !has_new ? -1 : old_cursor.path().compare(new_cursor.path());
+        if (order < 0) {
+            std::size_t i = old_cursor.index();
+            diff.old_total += before.bytes(i);
+            diff.removed++;
+            change(SnapshotChange::Kind::Removed, old_cursor.path(), before.bytes(i), 0, before.type(i));
+            has_old = old_cursor.next();
+        } else if (order > 0) {
+            std::size_t j = new_cursor.index();
+            diff.new_total += after.bytes(j);
+            diff.added++;
+            change(SnapshotChange::Kind::Added, new_cursor.path(), 0, after.bytes(j), after.type(j));
+            has_new = new_cursor.next();
+        } else {
+            std::size_t i = old_cursor.index();
+            std::size_t j = new_cursor.index();
+            std::uint64_t old_bytes = before.bytes(i);
+            std::uint64_t new_bytes = after.bytes(j);
+            diff.old_total += old_bytes;
+            diff.new_total += new_bytes;
+            std::uint64_t moved = new_bytes > old_bytes ? new_bytes - old_bytes : old_bytes - new_bytes;
+            if (moved == 0 || moved < min_delta) {
+                diff.unchanged++;
+            } else if (new_bytes > old_bytes) {
+                diff.grown++;
+                change(SnapshotChange::Kind::Grown, new_cursor.path(), old_bytes, new_bytes, after.type(j));
+            } else {
+                diff.shrunk++;
+                change(SnapshotChange::Kind::Shrunk, new_cursor.path(), old_bytes, new_bytes, after.type(j));
+            }
+            has_old = old_cursor.next();
+            has_new = new_cursor.next();
+        }
+    }
+
+    // A cursor stops early only on a damaged path
+    std::size_t matched = diff.grown + diff.shrunk + diff.unchanged;
+    diff.corrupt = diff.removed + matched < before.size() || diff.added + matched < after.size();
+    return diff;
+}
+
+} // namespace nuke
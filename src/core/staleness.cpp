@@ -0,0 +1,87 @@
+#include "nuke/core/staleness.hpp"
+#include "nuke/utils/profiler.hpp"
+#include <algorithm>
+#include <deque>
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+
+namespace nuke {
+
+namespace {
+    using TimePoint = std::chrono::system_clock::time_point;
+
+    // One lstat (a symlinked marker counts by its own time, like a file
+    // the build wrote)
+    std::optional<TimePoint> mtime_of(const fs::path& path) {
+        NUKE_PROFILE(Stat);
+#ifdef _WIN32
+        std::error_code ec;
+        auto ftime = fs::last_write_time(path, ec);
+        if (ec) return std::nullopt;
+        return std::chrono::clock_cast<std::chrono::system_clock>(ftime);
+#else
+        struct stat info {};
+        if (::lstat(path.c_str(), &info) != 0) return std::nullopt;
+        auto since_epoch = std::chrono::seconds(info.st_mtim.tv_sec) +
+                           std::chrono::nanoseconds(info.st_mtim.tv_nsec);
+        return TimePoint(std::chrono::duration_cast<std::chrono::system_clock::duration>(since_epoch));
+#endif
+    }
+
+    void keep_newest(std::optional<TimePoint>& newest, std::optional<TimePoint> candidate) {
+        if (candidate && (!newest || *candidate > *newest)) {
+            newest = candidate;
+        }
+    }
+}
+
+std::optional<TimePoint> StalenessProbe::last_activity(const fs::path& target,
+                                                       const std::string& name) const {
+    const auto& markers = config_.staleness_markers();
+    if (auto it = markers.find(name); it != markers.end()) {
+        std::optional<TimePoint> newest;
+        for (const auto& marker : it->second) {
+            keep_newest(newest, mtime_of((target / marker).lexically_normal()));
+        }
+        if (newest) {
+            return newest;
+        }
+    }
+    return newest_within(target);
+}
+
+std::optional<TimePoint> StalenessProbe::newest_within(const fs::path& target) const {
+    std::optional<TimePoint> newest = mtime_of(target);
+    if (!newest) {
+        return std::nullopt;
+    }
+
+    // Breadth first, so the shallow entries that move with every build are
+    // seen before the cap
+    std::deque<std::pair<fs::path, int>> frontier{{target, 0}};
+    std::size_t entries = 0;
+    while (!frontier.empty() && entries < PROBE_ENTRIES) {
+        auto [dir, depth] = std::move(frontier.front());
+        frontier.pop_front();
+        if (depth >= config_.staleness_depth()) continue;
+
+        std::error_code ec;
+        fs::directory_iterator it;
+        {
+            NUKE_PROFILE(OpenDir);
+            it = fs::directory_iterator(dir, fs::directory_options::skip_permission_denied, ec);
+        }
+        for (; !ec && it != fs::directory_iterator() && entries < PROBE_ENTRIES; it.increment(ec)) {
+            ++entries;
+            keep_newest(newest, mtime_of(it->path()));
+            if (it->is_directory(ec) && !it->is_symlink(ec)) {
+                frontier.emplace_back(it->path(), depth + 1);
+            }
+        }
+    }
+    return newest;
+}
+
+} // namespace nuke
@@ -0,0 +1,228 @@
+#include "nuke/core/target_store.hpp"
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+namespace nuke {
+
+// ============================================================================
+// PathArena
+// ============================================================================
+
+std::uint32_t PathArena::add(std::uint32_t parent, std::string_view name) {
+    // Component names are bounded by the filesystem (255 bytes on most), but
+    // the root may be an arbitrary path; clamp rather than corrupt the arena.
+    if (name.size() > UINT16_MAX) {
+        name = name.substr(0, UINT16_MAX);
+    }
+
+    if (chunk_used_ + name.size() > CHUNK_SIZE) {
+        chunks_.push_back(std::make_unique<char[]>(CHUNK_SIZE));
+        chunk_used_ = 0;
+    }
+
+    auto chunk = static_cast<std::uint32_t>(chunks_.size() - 1);
+    std::memcpy(chunks_.back().get() + chunk_used_, name.data(), name.size());
+
+    auto id = static_cast<std::uint32_t>(parents_.size());
+    parents_.push_back(parent);
+    name_offsets_.push_back((chunk << CHUNK_BITS) | static_cast<std::uint32_t>(chunk_used_));
+    name_lengths_.push_back(static_cast<std::uint16_t>(name.size()));
+    chunk_used_ += name.size();
+    return id;
+}
+
+std::string_view PathArena::name(std::uint32_t id) const {
+    auto offset = name_offsets_[id];
+    const char* chunk = chunks_[offset >> CHUNK_BITS].get();
+    return {chunk + (offset & (CHUNK_SIZE - 1)), name_lengths_[id]};
+}
+
+fs::path PathArena::path(std::uint32_t id) const {
+    // Walk to the root first so the path is built front to back.
+    std::vector<std::uint32_t> chain;
+    for (auto node = id; node != NO_PARENT; node = parents_[node]) {
+        chain.push_back(node);
+    }
+
+    fs::path result;
+    for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+        auto component = name(*it);
+        result /= fs::path(std::u8string_view(reinterpret_cast<const char8_t*>(component.data()),
+                                              component.size()));
+    }
+    return result;
+}
+
+void PathArena::child_index(std::vector<std::uint32_t>& offsets,
+                            std::vector<std::uint32_t>& children) const {
+    auto n = static_cast<std::uint32_t>(parents_.size());
+    offsets.assign(n + 1, 0);
+    for (std::uint32_t i = 0; i < n; ++i) {
+        if (parents_[i] != NO_PARENT) offsets[parents_[i] + 1]++;
+    }
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+    children.resize(offsets[n]);
+    std::vector<std::uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for (std::uint32_t i = 0; i < n; ++i) {
+        if (parents_[i] != NO_PARENT) children[fill[parents_[i]]++] = i;
+    }
+}
+
+std::vector<std::uint32_t> PathArena::name_order() const {
+    std::vector<std::uint32_t> offsets;
+    std::vector<std::uint32_t> children;
+    child_index(offsets, children);
+
+    auto by_name = [this](std::uint32_t a, std::uint32_t b) { return name(a) < name(b); };
+
+    std::vector<std::uint32_t> roots;
+    for (std::uint32_t i = 0; i < parents_.size(); ++i) {
+        if (parents_[i] == NO_PARENT) roots.push_back(i);
+    }
+    std::sort(roots.begin(), roots.end(), by_name);
+
+    // Pre-order walk with siblings sorted by name gives each node its rank.
+    std::vector<std::uint32_t> rank(parents_.size(), 0);
+    std::vector<std::uint32_t> stack(roots.rbegin(), roots.rend());
+    std::uint32_t next = 0;
+    while (!stack.empty()) {
+        auto node = stack.back();
+        stack.pop_back();
+        rank[node] = next++;
+
+        auto first = children.begin() + offsets[node];
+        auto last = children.begin() + offsets[node + 1];
+        std::sort(first, last, by_name);
+        stack.insert(stack.end(), std::make_reverse_iterator(last),
+                     std::make_reverse_iterator(first));
+    }
+    return rank;
+}
+
+// ============================================================================
+// TargetStore
+// ============================================================================
+
+std::size_t TargetStore::add_target(std::uint32_t node, ProjectType type, std::uintmax_t bytes,
+                                    std::size_t files, std::size_t dirs,
+                                    std::chrono::system_clock::time_point last_modified,
+                                    std::uintmax_t size_error, std::uintmax_t shared, FileId id,
+                                    std::chrono::system_clock::time_point last_used) {
+    nodes_.push_back(node);
+    bytes_.push_back(bytes);
+    size_errors_.push_back(size_error);
+    shared_.push_back(shared);
+    ids_.push_back(id);
+    mtimes_.push_back(last_modified.time_since_epoch().count());
+    used_.push_back(last_used.time_since_epoch().count());
+    types_.push_back(type);
+    files_.push_back(static_cast<std::uint32_t>(std::min<std::size_t>(files, UINT32_MAX)));
+    dirs_.push_back(static_cast<std::uint32_t>(std::min<std::size_t>(dirs, UINT32_MAX)));
+    return nodes_.size() - 1;
+}
+
+void TargetStore::roll_up(std::uint32_t node, std::uintmax_t bytes) {
+    if (subtree_bytes_.size() < paths_.size()) {
+        subtree_bytes_.resize(paths_.size(), 0);
+        subtree_targets_.resize(paths_.size(), 0);
+    }
+    while (node != PathArena::NO_PARENT) {
+        subtree_bytes_[node] += bytes;
+        subtree_targets_[node]++;
+        node = paths_.parent(node);
+    }
+}
+
+std::chrono::system_clock::time_point TargetStore::last_modified(std::size_t i) const {
+    return std::chrono::system_clock::time_point(std::chrono::system_clock::duration(mtimes_[i]));
+}
+
+std::chrono::system_clock::time_point TargetStore::last_used(std::size_t i) const {
+    return std::chrono::system_clock::time_point(std::chrono::system_clock::duration(used_[i]));
+}
+
+TargetEntry TargetStore::entry(std::size_t i) const {
+    TargetEntry target;
+    target.path = paths_.path(nodes_[i]);
+    target.size = bytes_[i];
+    target.last_modified = last_modified(i);
+    target.last_used = last_used(i);
+    target.project_type = project_type_to_string(types_[i]);
+    target.file_count = files_[i];
+    target.dir_count = dirs_[i];
+    target.size_error = size_errors_[i];
+    target.shared_size = shared_[i];
+    target.id = ids_[i];
+    return target;
+}
+
+std::vector<TargetEntry> TargetStore::entries() const {
+    std::vector<TargetEntry> result;
+    result.reserve(size());
+    for (std::size_t i = 0; i < size(); ++i) {
+        result.push_back(entry(i));
+    }
+    return result;
+}
+
+std::vector<std::uint32_t> TargetStore::order_by(SortBy sort_by) const {
+    std::vector<std::uint32_t> order(size());
+    std::iota(order.begin(), order.end(), 0);
+
+    switch (sort_by) {
+        case SortBy::Size:
+            std::stable_sort(order.begin(), order.end(), [this](std::uint32_t a, std::uint32_t b) {
+                return bytes_[a] > bytes_[b];
+            });
+            break;
+        case SortBy::Name: {
+            auto rank = paths_.name_order();
+            std::sort(order.begin(), order.end(), [this, &rank](std::uint32_t a, std::uint32_t b) {
+                return rank[nodes_[a]] < rank[nodes_[b]];
+            });
+            break;
+        }
+        case SortBy::Date:
+            std::stable_sort(order.begin(), order.end(), [this](std::uint32_t a, std::uint32_t b) {
+                return mtimes_[a] < mtimes_[b];
+            });
+            break;
+    }
+    return order;
+}
+
+std::vector<std::uint32_t> TargetStore::compact(const std::vector<std::uint32_t>& rows) {
+    // Parents are always added before their children, so a single pass in
+    // id order keeps every surviving node's parent ahead of it.
+    std::vector<bool> keep(paths_.size(), false);
+    for (auto row : rows) {
+        for (auto node = nodes_[row]; node != PathArena::NO_PARENT && !keep[node];
+             node = paths_.parent(node)) {
+            keep[node] = true;
+        }
+    }
+
+    PathArena paths;
+    std::vector<std::uint32_t> node_map(paths_.size(), PathArena::NO_PARENT);
+    for (std::uint32_t id = 0; id < paths_.size(); ++id) {
+        if (!keep[id]) continue;
+        auto parent = paths_.parent(id);
+        node_map[id] = paths.add(parent == PathArena::NO_PARENT ? parent : node_map[parent],
+                                 paths_.name(id));
+    }
+
+    TargetStore kept;
+    kept.paths_ = std::move(paths);
+    for (auto row : rows) {
+        auto node = node_map[nodes_[row]];
+        kept.add_target(node, types_[row], bytes_[row], files_[row], dirs_[row], last_modified(row),
+                        size_errors_[row], shared_[row], ids_[row], last_used(row));
+        kept.roll_up(node, bytes_[row]);
+    }
+    *this = std::move(kept);
+    return node_map;
+}
+
+} // namespace nuke
@@ -10,41 +10,577 @@
 
 #include "nuke/types.hpp"
 #include "nuke/core/config.hpp"
+#include "nuke/core/cost_model.hpp"
 #include "nuke/core/scanner.hpp"
+#include "nuke/core/candidate_list.hpp"
 #include "nuke/core/destroyer.hpp"
+#include "nuke/core/guard.hpp"
+#include "nuke/core/quota.hpp"
+#include "nuke/core/root_set.hpp"
+#include "nuke/core/server.hpp"
+#include "nuke/core/shard.hpp"
+#include "nuke/core/snapshot.hpp"
+#include "nuke/ui/browser.hpp"
 #include "nuke/ui/display.hpp"
 #include "nuke/ui/logger.hpp"
+#include "nuke/ui/progress.hpp"
+#include "nuke/ui/result_writer.hpp"
+#include "nuke/utils/profiler.hpp"
 #include "nuke/utils/safety.hpp"
 #include "nuke/utils/stats.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <csignal>
+#include <cstdlib>
 #include <iostream>
+#include <optional>
 #include <string>
+#include <vector>
 #include <chrono>
 
 using namespace nuke;
 
+// ============================================================================
+// Target Selection (--top, --min-size, --max-size)
+// ============================================================================
+
+struct SelectionOptions {
+    std::size_t top = 0;
+    std::string min_size;
+    std::string max_size;
+    bool one_file_system = false;
+};
+
+void add_selection_options(CLI::App* cmd, SelectionOptions& options) {
+    cmd->add_option("--top", options.top, "Keep only the N largest targets");
+    cmd->add_option("--min-size", options.min_size, "Skip targets smaller than this (e.g., 100MB)");
+    cmd->add_option("--max-size", options.max_size, "Skip targets larger than this (e.g., 10GB)");
+    cmd->add_flag("--one-file-system,-x", options.one_file_system,
+                  "Do not cross into other filesystems below the root");
+}
+
+bool parse_size_range(const SelectionOptions& options, std::uintmax_t& min_bytes,
+                      std::uintmax_t& max_bytes) {
+    auto& logger = Logger::instance();
+    
+    min_bytes = 0;
+    max_bytes = UINTMAX_MAX;
+    if (!options.min_size.empty()) {
+        auto parsed = parse_bytes(options.min_size);
+        if (!parsed) {
+            logger.error("Invalid --min-size: " + options.min_size);
+            return false;
+        }
+        min_bytes = *parsed;
+    }
+    if (!options.max_size.empty()) {
+        auto parsed = parse_bytes(options.max_size);
+        if (!parsed) {
+            logger.error("Invalid --max-size: " + options.max_size);
+            return false;
+        }
+        max_bytes = *parsed;
+    }
+    if (min_bytes > max_bytes) {
+        logger.error("--min-size is larger than --max-size");
+        return false;
+    }
+    return true;
+}
+
+bool apply_selection(Scanner& scanner, const SelectionOptions& options) {
+    std::uintmax_t min_bytes = 0;
+    std::uintmax_t max_bytes = UINTMAX_MAX;
+    if (!parse_size_range(options, min_bytes, max_bytes)) {
+        return false;
+    }
+    
+    scanner.set_size_range(min_bytes, max_bytes);
+    scanner.set_top(options.top);
+    scanner.set_one_file_system(options.one_file_system);
+    return true;
+}
+
+// ============================================================================
+// Time Budget and Resume (--time-budget, --resume, Ctrl+C)
+// ============================================================================
+
+struct BudgetOptions {
+    std::string time_budget;
+    bool resume = false;
+    std::string checkpoint;
+};
+
+void add_budget_options(CLI::App* cmd, BudgetOptions& options) {
+    cmd->add_option("--time-budget", options.time_budget,
+                    "Stop after this long with partial results (e.g., 60s, 5m)");
+    cmd->add_flag("--resume", options.resume, "Continue the scan saved in the checkpoint");
+    cmd->add_option("--checkpoint", options.checkpoint, "Checkpoint file (default: next to config.yaml)");
+}
+
+static std::atomic<Scanner*> interrupted_scanner{nullptr};
+
+extern "C" void on_interrupt(int) {
+    // The first Ctrl+C ends the scan with a checkpoint; a second one kills
+    std::signal(SIGINT, SIG_DFL);
+    if (Scanner* scanner = interrupted_scanner.load()) {
+        scanner->cancel();
+    }
+}
+
+std::string join_roots(const std::vector<fs::path>& roots) {
+    std::string joined;
+    for (const auto& root : roots) {
+        joined += (joined.empty() ? "" : ", ") + root.string();
+    }
+    return joined;
+}
+
+// ============================================================================
+// Sharding (--shard i/N, --shard-out, nuke merge)
+// ============================================================================
+
+struct ShardOptions {
+    std::string shard;
+    std::string out;
+};
+
+void add_shard_options(CLI::App* cmd, ShardOptions& options) {
+    cmd->add_option("--shard", options.shard,
+                    "Scan only shard i of N (0-based, e.g. 2/8); combine with 'nuke merge'");
+    cmd->add_option("--shard-out", options.out,
+                    "Shard result file (default: nuke-shard-<i>-of-<N>.txt)");
+}
+
+// Writes what this shard covered and found for 'nuke merge'
+bool write_shard_result(const ShardOptions& options, const ShardSpec& spec, const ShardPlan& plan,
+                        const Scanner& scanner, const ScanResult& results) {
+    ShardResult shard;
+    shard.spec = spec;
+    shard.fingerprint = plan.fingerprint;
+    shard.plan_units = plan.units.size();
+    for (const auto& unit : plan.units) {
+        if (unit.owner == spec.index) shard.covered.push_back(unit.key);
+    }
+    shard.duration = results.scan_duration;
+    shard.state.roots = plan.roots;
+    shard.state.max_depth = plan.max_depth;
+    if (!results.complete) {
+        shard.state.pending = scanner.checkpoint().pending;
+    }
+    shard.state.found = results.store ? results.store->entries() : results.targets;
+    
+    fs::path path = options.out.empty()
+        ? fs::path(fmt::format("nuke-shard-{}-of-{}.txt", spec.index, spec.count))
+        : fs::path(options.out);
+    if (!shard.save(path)) {
+        Logger::instance().error("Failed to write shard result: " + path.string());
+        return false;
+    }
+    Logger::instance().normal(fmt::format("Shard {} written to {}", spec.to_string(), path.string()));
+    return true;
+}
+
+// Runs (or resumes) a scan; an incomplete one leaves a checkpoint behind.
+// Resuming a clean must target the same roots that were checkpointed. A
+// `start` checkpoint (a shard's units) replaces the plain walk of the roots.
+std::optional<ScanResult> run_scan(Scanner& scanner, const BudgetOptions& options,
+                                   const std::vector<fs::path>& roots, int max_depth,
+                                   bool require_same_root, const ScanCheckpoint* start = nullptr) {
+    auto& logger = Logger::instance();
+    
+    if (!options.time_budget.empty()) {
+        auto budget = parse_duration(options.time_budget);
+        if (!budget) {
+            logger.error("Invalid --time-budget: " + options.time_budget);
+            return std::nullopt;
+        }
+        scanner.set_time_budget(*budget);
+    }
+    
+    fs::path checkpoint_path = options.checkpoint.empty() ? Config::get_checkpoint_path()
+                                                          : fs::path(options.checkpoint);
+    ScanCheckpoint checkpoint;
+    if (options.resume) {
+        if (!checkpoint.load(checkpoint_path)) {
+            logger.error("No checkpoint to resume at: " + checkpoint_path.string());
+            return std::nullopt;
+        }
+        if (require_same_root && checkpoint.roots != roots) {
+            logger.error("Checkpoint is for " + join_roots(checkpoint.roots) + ", not " +
+                         join_roots(roots));
+            return std::nullopt;
+        }
+        logger.normal(fmt::format("Resuming scan of {} ({} directories left, {} targets found)",
+                                  join_roots(checkpoint.roots), checkpoint.pending.size(),
+                                  checkpoint.found.size()));
+    }
+    
+    interrupted_scanner.store(&scanner);
+    std::signal(SIGINT, on_interrupt);
+    ScanResult results = options.resume ? scanner.resume(checkpoint)
+                       : start      ? scanner.resume(*start)
+                                    : scanner.scan(roots, max_depth);
+    std::signal(SIGINT, SIG_DFL);
+    interrupted_scanner.store(nullptr);
+    
+    if (!results.complete) {
+        const auto& left = scanner.checkpoint();
+        if (left.save(checkpoint_path)) {
+            logger.warning(fmt::format("Scan incomplete: {} directories left. Continue with --resume ({})",
+                                       left.pending.size(), checkpoint_path.string()));
+        } else {
+            logger.error("Failed to write checkpoint: " + checkpoint_path.string());
+        }
+    } else if (options.resume) {
+        std::error_code ec;
+        fs::remove(checkpoint_path, ec);
+    }
+    return results;
+}
+
+// ============================================================================
+// Listed Candidates (--from-list)
+// ============================================================================
+
+struct ListSource {
+    std::string file;     // Empty walks the path instead
+    bool scoped = false;  // A path was given: only targets below it count
+};
+
+void add_list_source_option(CLI::App* cmd, ListSource& source) {
+    cmd->add_option("--from-list", source.file,
+                    "Size the targets named in a find/locate listing (NUL or newline separated, "
+                    "'-' for stdin) or an mlocate database instead of walking the tree");
+}
+
+// The listed targets as a scan to resume, below `path` when one was given
+// and otherwise below the deepest directory holding them all
+std::optional<ScanCheckpoint> plan_listed(const ListSource& source, const fs::path& path,
+                                          const Config& config) {
+    CandidateList list;
+    if (!CandidateList::read(source.file, config, list)) {
+        return std::nullopt;
+    }
+    fs::path root = source.scoped ? path.lexically_normal() : list.common_root();
+    auto start = list.plan(root.empty() ? std::vector<fs::path>{} : std::vector<fs::path>{root}, config);
+    Logger::instance().normal(fmt::format("Read {} entries ({}): {} targets to size", list.entries,
+                                          list.format, start.pending.size()));
+    return start;
+}
+
+// ============================================================================
+// Snapshots (--snapshot-out, nuke diff)
+// ============================================================================
+
+void add_snapshot_option(CLI::App* cmd, std::string& file) {
+    cmd->add_option("--snapshot-out", file, "Also save the targets to a snapshot file for 'nuke diff'");
+}
+
+bool write_snapshot(const std::string& file, const ScanResult& results) {
+    if (file.empty()) {
+        return true;
+    }
+    if (!Snapshot::save(file, results)) {
+        Logger::instance().error("Failed to write snapshot: " + file);
+        return false;
+    }
+    Logger::instance().normal("Snapshot written to " + file);
+    return true;
+}
+
+// ============================================================================
+// Scan Server (nuke serve, and the commands that hand their scans to it)
+// ============================================================================
+
+// Cleared by --no-server
+static bool use_server = true;
+
+// The running server, when this scan can go through it. Resumed and
+// budgeted scans keep their checkpoints local, so they always run here, and
+// so does a scan with another config than the server's (a project's own
+// nuke.config.yaml, or one edited since the server started).
+std::optional<ScanClient> find_server(const BudgetOptions& budget, const Config& config) {
+    if (!use_server || budget.resume || !budget.time_budget.empty()) {
+        return std::nullopt;
+    }
+    ScanClient client;
+    if (!client.available()) {
+        return std::nullopt;
+    }
+    if (!client.matches(config.scan_fingerprint())) {
+        NUKE_DETAIL("Scanning here, not with the server at {}: {}", client.socket_path().string(),
+                    client.error());
+        return std::nullopt;
+    }
+    NUKE_DIAG("Using the scan server at {}", client.socket_path().string());
+    return client;
+}
+
+// Roots must already be canonical, so equal scans from different working
+// directories share one walk in the server
+std::optional<ScanRequest> make_request(const std::vector<fs::path>& roots, int max_depth,
+                                        bool estimate, const SelectionOptions& selection,
+                                        const Config& config) {
+    ScanRequest request;
+    if (!parse_size_range(selection, request.min_bytes, request.max_bytes)) {
+        return std::nullopt;
+    }
+    request.config = config.scan_fingerprint();
+    request.roots = roots;
+    request.max_depth = max_depth;
+    request.estimate = estimate;
+    request.top = selection.top;
+    request.one_file_system = selection.one_file_system;
+    return request;
+}
+
+// Targets stream to `on_target`, or are kept in the result without one
+std::optional<ScanResult> run_remote_scan(ScanClient& client, const ScanRequest& request,
+                                          const ScanClient::TargetCallback& on_target = nullptr) {
+    auto& logger = Logger::instance();
+    
+    ScanReply reply;
+    if (!client.scan(request, on_target, reply)) {
+        logger.error("Scan server: " + client.error());
+        return std::nullopt;
+    }
+    if (reply.cached) {
+        NUKE_DETAIL("Answered from the scan server's inventory");
+    } else if (reply.shared) {
+        NUKE_DETAIL("Joined a scan already running in the server");
+    }
+    return std::move(reply.result);
+}
+
+// list and scout through the server: the same output as a local scan
+bool show_remote_scan(ScanClient& client, const ScanRequest& request, const std::string& command,
+                      SortBy sort, OutputFormat format, const std::string& snapshot_out) {
+    if (format != OutputFormat::Text) {
+        ResultWriter writer(format, command);
+        std::vector<TargetEntry> found;  // Only kept for the snapshot
+        auto scanned = run_remote_scan(client, request, [&](const TargetEntry& target) {
+            writer.write_target(target);
+            if (!snapshot_out.empty()) found.push_back(target);
+        });
+        if (!scanned) {
+            return false;
+        }
+        writer.write_scan_summary(*scanned);
+        scanned->targets = std::move(found);
+        return write_snapshot(snapshot_out, *scanned);
+    }
+    
+    auto scanned = run_remote_scan(client, request);
+    if (!scanned) {
+        return false;
+    }
+    Display::show_scan_results(*scanned, sort);
+    if (command == "scout" && scanned->total_count > 0) {
+        std::cout << Display::Color::dim("Use 'nuke clean <path>' to clean specific projects.") << std::endl;
+    }
+    return write_snapshot(snapshot_out, *scanned);
+}
+
+static std::atomic<ScanServer*> running_server{nullptr};
+
+extern "C" void on_stop_server(int) {
+    if (ScanServer* server = running_server.load()) {
+        server->stop();
+    }
+}
+
+// Replaces --estimate figures with exact sizes before anything is deleted,
+// and applies the selection again: an estimate may have let in a target
+// the exact size leaves out. Returns how many were dropped.
+std::size_t size_exactly(ScanResult& results, const SelectionOptions& selection,
+                         ProgressCounters* counters) {
+    std::uintmax_t min_bytes = 0;
+    std::uintmax_t max_bytes = UINTMAX_MAX;
+    parse_size_range(selection, min_bytes, max_bytes);  // Checked before the scan
+    
+    // As in the scan: links shared only with a dropped target would count
+    bool keeps_all = min_bytes == 0 && max_bytes == UINTMAX_MAX && selection.top == 0;
+    LinkTracker links;
+    for (auto& target : results.targets) {
+        auto stats = Scanner::measure_directory(target.path, counters, nullptr, UINTMAX_MAX,
+                                                keeps_all ? &links : nullptr);
+        target.size = stats.bytes;
+        target.file_count = stats.files;
+        target.dir_count = stats.dirs;
+        target.size_error = 0;
+        target.shared_size = stats.shared_bytes;
+        if (counters) {
+            counters->items.fetch_add(1, std::memory_order_relaxed);
+            counters->bytes.fetch_add(stats.bytes, std::memory_order_relaxed);
+        }
+    }
+    
+    std::size_t before = results.targets.size();
+    auto& targets = results.targets;
+    targets.erase(std::remove_if(targets.begin(), targets.end(),
+                                 [&](const TargetEntry& target) {
+                                     return target.size < min_bytes || target.size > max_bytes;
+                                 }),
+                  targets.end());
+    if (selection.top > 0 && targets.size() > selection.top) {
+        std::stable_sort(targets.begin(), targets.end(), [](const TargetEntry& a, const TargetEntry& b) {
+            return a.size > b.size;
+        });
+        targets.resize(selection.top);
+    }
+    
+    results.total_size = 0;
+    results.total_shared = 0;
+    for (const auto& target : targets) {
+        results.total_size += target.exclusive_size();
+        results.total_shared += target.shared_size;
+    }
+    if (keeps_all) {
+        auto shared = links.totals();
+        results.total_size += shared.covered;
+        results.total_shared = shared.uncovered;
+    }
+    results.total_count = targets.size();
+    results.estimated = false;
+    results.total_size_error = 0;
+    if (targets.size() != before) {
+        results.store.reset();  // Display falls back to the remaining targets
+    }
+    return before - targets.size();
+}
+
+// ============================================================================
+// Deletion (clean, enforce)
+// ============================================================================
+
+// Prompts (or demands the CAPTCHA), deletes through the server when there is
+// one, then reports and records the result. Machine-readable output (a
+// `writer`) never prompts, so it refuses what would need the CAPTCHA.
+int delete_targets(const std::vector<TargetEntry>& targets, std::uintmax_t total_size, bool instant,
+                   ScanClient* server, ResultWriter* writer, CostModel& cost_model, Config& config) {
+    auto& logger = Logger::instance();
+    bool text_output = writer == nullptr;
+    
+    auto forecast = cost_model.predict(targets);
+    std::string eta = (forecast.calibrated ? "about " : "roughly ") + format_duration(forecast.total);
+    
+    if (Safety::requires_captcha(total_size, targets.size())) {
+        if (!text_output) {
+            logger.error(fmt::format("Refusing to delete {} ({} folders) without the interactive CAPTCHA.",
+                                     format_bytes(total_size), targets.size()));
+            return 1;
+        }
+
+        std::string reason = fmt::format("About to delete {} ({} folders, {})",
+                                          format_bytes(total_size), targets.size(), eta);
+        if (!Display::captcha(reason)) {
+            logger.warning("Operation cancelled.");
+            return 0;
+        }
+    } else if (!instant && logger.verbosity() >= Verbosity::Normal) {
+        std::string msg = fmt::format("Delete {} folders ({}, {})? This cannot be undone.",
+                                       targets.size(), format_bytes(total_size), eta);
+        if (!Display::confirm(msg, false)) {
+            logger.warning("Operation cancelled.");
+            return 0;
+        }
+    }
+    
+    DeletionResult deletion_result;
+    if (server) {
+        // The server waits out other deletes over the same trees, and
+        // calibrates the cost model itself
+        logger.normal("\nNuking targets (nuke serve)...");
+        if (!server->destroy(targets, deletion_result)) {
+            logger.error("Scan server: " + server->error());
+            return 1;
+        }
+    } else {
+        Destroyer destroyer(config);
+        
+        ProgressRenderer delete_progress(ProgressRenderer::Phase::Deleting);
+        bool show_progress = text_output && logger.verbosity() >= Verbosity::Normal;
+        if (show_progress) {
+            delete_progress.set_totals(targets.size(), total_size);
+            destroyer.set_progress_counters(&delete_progress.counters());
+        }
+        
+        logger.normal("\nNuking targets...");
+        if (show_progress) {
+            delete_progress.start();
+        }
+        deletion_result = destroyer.destroy_all(targets);
+        delete_progress.stop();
+        
+        if (cost_model.observe(deletion_result)) {
+            cost_model.save();
+        }
+    }
+    NUKE_DIAG("Deletion took {} ms, predicted {} ms", deletion_result.duration.count(),
+              forecast.total.count());
+    
+    if (writer) {
+        writer->write_forecast(targets, forecast);
+        writer->write_deletion_summary(deletion_result);
+        writer->finish();
+    }
+    
+    if (text_output && logger.verbosity() >= Verbosity::Normal) {
+        Display::show_deletion_results(deletion_result, &forecast);
+    } else if (logger.verbosity() >= Verbosity::Minimal) {
+        logger.minimal("Freed " + format_bytes(deletion_result.freed_bytes));
+    }
+    
+    Stats::instance().load();
+    Stats::instance().record_deletion(deletion_result, targets);
+    
+    return deletion_result.failed_count > 0 || deletion_result.skipped_count > 0 ? 1 : 0;
+}
+
 // ============================================================================
 // Command Handlers
 // ============================================================================
 
 int cmd_clean(const std::string& path, bool instant, const std::string& older_than,
-              bool dry_run, Config& config) {
+              bool dry_run, bool estimate, const SelectionOptions& selection,
+              const BudgetOptions& budget, const ListSource& source, OutputFormat format,
+              Config& config) {
     auto& logger = Logger::instance();
+    bool text_output = format == OutputFormat::Text;
     
     try {
-        logger.diagnostic("Starting clean command");
-        logger.diagnostic("Path: " + path);
+        NUKE_DIAG("Starting clean command");
+        NUKE_DIAG("Path: {}", path);
         
         fs::path target_path = fs::absolute(path);
-        if (!Safety::is_safe_path(target_path)) {
-            logger.error(Safety::get_unsafe_reason(target_path));
-            return 1;
+        Safety safety(config);
+        // A listing's targets may sit anywhere; each is still validated below
+        if (source.file.empty() || source.scoped) {
+            if (auto reason = safety.check_root(target_path); !reason.empty()) {
+                logger.error(reason);
+                return 1;
+            }
         }
         
+        std::optional<ScanCheckpoint> listed;
+        if (!source.file.empty()) {
+            listed = plan_listed(source, target_path, config);
+            if (!listed) {
+                return 1;
+            }
+        }
+        auto roots = listed ? listed->roots : std::vector<fs::path>{target_path};
+        
         Scanner scanner(config);
+        if (!apply_selection(scanner, selection)) {
+            return 1;
+        }
+        scanner.set_estimate(estimate);
         
+        std::optional<std::chrono::hours> age;
         if (!older_than.empty()) {
-            std::chrono::hours age{0};
             char unit = older_than.back();
             int value = std::stoi(older_than.substr(0, older_than.length() - 1));
             
@@ -57,154 +593,688 @@ int cmd_clean(const std::string& path, bool instant, const std::string& older_th
                     return 1;
             }
             
-            scanner.set_older_than(age);
+            scanner.set_older_than(*age);
             logger.normal("Filtering targets older than " + older_than);
         }
         
-        if (logger.verbosity() >= Verbosity::Normal) {
-            scanner.set_progress_callback([](const fs::path& current, std::size_t found) {
-                Display::show_scan_progress(current, found);
+        if (!text_output && !dry_run && !instant) {
+            logger.error("Machine-readable output cannot prompt; use --instant or --dry-run.");
+            return 1;
+        }
+        
+        std::optional<ResultWriter> writer;
+        if (!text_output) {
+            writer.emplace(format, "clean");
+            scanner.set_target_callback([&writer](const TargetEntry& target) {
+                writer->write_target(target);
             });
         }
         
-        logger.normal("Scanning for targets...");
-        auto results = scanner.scan(target_path);
+        // With 'nuke serve' running, both the scan and the deletion go
+        // through it; the prompts and safety checks stay here. A listing
+        // leaves no walk to share, so its targets are sized here.
+        std::optional<ScanClient> server;
+        if (!listed) {
+            server = find_server(budget, config);
+        }
+        std::optional<ScanResult> scanned;
+        if (server) {
+            auto request = make_request({fs::weakly_canonical(target_path)}, -1, estimate, selection, config);
+            if (!request) {
+                return 1;
+            }
+            request->older_than_hours = age ? static_cast<std::uint32_t>(age->count()) : 0;
+            
+            std::vector<TargetEntry> found;
+            logger.normal("Scanning for targets (nuke serve)...");
+            scanned = run_remote_scan(*server, *request, [&writer, &found](const TargetEntry& target) {
+                if (writer) writer->write_target(target);
+                found.push_back(target);
+            });
+            if (scanned) {
+                scanned->targets = std::move(found);
+            }
+        } else {
+            ProgressRenderer scan_progress(ProgressRenderer::Phase::Scanning);
+            if (text_output && logger.verbosity() >= Verbosity::Normal) {
+                scanner.set_progress_counters(&scan_progress.counters());
+                scan_progress.start();
+            }
+            
+            logger.normal(listed ? "Sizing listed targets..." : "Scanning for targets...");
+            scanned = run_scan(scanner, budget, roots, -1, true, listed ? &*listed : nullptr);
+            scan_progress.stop();
+        }
+        if (!scanned) {
+            return 1;
+        }
+        auto& results = *scanned;
         
-        if (logger.verbosity() >= Verbosity::Normal) {
-            Display::clear_line();
+        // Every target, not just the root: a symlinked parent or a mount
+        // inside a target is only visible per target
+        auto rejected = safety.validate(results.targets);
+        if (!rejected.empty()) {
+            for (const auto& rejection : rejected) {
+                logger.warning("Skipping " + rejection.target.path.string() + ": " + rejection.reason);
+                // Bytes hardlinked between targets stay counted; close enough for a prompt
+                results.total_size -= std::min(results.total_size, rejection.target.exclusive_size());
+            }
+            results.total_count = results.targets.size();
+            results.store.reset();  // Display falls back to the remaining targets
+        }
+        
+        // The target records went out as the scan found them; the summary
+        // names the ones the checks refused
+        if (writer) {
+            writer->write_scan_summary(results, rejected);
+        }
+        
+        if (text_output && logger.verbosity() >= Verbosity::Normal) {
             std::cout << std::endl;
         }
         
-        logger.diagnostic("Scan complete. Found " + std::to_string(results.targets.size()) + " targets");
+        NUKE_DIAG("Scan complete. Found {} targets", results.targets.size());
         
         if (results.targets.empty()) {
             logger.success("No targets found. Your project is clean!");
             return 0;
         }
         
-        if (logger.verbosity() >= Verbosity::Normal) {
+        if (text_output && logger.verbosity() >= Verbosity::Normal) {
             Display::show_scan_results(results);
         } else if (logger.verbosity() >= Verbosity::Minimal) {
             logger.minimal("Found " + std::to_string(results.total_count) + " targets (" + 
                            format_bytes(results.total_size) + ")");
         }
         
+        // Deletion time follows the entry count and the device, not the bytes
+        CostModel cost_model;
+        cost_model.load();
+        
         if (dry_run) {
+            auto forecast = cost_model.predict(results.targets);
+            if (writer) {
+                writer->write_forecast(results.targets, forecast);
+            } else if (logger.verbosity() >= Verbosity::Normal) {
+                Display::show_deletion_forecast(results.targets, forecast);
+            }
             logger.success("Dry run complete. No files were deleted.");
             return 0;
         }
         
-        if (Safety::requires_captcha(results.total_size, results.total_count)) {
-            std::string reason = fmt::format("About to delete {} ({} folders)",
-                                              format_bytes(results.total_size),
-                                              results.total_count);
-            if (!Display::captcha(reason)) {
-                logger.warning("Operation cancelled.");
-                return 0;
+        // A budget cut the scan short on purpose; Ctrl+C means stop altogether
+        if (!results.complete && budget.time_budget.empty()) {
+            logger.warning("Scan interrupted. No files were deleted.");
+            return 1;
+        }
+        
+        // Estimates are fine for a preview; what is about to go gets sized for real
+        if (results.estimated) {
+            ProgressRenderer size_progress(ProgressRenderer::Phase::Scanning);
+            if (text_output && logger.verbosity() >= Verbosity::Normal) {
+                size_progress.start();
+            }
+            logger.normal("Sizing " + std::to_string(results.total_count) + " targets exactly...");
+            auto dropped = size_exactly(results, selection, &size_progress.counters());
+            size_progress.stop();
+            if (dropped > 0) {
+                logger.normal(fmt::format("{} targets fall outside the size selection once sized exactly",
+                                          dropped));
             }
-        } else if (!instant && logger.verbosity() >= Verbosity::Normal) {
-            std::string msg = fmt::format("Delete {} folders ({})? This cannot be undone.",
-                                           results.total_count, format_bytes(results.total_size));
-            if (!Display::confirm(msg, false)) {
-                logger.warning("Operation cancelled.");
+            if (results.targets.empty()) {
+                logger.success("No targets left to delete.");
                 return 0;
             }
         }
         
-        Destroyer destroyer(config);
+        return delete_targets(results.targets, results.total_size, instant,
+                              server ? &*server : nullptr, writer ? &*writer : nullptr, cost_model, config);
+    } catch (const std::exception& e) {
+        logger.error("Exception in clean command: " + std::string(e.what()));
+        return 1;
+    } catch (...) {
+        logger.error("Unknown exception in clean command");
+        return 1;
+    }
+}
+
+int cmd_enforce(std::vector<std::string> roots, bool instant, bool dry_run, OutputFormat format,
+                Config& config) {
+    auto& logger = Logger::instance();
+    bool text_output = format == OutputFormat::Text;
+    
+    try {
+        std::vector<QuotaBudget> budgets;
+        std::string error;
+        if (!QuotaBudget::from_config(config.quotas(), budgets, error)) {
+            logger.error(error);
+            return 1;
+        }
+        if (budgets.empty()) {
+            logger.error("No quotas configured. Add a 'quotas' list to nuke.config.yaml.");
+            return 1;
+        }
         
-        if (logger.verbosity() >= Verbosity::Normal) {
-            destroyer.set_progress_callback([](const fs::path& p, std::size_t current, std::size_t total) {
-                Display::show_deletion_progress(current, total, p);
-            });
+        // Without roots, the quotas' own roots; a quota without one covers
+        // whatever is scanned
+        if (roots.empty()) {
+            for (const auto& budget : budgets) {
+                if (!budget.root.empty()) roots.push_back(budget.root.string());
+            }
+            if (roots.empty()) roots.push_back(".");
+        }
+        auto root_set = RootSet::plan(roots);
+        for (const auto& dropped : root_set.dropped) {
+            if (dropped.missing) {
+                logger.error("Path does not exist: " + dropped.input);
+            } else {
+                NUKE_DETAIL("Skipping root {}: {}", dropped.input, dropped.reason);
+            }
+        }
+        Safety safety(config);
+        for (const auto& root : root_set.roots) {
+            if (auto reason = safety.check_root(root); !reason.empty()) {
+                logger.error(reason);
+                return 1;
+            }
+        }
+        if (root_set.roots.empty()) {
+            return 1;
         }
         
-        logger.normal("\nNuking targets...");
-        auto deletion_result = destroyer.destroy_all(results.targets);
+        if (!text_output && !dry_run && !instant) {
+            logger.error("Machine-readable output cannot prompt; use --instant or --dry-run.");
+            return 1;
+        }
+        
+        // Recency comes from the sizing walk, so every target is sized in
+        // full; a warm 'nuke serve' inventory answers without walking at all
+        auto server = find_server(BudgetOptions{}, config);
+        std::optional<ScanResult> scanned;
+        if (server) {
+            auto request = make_request(root_set.roots, -1, false, SelectionOptions{}, config);
+            if (!request) {
+                return 1;
+            }
+            logger.normal("Scanning " + join_roots(root_set.roots) + " (nuke serve)...");
+            scanned = run_remote_scan(*server, *request);
+        } else {
+            Scanner scanner(config);
+            ProgressRenderer progress(ProgressRenderer::Phase::Scanning);
+            if (text_output && logger.verbosity() >= Verbosity::Normal) {
+                scanner.set_progress_counters(&progress.counters());
+                progress.start();
+            }
+            logger.normal("Scanning " + join_roots(root_set.roots) + "...");
+            scanned = run_scan(scanner, BudgetOptions{}, root_set.roots, -1, false);
+            progress.stop();
+        }
+        if (!scanned) {
+            return 1;
+        }
+        auto& results = *scanned;
+        if (!results.complete) {
+            // Usage would be undercounted and the wrong targets evicted
+            logger.warning("Scan interrupted. No files were deleted.");
+            return 1;
+        }
         
-        if (logger.verbosity() >= Verbosity::Normal) {
-            Display::clear_line();
+        // Targets that may not be deleted are left out of the budgets too
+        for (const auto& rejection : safety.validate(results.targets)) {
+            logger.warning("Skipping " + rejection.target.path.string() + ": " + rejection.reason);
         }
         
-        if (logger.verbosity() >= Verbosity::Normal) {
-            Display::show_deletion_results(deletion_result);
-        } else if (logger.verbosity() >= Verbosity::Minimal) {
-            logger.minimal("Freed " + format_bytes(deletion_result.freed_bytes));
+        auto plan = plan_evictions(budgets, results.targets);
+        
+        std::optional<ResultWriter> writer;
+        if (!text_output) {
+            writer.emplace(format, "enforce");
+            for (const auto& target : plan.evict) {
+                writer->write_target(target);
+            }
+            writer->write_quota_summary(plan);
+        } else if (logger.verbosity() >= Verbosity::Normal) {
+            Display::show_quota_plan(plan);
+        }
+        
+        if (plan.evict.empty()) {
+            logger.success("Every quota is met.");
+            return 0;
         }
+        logger.minimal(fmt::format("Evicting {} targets ({}) to meet {} quotas", plan.evict.size(),
+                                   format_bytes(plan.evict_bytes), budgets.size()));
         
-        Stats::instance().load();
-        Stats::instance().record_deletion(deletion_result, results.targets);
+        CostModel cost_model;
+        cost_model.load();
         
-        return deletion_result.failed_count > 0 ? 1 : 0;
+        if (dry_run) {
+            auto forecast = cost_model.predict(plan.evict);
+            if (writer) {
+                writer->write_forecast(plan.evict, forecast);
+            } else if (logger.verbosity() >= Verbosity::Normal) {
+                Display::show_deletion_forecast(plan.evict, forecast);
+            }
+            logger.success("Dry run complete. No files were deleted.");
+            return 0;
+        }
+        
+        return delete_targets(plan.evict, plan.evict_bytes, instant,
+                              server ? &*server : nullptr, writer ? &*writer : nullptr, cost_model, config);
     } catch (const std::exception& e) {
-        logger.error("Exception in clean command: " + std::string(e.what()));
+        logger.error("Exception in enforce command: " + std::string(e.what()));
         return 1;
     } catch (...) {
-        logger.error("Unknown exception in clean command");
+        logger.error("Unknown exception in enforce command");
         return 1;
     }
 }
 
-int cmd_list(const std::string& path, const std::string& sort_by, Config& config) {
+int cmd_list(const std::string& path, const std::string& sort_by, bool tree, int tree_depth,
+             bool estimate, const SelectionOptions& selection, const BudgetOptions& budget,
+             const ListSource& source, const std::string& snapshot_out, OutputFormat format,
+             Config& config) {
     auto& logger = Logger::instance();
     
     fs::path target_path = fs::absolute(path);
+    std::optional<ScanCheckpoint> listed;
+    if (!source.file.empty()) {
+        listed = plan_listed(source, target_path, config);
+        if (!listed) {
+            return 1;
+        }
+    }
+    auto roots = listed ? listed->roots : std::vector<fs::path>{target_path};
+    const ScanCheckpoint* start = listed ? &*listed : nullptr;
+    
+    SortBy sort = SortBy::Size;
+    if (sort_by == "name") sort = SortBy::Name;
+    else if (sort_by == "date") sort = SortBy::Date;
+    
+    // The server keeps rows, not the roll-up tree --tree draws, and has
+    // no use for a listing
+    if (auto server = (tree || listed) ? std::nullopt : find_server(budget, config)) {
+        auto request = make_request({fs::weakly_canonical(target_path)}, -1, estimate, selection, config);
+        if (!request) {
+            return 1;
+        }
+        logger.normal("Scanning (nuke serve)...");
+        return show_remote_scan(*server, *request, "list", sort, format, snapshot_out) ? 0 : 1;
+    }
+    
     Scanner scanner(config);
+    if (!apply_selection(scanner, selection)) {
+        return 1;
+    }
+    scanner.set_estimate(estimate);
     
-    if (logger.verbosity() >= Verbosity::Normal) {
-        scanner.set_progress_callback([](const fs::path& current, std::size_t found) {
-            Display::show_scan_progress(current, found);
+    if (format != OutputFormat::Text) {
+        ResultWriter writer(format, "list");
+        scanner.set_retain_targets(!snapshot_out.empty());
+        scanner.set_materialize_targets(false);
+        scanner.set_target_callback([&writer](const TargetEntry& target) {
+            writer.write_target(target);
         });
+        auto scanned = run_scan(scanner, budget, roots, -1, false, start);
+        if (!scanned) {
+            return 1;
+        }
+        writer.write_scan_summary(*scanned);
+        return write_snapshot(snapshot_out, *scanned) ? 0 : 1;
     }
     
-    logger.normal("Scanning...");
-    auto results = scanner.scan(target_path);
+    scanner.set_materialize_targets(false);
     
+    ProgressRenderer progress(ProgressRenderer::Phase::Scanning);
     if (logger.verbosity() >= Verbosity::Normal) {
-        Display::clear_line();
+        scanner.set_progress_counters(&progress.counters());
+        progress.start();
     }
     
-    SortBy sort = SortBy::Size;
-    if (sort_by == "name") sort = SortBy::Name;
-    else if (sort_by == "date") sort = SortBy::Date;
+    logger.normal(listed ? "Sizing listed targets..." : "Scanning...");
+    auto scanned = run_scan(scanner, budget, roots, -1, false, start);
+    progress.stop();
+    if (!scanned) {
+        return 1;
+    }
+    const auto& results = *scanned;
     
-    Display::show_scan_results(results, sort);
+    if (tree) {
+        Display::show_tree(results, tree_depth);
+    } else {
+        Display::show_scan_results(results, sort);
+    }
     
-    return 0;
+    return write_snapshot(snapshot_out, results) ? 0 : 1;
 }
 
-int cmd_scout(const std::string& root, int depth, Config& config) {
+int cmd_scout(std::vector<std::string> roots, const std::string& roots_from, int depth,
+              bool estimate, const SelectionOptions& selection, const BudgetOptions& budget,
+              const ShardOptions& sharding, const std::string& snapshot_out, OutputFormat format,
+              Config& config) {
     auto& logger = Logger::instance();
     
-    fs::path root_path = fs::absolute(root);
+    if (!roots_from.empty() && !RootSet::read_manifest(roots_from, roots)) {
+        return 1;
+    }
+    if (roots.empty()) {
+        roots.push_back(".");
+    }
     
-    if (!fs::exists(root_path)) {
-        logger.error("Path does not exist: " + root_path.string());
+    // Nested and duplicate roots would be walked twice; scan each tree once
+    auto root_set = RootSet::plan(roots);
+    for (const auto& dropped : root_set.dropped) {
+        if (dropped.missing) {
+            logger.error("Path does not exist: " + dropped.input);
+        } else {
+            NUKE_DETAIL("Skipping root {}: {}", dropped.input, dropped.reason);
+        }
+    }
+    if (root_set.roots.empty() && !budget.resume) {
         return 1;
     }
+    const auto& root_paths = root_set.roots;
+    
+    // Every shard computes the same plan and walks only the units it owns
+    std::optional<ShardSpec> spec;
+    ShardPlan plan;
+    ScanCheckpoint shard_start;
+    if (!sharding.shard.empty()) {
+        spec = ShardSpec::parse(sharding.shard);
+        if (!spec) {
+            logger.error("Invalid --shard: " + sharding.shard + " (expected i/N with 0 <= i < N)");
+            return 1;
+        }
+        if (root_paths.empty()) {
+            logger.error("--shard needs the roots to plan with");
+            return 1;
+        }
+        plan = ShardPlan::build(root_paths, depth, spec->count, config);
+        shard_start = plan.checkpoint_for(spec->index);
+        logger.normal(fmt::format("Shard {}: {} of {} units", spec->to_string(),
+                                  shard_start.pending.size(), plan.units.size()));
+    }
+    const ScanCheckpoint* start = spec ? &shard_start : nullptr;
+    
+    // A shard walks only its own units; the server walks whole roots
+    if (auto server = spec ? std::nullopt : find_server(budget, config)) {
+        auto request = make_request(root_paths, depth, estimate, selection, config);
+        if (!request) {
+            return 1;
+        }
+        logger.normal("Scouting from " + join_roots(root_paths) + " (depth: " + std::to_string(depth) +
+                      ", nuke serve)...");
+        return show_remote_scan(*server, *request, "scout", SortBy::Size, format, snapshot_out) ? 0 : 1;
+    }
     
     Scanner scanner(config);
+    if (!apply_selection(scanner, selection)) {
+        return 1;
+    }
+    scanner.set_estimate(estimate);
+    auto finish_scan = [&](const ScanResult& results) {
+        bool shard_ok = !spec || write_shard_result(sharding, *spec, plan, scanner, results);
+        return write_snapshot(snapshot_out, results) && shard_ok;
+    };
     
-    if (logger.verbosity() >= Verbosity::Normal) {
-        scanner.set_progress_callback([](const fs::path& current, std::size_t found) {
-            Display::show_scan_progress(current, found);
+    if (format != OutputFormat::Text) {
+        ResultWriter writer(format, "scout");
+        // The shard file and the snapshot need the rows
+        scanner.set_retain_targets(spec.has_value() || !snapshot_out.empty());
+        scanner.set_materialize_targets(false);
+        scanner.set_target_callback([&writer](const TargetEntry& target) {
+            writer.write_target(target);
         });
+        auto scanned = run_scan(scanner, budget, root_paths, depth, false, start);
+        if (!scanned) {
+            return 1;
+        }
+        writer.write_scan_summary(*scanned);
+        return finish_scan(*scanned) ? 0 : 1;
     }
     
-    logger.normal("Scouting from " + root_path.string() + " (depth: " + std::to_string(depth) + ")...");
-    auto results = scanner.scan(root_path, depth);
+    scanner.set_materialize_targets(false);
+    
+    ProgressRenderer progress(ProgressRenderer::Phase::Scanning);
+    if (logger.verbosity() >= Verbosity::Normal) {
+        scanner.set_progress_counters(&progress.counters());
+        progress.start();
+    }
+    
+    logger.normal("Scouting from " + join_roots(root_paths) + " (depth: " + std::to_string(depth) + ")...");
+    auto scanned = run_scan(scanner, budget, root_paths, depth, false, start);
+    progress.stop();
+    if (!scanned) {
+        return 1;
+    }
+    const auto& results = *scanned;
     
     if (logger.verbosity() >= Verbosity::Normal) {
-        Display::clear_line();
         std::cout << std::endl;
     }
     
     Display::show_scan_results(results);
     
-    if (!results.targets.empty()) {
+    if (results.total_count > 0) {
         std::cout << Display::Color::dim("Use 'nuke clean <path>' to clean specific projects.") << std::endl;
     }
     
+    return finish_scan(results) ? 0 : 1;
+}
+
+int cmd_merge(const std::vector<std::string>& files, const std::string& sort_by, OutputFormat format,
+              Config& config) {
+    auto& logger = Logger::instance();
+    
+    std::vector<ShardResult> shards;
+    for (const auto& file : files) {
+        ShardResult shard;
+        if (!shard.load(file)) {
+            logger.error("Not a shard result: " + file);
+            return 1;
+        }
+        shards.push_back(std::move(shard));
+    }
+    
+    // Report every gap or overlap, then still show what the shards found
+    auto problems = verify_shards(shards);
+    for (const auto& problem : problems) {
+        logger.error(problem);
+    }
+    
+    ScanCheckpoint merged;
+    merged.roots = shards.front().state.roots;
+    merged.max_depth = shards.front().state.max_depth;
+    std::chrono::milliseconds slowest{0};
+    for (auto& shard : shards) {
+        for (auto& target : shard.state.found) {
+            merged.found.push_back(std::move(target));
+        }
+        slowest = std::max(slowest, shard.duration);
+    }
+    
+    Scanner scanner(config);
+    scanner.set_materialize_targets(false);
+    ScanResult results = scanner.resume(merged);
+    results.scan_duration = slowest;  // Shards ran side by side
+    results.complete = problems.empty();
+    
+    SortBy sort = SortBy::Size;
+    if (sort_by == "name") sort = SortBy::Name;
+    else if (sort_by == "date") sort = SortBy::Date;
+    
+    if (format != OutputFormat::Text) {
+        ResultWriter writer(format, "merge");
+        if (results.store) {
+            for (auto row : results.store->order_by(sort)) {
+                writer.write_target(results.store->entry(row));
+            }
+        }
+        writer.write_scan_summary(results);
+    } else {
+        logger.normal(fmt::format("Merged {} shards", shards.size()));
+        Display::show_scan_results(results, sort);
+    }
+    
+    return problems.empty() ? 0 : 1;
+}
+
+int cmd_diff(const std::string& old_file, const std::string& new_file, const std::string& min_delta,
+             const std::string& sort_by, OutputFormat format) {
+    auto& logger = Logger::instance();
+    
+    std::uint64_t threshold = 0;
+    if (!min_delta.empty()) {
+        auto parsed = parse_bytes(min_delta);
+        if (!parsed) {
+            logger.error("Invalid --min-delta: " + min_delta);
+            return 1;
+        }
+        threshold = *parsed;
+    }
+    
+    Snapshot before;
+    Snapshot after;
+    if (!before.load(old_file)) {
+        logger.error(before.error());
+        return 1;
+    }
+    if (!after.load(new_file)) {
+        logger.error(after.error());
+        return 1;
+    }
+    if (!before.complete() || !after.complete()) {
+        logger.warning("A snapshot is of an incomplete scan; targets it missed show as new or removed");
+    }
+    
+    auto diff = diff_snapshots(before, after, threshold);
+    if (diff.corrupt) {
+        logger.error("A snapshot is damaged; the diff stops where its paths could not be read");
+    }
+    
+    // The join yields path order; only the changes are sorted for display
+    if (sort_by == "delta") {
+        std::stable_sort(diff.changes.begin(), diff.changes.end(),
+                         [](const SnapshotChange& a, const SnapshotChange& b) {
+                             return std::llabs(a.delta()) > std::llabs(b.delta());
+                         });
+    }
+    
+    if (format != OutputFormat::Text) {
+        ResultWriter writer(format, "diff");
+        for (const auto& change : diff.changes) {
+            writer.write_change(change);
+        }
+        writer.write_diff_summary(diff);
+    } else {
+        logger.normal(fmt::format("Comparing {} ({} targets) with {} ({} targets)", old_file,
+                                  before.size(), new_file, after.size()));
+        Display::show_snapshot_diff(diff);
+    }
+    
+    return diff.corrupt ? 1 : 0;
+}
+
+int cmd_ui(const std::string& path, int depth, Config& config) {
+    fs::path root_path = fs::absolute(path);
+    
+    if (!fs::is_directory(root_path)) {
+        Logger::instance().error("Path is not a directory: " + root_path.string());
+        return 1;
+    }
+    if (auto reason = Safety(config).check_root(root_path); !reason.empty()) {
+        Logger::instance().error(reason);
+        return 1;
+    }
+    
+    Browser browser(config, root_path, depth);
+    return browser.run();
+}
+
+int cmd_serve(const std::string& socket, const std::string& ttl, std::size_t walks, Config& config) {
+    auto& logger = Logger::instance();
+    
+    ServerOptions options;
+    options.socket_path = socket;
+    options.max_walks = walks;
+    auto parsed_ttl = parse_duration(ttl);
+    if (!parsed_ttl) {
+        logger.error("Invalid --ttl: " + ttl);
+        return 1;
+    }
+    options.ttl = std::chrono::duration_cast<std::chrono::seconds>(*parsed_ttl);
+    
+    ScanServer server(config, options);
+    if (!server.listen()) {
+        return 1;
+    }
+    logger.normal(fmt::format("Serving scans on {} (walks: {}, ttl: {}). Ctrl+C to stop.",
+                              server.socket_path().string(), walks, ttl));
+    
+    running_server.store(&server);
+    std::signal(SIGINT, on_stop_server);
+    std::signal(SIGTERM, on_stop_server);
+    server.run();
+    std::signal(SIGINT, SIG_DFL);
+    std::signal(SIGTERM, SIG_DFL);
+    running_server.store(nullptr);
+    
+    logger.normal("Server stopped.");
+    return 0;
+}
+
+static std::atomic<DiskGuard*> running_guard{nullptr};
+
+extern "C" void on_stop_guard(int) {
+    if (DiskGuard* guard = running_guard.load()) {
+        guard->stop();
+    }
+}
+
+int cmd_guard(const std::string& interval, const std::string& refresh, bool dry_run, bool once,
+              Config& config) {
+    auto& logger = Logger::instance();
+    
+    GuardOptions options;
+    options.dry_run = dry_run;
+    auto parsed_interval = parse_duration(interval);
+    auto parsed_refresh = parse_duration(refresh);
+    if (!parsed_interval || parsed_interval->count() == 0) {
+        logger.error("Invalid --interval: " + interval);
+        return 1;
+    }
+    if (!parsed_refresh || parsed_refresh->count() == 0) {
+        logger.error("Invalid --refresh: " + refresh);
+        return 1;
+    }
+    options.interval = *parsed_interval;
+    options.refresh = *parsed_refresh;
+    
+    DiskGuard guard(config, options);
+    std::string error;
+    if (!guard.configure(error)) {
+        logger.error(error);
+        return 1;
+    }
+    if (guard.watch_count() == 0) {
+        logger.error("Nothing to guard. Add a 'guard' list to nuke.config.yaml.");
+        return 1;
+    }
+    
+    running_guard.store(&guard);
+    std::signal(SIGINT, on_stop_guard);
+    std::signal(SIGTERM, on_stop_guard);
+    if (once) {
+        guard.run_once();
+    } else {
+        logger.normal(fmt::format("Guarding {} filesystem(s): free space every {}, candidates every {}{}. "
+                                  "Ctrl+C to stop.", guard.watch_count(), interval, refresh,
+                                  dry_run ? " (dry run)" : ""));
+        guard.run();
+        logger.normal("Guard stopped.");
+    }
+    std::signal(SIGINT, SIG_DFL);
+    std::signal(SIGTERM, SIG_DFL);
+    running_guard.store(nullptr);
     return 0;
 }
 
@@ -230,6 +1300,17 @@ int main(int argc, char** argv) {
                    "Log verbosity: q(uiet), m(inimal), n(ormal), d(etailed), diag(nostic)")
         ->default_val("normal");
     
+    bool profile = false;
+    std::string profile_json;
+    app.add_flag("--profile", profile, "Print filesystem operation counts and latencies at exit");
+    app.add_option("--profile-json", profile_json, "Also write the profile report as JSON to this file");
+    
+    bool no_server = false;
+    app.add_flag("--no-server", no_server, "Scan here even when 'nuke serve' is running");
+    
+    const std::string format_help = "Output format: text, json, ndjson";
+    const auto format_choices = CLI::IsMember({"text", "json", "ndjson"});
+    
     // Subcommand: clean
     std::string clean_path = ".";
     bool clean_instant = false;
@@ -242,6 +1323,31 @@ int main(int argc, char** argv) {
     clean_cmd->add_option("-t,--older-than", clean_older_than, 
                           "Only delete folders older than (e.g., 30d, 2w, 24h)");
     clean_cmd->add_flag("--dry-run", clean_dry_run, "Show what would be deleted without deleting");
+    bool clean_estimate = false;
+    clean_cmd->add_flag("--estimate", clean_estimate,
+                        "Estimate sizes by sampling; targets are sized exactly before deletion");
+    SelectionOptions clean_selection;
+    add_selection_options(clean_cmd, clean_selection);
+    BudgetOptions clean_budget;
+    add_budget_options(clean_cmd, clean_budget);
+    ListSource clean_source;
+    add_list_source_option(clean_cmd, clean_source);
+    std::string clean_format = "text";
+    clean_cmd->add_option("--format", clean_format, format_help)
+        ->default_val("text")->check(format_choices);
+    
+    // Subcommand: enforce
+    std::vector<std::string> enforce_roots;
+    bool enforce_instant = false;
+    bool enforce_dry_run = false;
+    std::string enforce_format = "text";
+    
+    auto* enforce_cmd = app.add_subcommand("enforce", "Evict least recently used targets until every quota is met");
+    enforce_cmd->add_option("roots", enforce_roots, "Roots to scan (default: the quotas' roots)");
+    enforce_cmd->add_flag("-i,--instant", enforce_instant, "Skip confirmation prompt");
+    enforce_cmd->add_flag("--dry-run", enforce_dry_run, "Show what would be evicted without deleting");
+    enforce_cmd->add_option("--format", enforce_format, format_help)
+        ->default_val("text")->check(format_choices);
     
     // Subcommand: list
     std::string list_path = ".";
@@ -250,14 +1356,107 @@ int main(int argc, char** argv) {
     auto* list_cmd = app.add_subcommand("list", "List target folders without deleting");
     list_cmd->add_option("path", list_path, "Path to scan")->default_val(".");
     list_cmd->add_option("--sort", list_sort, "Sort by: size, name, date")->default_val("size");
+    bool list_tree = false;
+    int list_depth = 3;
+    list_cmd->add_flag("--tree", list_tree, "Show sizes rolled up to each ancestor directory");
+    list_cmd->add_option("--depth", list_depth, "Tree levels to expand (-1 for all)")->default_val(3);
+    bool list_estimate = false;
+    list_cmd->add_flag("--estimate", list_estimate, "Estimate sizes by sampling (faster on cold caches)");
+    SelectionOptions list_selection;
+    add_selection_options(list_cmd, list_selection);
+    BudgetOptions list_budget;
+    add_budget_options(list_cmd, list_budget);
+    ListSource list_source;
+    add_list_source_option(list_cmd, list_source);
+    std::string list_snapshot;
+    add_snapshot_option(list_cmd, list_snapshot);
+    std::string list_format = "text";
+    list_cmd->add_option("--format", list_format, format_help)
+        ->default_val("text")->check(format_choices);
     
     // Subcommand: scout
-    std::string scout_root = ".";
+    std::vector<std::string> scout_roots;
+    std::string scout_roots_from;
     int scout_depth = 3;
     
     auto* scout_cmd = app.add_subcommand("scout", "Deep scan for forgotten projects");
-    scout_cmd->add_option("--root", scout_root, "Root directory to scan")->default_val(".");
+    scout_cmd->add_option("--root", scout_roots, "Root directory to scan (repeatable, default: .)");
+    scout_cmd->add_option("--roots-from", scout_roots_from,
+                          "Read roots from a file, one per line ('-' for stdin)");
     scout_cmd->add_option("--depth", scout_depth, "Maximum scan depth")->default_val(3);
+    bool scout_estimate = false;
+    scout_cmd->add_flag("--estimate", scout_estimate, "Estimate sizes by sampling (faster on cold caches)");
+    SelectionOptions scout_selection;
+    add_selection_options(scout_cmd, scout_selection);
+    BudgetOptions scout_budget;
+    add_budget_options(scout_cmd, scout_budget);
+    ShardOptions scout_sharding;
+    add_shard_options(scout_cmd, scout_sharding);
+    std::string scout_snapshot;
+    add_snapshot_option(scout_cmd, scout_snapshot);
+    std::string scout_format = "text";
+    scout_cmd->add_option("--format", scout_format, format_help)
+        ->default_val("text")->check(format_choices);
+    
+    // Subcommand: merge
+    std::vector<std::string> merge_files;
+    std::string merge_sort = "size";
+    std::string merge_format = "text";
+    
+    auto* merge_cmd = app.add_subcommand("merge", "Combine 'scout --shard' results and check coverage");
+    merge_cmd->add_option("files", merge_files, "Shard result files")->required();
+    merge_cmd->add_option("--sort", merge_sort, "Sort by: size, name, date")->default_val("size");
+    merge_cmd->add_option("--format", merge_format, format_help)
+        ->default_val("text")->check(format_choices);
+    
+    // Subcommand: diff
+    std::string diff_old;
+    std::string diff_new;
+    std::string diff_min_delta;
+    std::string diff_sort = "delta";
+    std::string diff_format = "text";
+    
+    auto* diff_cmd = app.add_subcommand("diff", "Compare two --snapshot-out files: new, removed, grown targets");
+    diff_cmd->add_option("old", diff_old, "Earlier snapshot")->required();
+    diff_cmd->add_option("new", diff_new, "Later snapshot")->required();
+    diff_cmd->add_option("--min-delta", diff_min_delta, "Ignore size changes smaller than this (e.g., 10MB)");
+    diff_cmd->add_option("--sort", diff_sort, "Sort by: delta, path")->default_val("delta")
+        ->check(CLI::IsMember({"delta", "path"}));
+    diff_cmd->add_option("--format", diff_format, format_help)
+        ->default_val("text")->check(format_choices);
+    
+    // Subcommand: ui
+    std::string ui_path = ".";
+    int ui_depth = -1;
+    
+    auto* ui_cmd = app.add_subcommand("ui", "Interactive browser: sort, filter, select and delete");
+    ui_cmd->add_option("path", ui_path, "Path to scan")->default_val(".");
+    ui_cmd->add_option("--depth", ui_depth, "Maximum scan depth (-1 for unlimited)")->default_val(-1);
+    
+    // Subcommand: serve
+    std::string serve_socket;
+    std::string serve_ttl = "60s";
+    std::size_t serve_walks = 2;
+    
+    auto* serve_cmd = app.add_subcommand("serve", "Share warm scans with other nuke commands over a local socket");
+    serve_cmd->add_option("--socket", serve_socket,
+                          "Socket path (default: $NUKE_SOCKET, $XDG_RUNTIME_DIR/nuke.sock or /tmp/nuke-<uid>.sock)");
+    serve_cmd->add_option("--ttl", serve_ttl, "How long a finished scan answers repeated requests")
+        ->default_val("60s");
+    serve_cmd->add_option("--walks", serve_walks, "Different scans allowed to run at once")->default_val(2);
+    
+    // Subcommand: guard
+    std::string guard_interval = "2s";
+    std::string guard_refresh = "10m";
+    bool guard_dry_run = false;
+    bool guard_once = false;
+    
+    auto* guard_cmd = app.add_subcommand("guard", "Free disk space as soon as it runs low (see 'guard' in the config)");
+    guard_cmd->add_option("--interval", guard_interval, "How often free space is checked")->default_val("2s");
+    guard_cmd->add_option("--refresh", guard_refresh, "How often the candidate list is rebuilt")
+        ->default_val("10m");
+    guard_cmd->add_flag("--dry-run", guard_dry_run, "Log what would be deleted without deleting");
+    guard_cmd->add_flag("--once", guard_once, "Scan, check every filesystem once and exit");
     
     // Subcommand: stats
     auto* stats_cmd = app.add_subcommand("stats", "Show deletion statistics and rank");
@@ -265,31 +1464,69 @@ int main(int argc, char** argv) {
     CLI11_PARSE(app, argc, argv);
     
     Logger::instance().set_verbosity(string_to_verbosity(verbosity_str));
+    use_server = !no_server;
     
-    if (Logger::instance().verbosity() >= Verbosity::Normal && !app.get_subcommands().empty()) {
-        Display::show_banner();
-    }
-    
-    if (clean_cmd->parsed()) {
-        return cmd_clean(clean_path, clean_instant, clean_older_than, clean_dry_run, config);
-    }
+    std::string format_str = "text";
+    if (clean_cmd->parsed()) format_str = clean_format;
+    else if (enforce_cmd->parsed()) format_str = enforce_format;
+    else if (list_cmd->parsed()) format_str = list_format;
+    else if (scout_cmd->parsed()) format_str = scout_format;
+    else if (merge_cmd->parsed()) format_str = merge_format;
+    else if (diff_cmd->parsed()) format_str = diff_format;
+    OutputFormat format = string_to_output_format(format_str).value_or(OutputFormat::Text);
     
-    if (list_cmd->parsed()) {
-        return cmd_list(list_path, list_sort, config);
+    if (format != OutputFormat::Text) {
+        Logger::instance().set_reserve_stdout(true);
+    } else if (Logger::instance().verbosity() >= Verbosity::Normal && !app.get_subcommands().empty() &&
+               !ui_cmd->parsed()) {
+        Display::show_banner();
     }
     
-    if (scout_cmd->parsed()) {
-        return cmd_scout(scout_root, scout_depth, config);
+    if (profile || !profile_json.empty()) {
+        Profiler::instance().enable();
     }
     
-    if (stats_cmd->parsed()) {
-        return cmd_stats();
-    }
+    int exit_code = 0;
     
-    if (app.get_subcommands().empty()) {
+    if (clean_cmd->parsed()) {
+        clean_source.scoped = clean_cmd->count("path") > 0;
+        exit_code = cmd_clean(clean_path, clean_instant, clean_older_than, clean_dry_run,
+                              clean_estimate, clean_selection, clean_budget, clean_source, format, config);
+    } else if (enforce_cmd->parsed()) {
+        exit_code = cmd_enforce(enforce_roots, enforce_instant, enforce_dry_run, format, config);
+    } else if (list_cmd->parsed()) {
+        list_source.scoped = list_cmd->count("path") > 0;
+        exit_code = cmd_list(list_path, list_sort, list_tree, list_depth, list_estimate,
+                             list_selection, list_budget, list_source, list_snapshot, format, config);
+    } else if (scout_cmd->parsed()) {
+        exit_code = cmd_scout(scout_roots, scout_roots_from, scout_depth, scout_estimate,
+                              scout_selection, scout_budget, scout_sharding, scout_snapshot, format, config);
+    } else if (merge_cmd->parsed()) {
+        exit_code = cmd_merge(merge_files, merge_sort, format, config);
+    } else if (diff_cmd->parsed()) {
+        exit_code = cmd_diff(diff_old, diff_new, diff_min_delta, diff_sort, format);
+    } else if (ui_cmd->parsed()) {
+        exit_code = cmd_ui(ui_path, ui_depth, config);
+    } else if (serve_cmd->parsed()) {
+        exit_code = cmd_serve(serve_socket, serve_ttl, serve_walks, config);
+    } else if (guard_cmd->parsed()) {
+        exit_code = cmd_guard(guard_interval, guard_refresh, guard_dry_run, guard_once, config);
+    } else if (stats_cmd->parsed()) {
+        exit_code = cmd_stats();
+    } else if (app.get_subcommands().empty()) {
         Display::show_banner();
         std::cout << app.help() << std::endl;
     }
     
-    return 0;
+    if (Profiler::instance().enabled()) {
+        // The table would corrupt machine-readable stdout; use --profile-json there
+        if (profile && format == OutputFormat::Text) {
+            Display::show_profile(Profiler::instance());
+        }
+        if (!profile_json.empty() && !Profiler::instance().write_json(profile_json)) {
+            Logger::instance().error("Failed to write profile to: " + profile_json);
+        }
+    }
+    
+    return exit_code;
 }
@@ -0,0 +1,633 @@
+#include "nuke/ui/browser.hpp"
+#include "nuke/core/cost_model.hpp"
+#include "nuke/core/destroyer.hpp"
+#include "nuke/ui/display.hpp"
+#include "nuke/ui/logger.hpp"
+#include "nuke/utils/safety.hpp"
+#include "nuke/utils/stats.hpp"
+#include <fmt/core.h>
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <iostream>
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <conio.h>
+#else
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+#endif
+
+namespace nuke {
+
+namespace {
+    enum Key {
+        KEY_UP = 1000,
+        KEY_DOWN,
+        KEY_PAGE_UP,
+        KEY_PAGE_DOWN,
+        KEY_HOME,
+        KEY_END
+    };
+
+    constexpr std::array<const char*, 7> TYPE_FILTERS = {
+        "all", "node", "rust", "python", "dotnet", "generic", "unknown"
+    };
+    constexpr std::array<int, 5> AGE_FILTER_DAYS = {0, 7, 30, 90, 365};
+    constexpr std::array<std::uintmax_t, 4> SIZE_FILTERS = {
+        0, 10ULL * 1024 * 1024, 100ULL * 1024 * 1024, 1024ULL * 1024 * 1024
+    };
+    constexpr auto TICK = std::chrono::milliseconds(100);
+    constexpr int HEADER_LINES = 3;
+    constexpr int FOOTER_LINES = 2;
+
+    // Raw keyboard input plus the alternate screen for the lifetime of the
+    // object; suspend()/resume() hand the terminal back for prompts.
+    class RawTerminal {
+    public:
+        RawTerminal() { resume(); }
+        ~RawTerminal() { suspend(); }
+
+        void resume() {
+            if (active_) return;
+#ifdef _WIN32
+            in_ = GetStdHandle(STD_INPUT_HANDLE);
+            GetConsoleMode(in_, &saved_mode_);
+            SetConsoleMode(in_, ENABLE_EXTENDED_FLAGS);
+            HANDLE out = GetStdHandle(STD_OUTPUT_HANDLE);
+            DWORD out_mode = 0;
+            if (GetConsoleMode(out, &out_mode)) {
+                SetConsoleMode(out, out_mode | ENABLE_VIRTUAL_TERMINAL_PROCESSING);
+            }
+#else
+            tcgetattr(STDIN_FILENO, &saved_);
+            termios raw = saved_;
+            raw.c_lflag &= ~static_cast<tcflag_t>(ICANON | ECHO);
+            raw.c_cc[VMIN] = 0;
+            raw.c_cc[VTIME] = 0;
+            tcsetattr(STDIN_FILENO, TCSANOW, &raw);
+#endif
+            write("\033[?1049h\033[?25l");
+            active_ = true;
+        }
+
+        void suspend() {
+            if (!active_) return;
+            write("\033[?25h\033[?1049l");
+#ifdef _WIN32
+            SetConsoleMode(in_, saved_mode_);
+#else
+            tcsetattr(STDIN_FILENO, TCSANOW, &saved_);
+#endif
+            active_ = false;
+        }
+
+        static void write(const std::string& data) {
+            std::fwrite(data.data(), 1, data.size(), stdout);
+            std::fflush(stdout);
+        }
+
+        std::pair<int, int> size() const {
+#ifdef _WIN32
+            CONSOLE_SCREEN_BUFFER_INFO info;
+            if (GetConsoleScreenBufferInfo(GetStdHandle(STD_OUTPUT_HANDLE), &info)) {
+                return {info.srWindow.Right - info.srWindow.Left + 1,
+                        info.srWindow.Bottom - info.srWindow.Top + 1};
+            }
+#else
+            winsize ws{};
+            if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0 && ws.ws_col > 0) {
+                return {ws.ws_col, ws.ws_row};
+            }
+#endif
+            return {80, 24};
+        }
+
+        // Returns a character, one of Key, or -1 on timeout.
+        int read_key(std::chrono::milliseconds timeout) {
+#ifdef _WIN32
+            if (WaitForSingleObject(in_, static_cast<DWORD>(timeout.count())) != WAIT_OBJECT_0 ||
+                !_kbhit()) {
+                FlushConsoleInputBuffer(in_);
+                return -1;
+            }
+            int c = _getch();
+            if (c == 0 || c == 0xE0) {
+                switch (_getch()) {
+                    case 72: return KEY_UP;
+                    case 80: return KEY_DOWN;
+                    case 73: return KEY_PAGE_UP;
+                    case 81: return KEY_PAGE_DOWN;
+                    case 71: return KEY_HOME;
+                    case 79: return KEY_END;
+                    default: return -1;
+                }
+            }
+            return c == '\r' ? '\n' : c;
+#else
+            pollfd pfd{STDIN_FILENO, POLLIN, 0};
+            if (poll(&pfd, 1, static_cast<int>(timeout.count())) <= 0) {
+                return -1;
+            }
+            unsigned char buf[8];
+            ssize_t n = ::read(STDIN_FILENO, buf, sizeof(buf));
+            if (n <= 0) return -1;
+            if (buf[0] != 0x1b || n < 3 || buf[1] != '[') {
+                return buf[0];
+            }
+            switch (buf[2]) {
+                case 'A': return KEY_UP;
+                case 'B': return KEY_DOWN;
+                case 'H': return KEY_HOME;
+                case 'F': return KEY_END;
+                case '5': return KEY_PAGE_UP;
+                case '6': return KEY_PAGE_DOWN;
+                case '1': return KEY_HOME;
+                case '4': return KEY_END;
+                default: return -1;
+            }
+#endif
+        }
+
+    private:
+        bool active_ = false;
+#ifdef _WIN32
+        HANDLE in_ = nullptr;
+        DWORD saved_mode_ = 0;
+#else
+        termios saved_{};
+#endif
+    };
+
+    std::string fit(const std::string& text, std::size_t width) {
+        if (text.size() <= width) return text;
+        if (width <= 3) return text.substr(0, width);
+        return "..." + text.substr(text.size() - (width - 3));
+    }
+}
+
+Browser::Browser(const Config& config, fs::path root, int max_depth)
+    : config_(config), root_(std::move(root)), max_depth_(max_depth) {}
+
+Browser::~Browser() {
+    stop_workers();
+}
+
+// ============================================================================
+// Background scan and sizing
+// ============================================================================
+
+void Browser::start_workers() {
+    scanner_ = std::make_unique<Scanner>(config_);
+    scanner_->set_size_targets(false);
+    scanner_->set_retain_targets(false);
+    scanner_->set_target_callback([this](const TargetEntry& target) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            rows_.push_back(Row{target});
+            dirty_ = true;
+        }
+        work_cv_.notify_one();
+    });
+
+    scan_thread_ = std::thread([this] {
+        scanner_->scan(root_, max_depth_);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            scan_done_ = true;
+            dirty_ = true;
+        }
+        work_cv_.notify_all();
+    });
+
+    unsigned int count = std::clamp(std::thread::hardware_concurrency() / 2, 2u, 4u);
+    for (unsigned int i = 0; i < count; ++i) {
+        sizers_.emplace_back([this] { sizer_loop(); });
+    }
+}
+
+void Browser::stop_workers() {
+    stopping_.store(true, std::memory_order_relaxed);
+    if (scanner_) scanner_->cancel();
+    work_cv_.notify_all();
+
+    if (scan_thread_.joinable()) scan_thread_.join();
+    for (auto& sizer : sizers_) {
+        if (sizer.joinable()) sizer.join();
+    }
+    sizers_.clear();
+}
+
+bool Browser::claim_next(std::size_t& index, fs::path& path) {
+    auto claim = [&](std::size_t i) {
+        Row& row = rows_[i];
+        if (row.state != SizeState::Pending || row.deleted) return false;
+        row.state = SizeState::Sizing;
+        index = i;
+        path = row.entry.path;
+        return true;
+    };
+
+    // Rows waiting to be deleted first, then those on screen, then
+    // discovery order
+    for (std::size_t i : pending_delete_) {
+        if (claim(i)) return true;
+    }
+    for (std::size_t i : visible_rows_) {
+        if (claim(i)) return true;
+    }
+    while (next_unsized_ < rows_.size()) {
+        if (claim(next_unsized_++)) return true;
+    }
+    return false;
+}
+
+void Browser::sizer_loop() {
+    while (!stopping_.load(std::memory_order_relaxed)) {
+        std::size_t index = 0;
+        fs::path path;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (!claim_next(index, path)) {
+                work_cv_.wait_for(lock, TICK);
+                continue;
+            }
+        }
+
+        auto stats = Scanner::measure_directory(path, nullptr, &stopping_);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        Row& row = rows_[index];
+        row.entry.size = stats.bytes;
+        row.entry.shared_size = stats.shared_bytes;
+        row.entry.file_count = stats.files;
+        row.entry.dir_count = stats.dirs;
+        row.state = SizeState::Sized;
+        sized_count_++;
+        dirty_ = true;
+    }
+}
+
+// ============================================================================
+// View (filter + sort over an index permutation)
+// ============================================================================
+
+bool Browser::passes_filters(const Row& row) const {
+    if (row.deleted) return false;
+
+    if (type_filter_ > 0 && row.entry.project_type != TYPE_FILTERS[type_filter_]) {
+        return false;
+    }
+
+    if (age_filter_ > 0) {
+        auto age = std::chrono::system_clock::now() - row.entry.last_modified;
+        if (age < std::chrono::hours(24 * AGE_FILTER_DAYS[age_filter_])) return false;
+    }
+
+    if (size_filter_ > 0) {
+        if (row.state != SizeState::Sized || row.entry.size < SIZE_FILTERS[size_filter_]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void Browser::rebuild_view() {
+    std::size_t cursor_row = cursor_ < view_.size() ? view_[cursor_] : SIZE_MAX;
+
+    view_.clear();
+    for (std::size_t i = 0; i < rows_.size(); ++i) {
+        if (passes_filters(rows_[i])) view_.push_back(i);
+    }
+
+    auto by = [this](auto key) {
+        return [this, key](std::size_t a, std::size_t b) {
+            return key(rows_[a], rows_[b]);
+        };
+    };
+    switch (sort_by_) {
+        case SortBy::Size:
+            std::stable_sort(view_.begin(), view_.end(), by([](const Row& a, const Row& b) {
+                bool sa = a.state == SizeState::Sized;
+                bool sb = b.state == SizeState::Sized;
+                if (sa != sb) return sa;  // Unsized rows last
+                return a.entry.size > b.entry.size;
+            }));
+            break;
+        case SortBy::Name:
+            std::stable_sort(view_.begin(), view_.end(), by([](const Row& a, const Row& b) {
+                return a.entry.path.native() < b.entry.path.native();
+            }));
+            break;
+        case SortBy::Date:
+            std::stable_sort(view_.begin(), view_.end(), by([](const Row& a, const Row& b) {
+                return a.entry.last_modified < b.entry.last_modified;
+            }));
+            break;
+    }
+
+    cursor_ = 0;
+    if (cursor_row != SIZE_MAX) {
+        auto it = std::find(view_.begin(), view_.end(), cursor_row);
+        if (it != view_.end()) cursor_ = static_cast<std::size_t>(it - view_.begin());
+    }
+    dirty_ = false;
+}
+
+// ============================================================================
+// Rendering (visible window only, one write per frame)
+// ============================================================================
+
+void Browser::render(int width, int height) {
+    std::size_t page = static_cast<std::size_t>(std::max(1, height - HEADER_LINES - FOOTER_LINES));
+    if (cursor_ < scroll_) scroll_ = cursor_;
+    if (cursor_ >= scroll_ + page) scroll_ = cursor_ - page + 1;
+    if (scroll_ > view_.size()) scroll_ = 0;
+
+    std::size_t selected = 0;
+    std::uintmax_t selected_bytes = 0;
+    for (const auto& row : rows_) {
+        if (row.selected && !row.deleted) {
+            selected++;
+            selected_bytes += row.entry.exclusive_size();
+        }
+    }
+
+    const char* sort_names[] = {"size", "name", "date"};
+    std::string state = scan_done_ ? "scan done" : "scanning...";
+    std::string frame = "\033[H";
+    frame += Display::Color::bold(" NUKE ui ") + fit(root_.string(), 40) + "  "
+           + Display::Color::dim(fmt::format("[{} | {} found | {}/{} sized]",
+                                             state, rows_.size(), sized_count_, rows_.size()))
+           + "\033[K\r\n";
+    frame += Display::Color::dim(fmt::format(" sort:{}  type:{}  age:>{}d  min:{}  showing {}",
+                                             sort_names[static_cast<int>(sort_by_)],
+                                             TYPE_FILTERS[type_filter_],
+                                             AGE_FILTER_DAYS[age_filter_],
+                                             format_bytes(SIZE_FILTERS[size_filter_]),
+                                             view_.size()))
+           + "\033[K\r\n";
+    frame += Display::Color::bold("       SIZE      TYPE     AGE   PATH") + "\033[K\r\n";
+
+    std::vector<std::size_t> on_screen;
+    std::size_t path_width = static_cast<std::size_t>(std::max(10, width - 38));
+    for (std::size_t line = 0; line < page; ++line) {
+        std::size_t pos = scroll_ + line;
+        if (pos >= view_.size()) {
+            frame += "\033[K\r\n";
+            continue;
+        }
+
+        const Row& row = rows_[view_[pos]];
+        on_screen.push_back(view_[pos]);
+
+        std::string size_str;
+        if (row.state == SizeState::Sized) {
+            size_str = Display::Color::cyan(fmt::format("{:>9}", format_bytes(row.entry.size)));
+        } else {
+            size_str = Display::Color::dim(fmt::format("{:>9}", row.state == SizeState::Sizing ? "sizing" : "..."));
+        }
+
+        std::string rel = row.entry.path.lexically_relative(root_).string();
+        std::string text = fmt::format(" {} [{}] ", pos == cursor_ ? ">" : " ", row.selected ? "x" : " ")
+                         + size_str + "   "
+                         + Display::Color::magenta(fmt::format("{:<8}", row.entry.project_type)) + " "
+                         + fmt::format("{:>5}", format_age(row.entry.last_modified)) + "   "
+                         + fit(rel.empty() ? row.entry.path.string() : rel, path_width);
+
+        if (pos == cursor_) {
+            frame += "\033[7m" + text + "\033[0m";
+        } else if (row.selected) {
+            frame += Display::Color::green(text);
+        } else {
+            frame += text;
+        }
+        frame += "\033[K\r\n";
+    }
+
+    frame += Display::Color::dim(" up/down move  space select  a all  s sort  t type  o age  z size  d delete  q quit")
+           + "\033[K\r\n";
+    frame += fmt::format(" Selected: {} ({})  {}", selected, format_bytes(selected_bytes), status_)
+           + "\033[K\033[J";
+
+    visible_rows_ = std::move(on_screen);
+    RawTerminal::write(frame);
+}
+
+// ============================================================================
+// Input
+// ============================================================================
+
+void Browser::move_cursor(long long delta) {
+    if (view_.empty()) {
+        cursor_ = 0;
+        return;
+    }
+    long long next = static_cast<long long>(cursor_) + delta;
+    long long last = static_cast<long long>(view_.size()) - 1;
+    cursor_ = static_cast<std::size_t>(std::clamp(next, 0LL, last));
+}
+
+void Browser::handle_key(int key, int page) {
+    status_.clear();
+    switch (key) {
+        case KEY_UP: case 'k': move_cursor(-1); break;
+        case KEY_DOWN: case 'j': move_cursor(1); break;
+        case KEY_PAGE_UP: move_cursor(-page); break;
+        case KEY_PAGE_DOWN: move_cursor(page); break;
+        case KEY_HOME: case 'g': cursor_ = 0; break;
+        case KEY_END: case 'G': move_cursor(static_cast<long long>(view_.size())); break;
+        case ' ':
+            if (cursor_ < view_.size()) {
+                Row& row = rows_[view_[cursor_]];
+                row.selected = !row.selected;
+                move_cursor(1);
+            }
+            break;
+        case 'a': {
+            bool all = std::all_of(view_.begin(), view_.end(),
+                                   [this](std::size_t i) { return rows_[i].selected; });
+            for (std::size_t i : view_) rows_[i].selected = !all;
+            break;
+        }
+        case 's':
+            sort_by_ = static_cast<SortBy>((static_cast<int>(sort_by_) + 1) % 3);
+            dirty_ = true;
+            break;
+        case 't':
+            type_filter_ = (type_filter_ + 1) % static_cast<int>(TYPE_FILTERS.size());
+            dirty_ = true;
+            break;
+        case 'o':
+            age_filter_ = (age_filter_ + 1) % static_cast<int>(AGE_FILTER_DAYS.size());
+            dirty_ = true;
+            break;
+        case 'z':
+            size_filter_ = (size_filter_ + 1) % static_cast<int>(SIZE_FILTERS.size());
+            dirty_ = true;
+            break;
+        default:
+            break;
+    }
+}
+
+// Prompts need exact totals: the sizers take the picked rows first (or
+// finish the ones they hold) while input keeps working, and the run loop
+// prompts once delete_ready()
+void Browser::request_delete() {
+    pending_delete_.clear();
+    std::size_t unsized = 0;
+    for (std::size_t i = 0; i < rows_.size(); ++i) {
+        if (!rows_[i].selected || rows_[i].deleted) continue;
+        pending_delete_.push_back(i);
+        if (rows_[i].state != SizeState::Sized) unsized++;
+    }
+    if (pending_delete_.empty()) {
+        status_ = "Nothing selected.";
+    } else if (unsized > 0) {
+        status_ = fmt::format("Sizing {} selected folders before deleting...", unsized);
+    }
+}
+
+bool Browser::delete_ready() const {
+    return !pending_delete_.empty() &&
+           std::all_of(pending_delete_.begin(), pending_delete_.end(),
+                       [this](std::size_t i) { return rows_[i].state == SizeState::Sized; });
+}
+
+void Browser::delete_selected() {
+    std::vector<std::size_t> picked;
+    std::vector<TargetEntry> targets;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (std::size_t i : pending_delete_) {
+            if (!rows_[i].selected || rows_[i].deleted) continue;
+            picked.push_back(i);
+            targets.push_back(rows_[i].entry);
+        }
+        pending_delete_.clear();
+    }
+    if (picked.empty()) {
+        status_ = "Nothing selected.";
+        return;
+    }
+    auto rejected = Safety(config_).validate(targets);
+    if (targets.empty()) {
+        status_ = "Protected: " + rejected.front().reason;
+        return;
+    }
+    // A lower bound: files linked only between picked rows are left out
+    std::uintmax_t total = 0;
+    for (const auto& target : targets) {
+        total += target.exclusive_size();
+    }
+
+    CostModel cost_model;
+    cost_model.load();
+    auto forecast = cost_model.predict(targets);
+    std::string eta = (forecast.calibrated ? "about " : "roughly ") + format_duration(forecast.total);
+
+    bool confirmed;
+    if (Safety::requires_captcha(total, targets.size())) {
+        confirmed = Display::captcha(fmt::format("About to delete {} ({} folders, {})",
+                                                 format_bytes(total), targets.size(), eta));
+    } else {
+        confirmed = Display::confirm(fmt::format("Delete {} folders ({}, {})? This cannot be undone.",
+                                                 targets.size(), format_bytes(total), eta), false);
+    }
+    if (!confirmed) {
+        status_ = "Deletion cancelled.";
+        return;
+    }
+
+    Destroyer destroyer(config_);
+    auto result = destroyer.destroy_all(targets);
+    if (cost_model.observe(result)) {
+        cost_model.save();
+    }
+    Stats::instance().load();
+    Stats::instance().record_deletion(result, targets);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (std::size_t i : picked) {
+            if (!fs::exists(rows_[i].entry.path)) {
+                rows_[i].deleted = true;
+                rows_[i].selected = false;
+            }
+        }
+        dirty_ = true;
+    }
+    status_ = fmt::format("Freed {} ({} deleted, {} failed, {} changed since the scan, {} protected)",
+                          format_bytes(result.freed_bytes), result.deleted_count,
+                          result.failed_count, result.skipped_count, rejected.size());
+}
+
+int Browser::run() {
+    if (!Display::is_terminal()) {
+        Logger::instance().error("nuke ui needs an interactive terminal.");
+        return 1;
+    }
+
+    Logger::instance().flush();
+    RawTerminal terminal;
+    start_workers();
+
+    auto last_rebuild = std::chrono::steady_clock::now() - TICK;
+    bool running = true;
+    while (running) {
+        auto [width, height] = terminal.size();
+        int page = std::max(1, height - HEADER_LINES - FOOTER_LINES);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto now = std::chrono::steady_clock::now();
+            if (dirty_ && now - last_rebuild >= TICK) {
+                rebuild_view();
+                last_rebuild = now;
+            }
+            render(width, height);
+        }
+        work_cv_.notify_all();
+
+        bool ready;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ready = delete_ready();
+        }
+        if (ready) {
+            terminal.suspend();
+            delete_selected();
+            terminal.resume();
+            continue;
+        }
+
+        int key = terminal.read_key(TICK);
+        if (key < 0) continue;
+
+        if (key == 'q' || key == 27) {
+            running = false;
+        } else if (key == 'd') {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                request_delete();
+            }
+            work_cv_.notify_all();
+        } else {
+            std::lock_guard<std::mutex> lock(mutex_);
+            handle_key(key, page);
+            if (dirty_) {
+                rebuild_view();
+                last_rebuild = std::chrono::steady_clock::now();
+            }
+        }
+    }
+
+    stop_workers();
+    return 0;
+}
+
+} // namespace nuke
@@ -1,27 +1,55 @@
 #include "nuke/ui/display.hpp"
 #include "nuke/ui/logger.hpp"
+#include "nuke/core/target_store.hpp"
 #include <fmt/core.h>
 #include <algorithm>
+#include <cstdio>
 #include <iostream>
 #include <iomanip>
+#include <numeric>
 #include <random>
+
+#ifdef _WIN32
 #include <Windows.h>
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
 
 namespace nuke {
 
 namespace {
     // Enable Virtual Terminal Processing for ANSI colors on Windows
+    // Colors are also used from worker threads (guard, server logs); the
+    // static's initialization runs exactly once
     void enable_ansi_colors() {
-        static bool initialized = false;
-        if (!initialized) {
+        static const bool initialized = [] {
+#ifdef _WIN32
             HANDLE hOut = GetStdHandle(STD_OUTPUT_HANDLE);
             DWORD dwMode = 0;
             if (GetConsoleMode(hOut, &dwMode)) {
                 dwMode |= ENABLE_VIRTUAL_TERMINAL_PROCESSING;
                 SetConsoleMode(hOut, dwMode);
             }
-            initialized = true;
-        }
+#endif
+            return true;
+        }();
+        (void)initialized;
+    }
+}
+
+namespace {
+    std::string format_delta(std::int64_t delta) {
+        std::uint64_t magnitude = delta < 0 ? 0 - static_cast<std::uint64_t>(delta)
+                                            : static_cast<std::uint64_t>(delta);
+        return (delta < 0 ? "-" : "+") + format_bytes(magnitude);
+    }
+
+    std::string format_duration_ns(std::uint64_t ns) {
+        if (ns >= 1000000000ULL) return fmt::format("{:.2f}s", ns / 1e9);
+        if (ns >= 1000000ULL) return fmt::format("{:.1f}ms", ns / 1e6);
+        if (ns >= 1000ULL) return fmt::format("{:.1f}us", ns / 1e3);
+        return fmt::format("{}ns", ns);
     }
 }
 
@@ -78,6 +106,7 @@ std::string Display::Color::dim(const std::string& text) {
 }
 
 void Display::show_banner() {
+    Logger::instance().flush();
     enable_ansi_colors();
     std::cout << Color::red(R"(
     _   _ _   _ _  _______
@@ -91,59 +120,112 @@ void Display::show_banner() {
 }
 
 void Display::show_scan_results(const ScanResult& results, SortBy sort_by) {
-    if (results.targets.empty()) {
+    Logger::instance().flush();
+    const TargetStore* store = results.store.get();
+    std::size_t count = store ? store->size() : results.targets.size();
+    if (count == 0) {
         std::cout << Color::yellow("No targets found.") << std::endl;
         return;
     }
     
-    auto sorted = results.targets;
-    switch (sort_by) {
-        case SortBy::Size:
-            std::sort(sorted.begin(), sorted.end(), 
-                [](const TargetEntry& a, const TargetEntry& b) { return a.size > b.size; });
-            break;
-        case SortBy::Name:
-            std::sort(sorted.begin(), sorted.end(),
-                [](const TargetEntry& a, const TargetEntry& b) { 
-                    return a.path.string() < b.path.string(); 
-                });
-            break;
-        case SortBy::Date:
-            std::sort(sorted.begin(), sorted.end(),
-                [](const TargetEntry& a, const TargetEntry& b) { 
-                    return a.last_modified < b.last_modified; 
-                });
-            break;
+    // Sort an index permutation; rows are never copied
+    std::vector<std::uint32_t> order;
+    if (store) {
+        order = store->order_by(sort_by);
+    } else {
+        const auto& targets = results.targets;
+        order.resize(count);
+        std::iota(order.begin(), order.end(), 0);
+        switch (sort_by) {
+            case SortBy::Size:
+                std::stable_sort(order.begin(), order.end(),
+                    [&targets](std::uint32_t a, std::uint32_t b) { return targets[a].size > targets[b].size; });
+                break;
+            case SortBy::Name:
+                std::sort(order.begin(), order.end(),
+                    [&targets](std::uint32_t a, std::uint32_t b) {
+                        return targets[a].path.native() < targets[b].path.native();
+                    });
+                break;
+            case SortBy::Date:
+                std::stable_sort(order.begin(), order.end(),
+                    [&targets](std::uint32_t a, std::uint32_t b) {
+                        return targets[a].last_modified < targets[b].last_modified;
+                    });
+                break;
+        }
     }
     
     std::cout << std::endl;
     std::cout << Color::bold("  SIZE       TYPE     PATH") << std::endl;
     std::cout << Color::dim("  ---------------------------------------------------------") << std::endl;
     
-    for (const auto& entry : sorted) {
-        std::string size_str = format_bytes(entry.size);
-        std::cout << "  " << Color::cyan(fmt::format("{:>8}", size_str)) 
-                  << "   " << Color::magenta(fmt::format("{:<8}", entry.project_type))
-                  << " " << entry.path.string() << std::endl;
+    for (auto i : order) {
+        std::uintmax_t size;
+        std::uintmax_t shared;
+        std::uintmax_t error;
+        std::string_view type;
+        fs::path path;
+        if (store) {
+            size = store->bytes(i);
+            shared = store->shared(i);
+            error = store->size_error(i);
+            type = project_type_to_string(store->type(i));
+            path = store->paths().path(store->node(i));
+        } else {
+            size = results.targets[i].size;
+            shared = results.targets[i].shared_size;
+            error = results.targets[i].size_error;
+            type = results.targets[i].project_type;
+            path = results.targets[i].path;
+        }
+        std::string size_str = (error > 0 ? "~" : "") + format_bytes(size);
+        std::cout << "  " << Color::cyan(fmt::format("{:>9}", size_str))
+                  << "  " << Color::magenta(fmt::format("{:<8}", type))
+                  << " " << path.string()
+                  << (error > 0 ? Color::dim(" (+/- " + format_bytes(error) + ")") : "")
+                  << (shared > 0 ? Color::dim(" (" + format_bytes(shared) + " hardlinked)") : "")
+                  << '\n';
     }
     
+    std::string total_str = format_bytes(results.total_size);
+    if (results.estimated) {
+        total_str = "~" + total_str + " +/- " + format_bytes(results.total_size_error);
+    }
     std::cout << Color::dim("  ---------------------------------------------------------") << std::endl;
     std::cout << "  " << Color::bold("Total: ") 
-              << Color::green(format_bytes(results.total_size))
+              << Color::green(total_str)
+              << (results.estimated ? Color::yellow(" (estimated)") : "")
+              << (results.complete ? "" : Color::yellow(" (partial scan)"))
               << " in " << Color::yellow(std::to_string(results.total_count)) << " folders"
               << Color::dim(" (scanned in " + std::to_string(results.scan_duration.count()) + "ms)")
               << std::endl;
+    if (results.total_shared > 0) {
+        std::cout << "  " << Color::dim(format_bytes(results.total_shared) +
+                                        " more is hardlinked from elsewhere and would not be freed")
+                  << std::endl;
+    }
+    if (results.roots.size() > 1) {
+        for (const auto& root : results.roots) {
+            std::cout << "  " << Color::cyan(fmt::format("{:>9}", format_bytes(root.total_size)))
+                      << Color::dim(fmt::format("  {:>6} folders  ", root.total_count))
+                      << root.root.string() << '\n';
+        }
+    }
     std::cout << std::endl;
 }
 
-void Display::show_deletion_results(const DeletionResult& results) {
+void Display::show_deletion_results(const DeletionResult& results, const DeletionForecast* forecast) {
+    Logger::instance().flush();
     std::cout << std::endl;
     
     if (results.deleted_count > 0) {
         std::cout << Color::green("+ ") << Color::bold("Successfully freed: ") 
                   << Color::green(format_bytes(results.freed_bytes)) << std::endl;
         std::cout << "  Deleted " << results.deleted_count << " folder(s) in " 
-                  << results.duration.count() << "ms" << std::endl;
+                  << results.duration.count() << "ms"
+                  << (forecast ? Color::dim(" (predicted " + format_duration(forecast->total) + ")") : "")
+                  << std::endl;
     }
     
     if (results.failed_count > 0) {
@@ -154,10 +236,120 @@ void Display::show_deletion_results(const DeletionResult& results) {
         }
     }
     
+    if (results.skipped_count > 0) {
+        std::cout << Color::yellow("! ") << Color::bold("Skipped (changed since the scan): ")
+                  << results.skipped_count << " folder(s)" << std::endl;
+        for (const auto& skipped : results.skipped) {
+            std::cout << "  " << Color::dim(skipped) << std::endl;
+        }
+    }
+    
+    std::cout << std::endl;
+}
+
+void Display::show_deletion_forecast(const std::vector<TargetEntry>& targets,
+                                     const DeletionForecast& forecast) {
+    constexpr std::size_t SLOWEST_SHOWN = 5;
+    
+    Logger::instance().flush();
+    std::cout << "  " << Color::bold("Deleting would take: ")
+              << Color::yellow((forecast.calibrated ? "about " : "roughly ") +
+                               format_duration(forecast.total))
+              << Color::dim(fmt::format(" ({} files and folders)", forecast.operations)) << std::endl;
+    if (!forecast.calibrated) {
+        std::cout << "  " << Color::dim("A guess for now: no deletion on this device has been timed yet")
+                  << std::endl;
+    }
+    
+    if (targets.size() > 1 && forecast.targets.size() == targets.size()) {
+        std::vector<std::size_t> order(targets.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::size_t shown = std::min(SLOWEST_SHOWN, order.size());
+        std::partial_sort(order.begin(), order.begin() + shown, order.end(),
+                          [&forecast](std::size_t a, std::size_t b) {
+                              return forecast.targets[a] > forecast.targets[b];
+                          });
+        // Only worth listing when some target takes noticeably long
+        if (forecast.targets[order[0]] < std::chrono::seconds(1)) {
+            shown = 0;
+        }
+        if (shown > 0) {
+            std::cout << "  " << Color::dim("Slowest to delete:") << std::endl;
+        }
+        for (std::size_t i = 0; i < shown; ++i) {
+            std::cout << "  " << Color::cyan(fmt::format("{:>9}", format_duration(forecast.targets[order[i]])))
+                      << "  " << targets[order[i]].path.string() << '\n';
+        }
+    }
+    std::cout << std::endl;
+}
+
+void Display::show_snapshot_diff(const SnapshotDiff& diff) {
+    Logger::instance().flush();
+    std::cout << std::endl;
+    
+    for (const auto& change : diff.changes) {
+        std::string delta = fmt::format("{:>11}", format_delta(change.delta()));
+        std::string detail;
+        switch (change.kind) {
+            case SnapshotChange::Kind::Added: detail = "new"; break;
+            case SnapshotChange::Kind::Removed: detail = "removed"; break;
+            default:
+                detail = format_bytes(change.old_bytes) + " -> " + format_bytes(change.new_bytes);
+                break;
+        }
+        std::cout << "  " << (change.delta() >= 0 ? Color::red(delta) : Color::green(delta)) << "  "
+                  << Color::dim(fmt::format("{:<24}", detail)) << change.path << '\n';
+    }
+    if (diff.changes.empty()) {
+        std::cout << Color::green("No targets changed.") << std::endl;
+    }
+    
+    std::cout << std::endl;
+    std::cout << "  " << Color::bold("Changes: ")
+              << fmt::format("{} new, {} removed, {} grown, {} shrunk, {} unchanged",
+                             diff.added, diff.removed, diff.grown, diff.shrunk, diff.unchanged)
+              << std::endl;
+    std::int64_t total_delta = static_cast<std::int64_t>(diff.new_total) - static_cast<std::int64_t>(diff.old_total);
+    std::cout << "  " << Color::bold("Total: ") << format_bytes(diff.old_total) << " -> "
+              << format_bytes(diff.new_total) << " ("
+              << (total_delta > 0 ? Color::red(format_delta(total_delta)) : Color::green(format_delta(total_delta)))
+              << ")" << std::endl;
+    std::cout << std::endl;
+}
+
+void Display::show_quota_plan(const QuotaPlan& plan) {
+    Logger::instance().flush();
+    std::cout << std::endl;
+    
+    if (!plan.evict.empty()) {
+        std::cout << Color::bold("  SIZE       TYPE     IDLE   PATH") << std::endl;
+        std::cout << Color::dim("  ---------------------------------------------------------") << std::endl;
+        for (const auto& target : plan.evict) {
+            std::cout << "  " << Color::cyan(fmt::format("{:>9}", format_bytes(target.size)))
+                      << "  " << Color::magenta(fmt::format("{:<8}", target.project_type))
+                      << " " << Color::dim(fmt::format("{:>5}", format_age(target.recency())))
+                      << "  " << target.path.string() << '\n';
+        }
+        std::cout << Color::dim("  ---------------------------------------------------------") << std::endl;
+    }
+    
+    for (const auto& usage : plan.usage) {
+        std::string used = format_bytes(usage.used_bytes) + " of " + format_bytes(usage.budget->max_bytes);
+        std::cout << "  " << Color::bold(usage.budget->label) << ": "
+                  << (usage.over() ? Color::red(used) : Color::green(used))
+                  << Color::dim(fmt::format(" in {} folders", usage.targets));
+        if (usage.evicted > 0) {
+            std::cout << ", evicting " << Color::yellow(std::to_string(usage.evicted)) << " ("
+                      << format_bytes(usage.evicted_bytes) << ") -> " << format_bytes(usage.kept_bytes());
+        }
+        std::cout << std::endl;
+    }
     std::cout << std::endl;
 }
 
 void Display::show_stats(const UserStats& stats) {
+    Logger::instance().flush();
     std::cout << std::endl;
     std::cout << Color::bold("===========================================") << std::endl;
     std::cout << Color::bold("           NUKE STATISTICS") << std::endl;
@@ -187,33 +379,73 @@ void Display::show_stats(const UserStats& stats) {
     std::cout << std::endl;
 }
 
+void Display::show_profile(const Profiler& profiler) {
+    Logger::instance().flush();
+    std::cout << std::endl;
+    std::cout << Color::bold("  PROFILE: filesystem operations") << std::endl;
+    std::cout << Color::bold("  OP              COUNT      TOTAL      MEAN       P50       P90       P99       MAX") << std::endl;
+    std::cout << Color::dim("  -----------------------------------------------------------------------------------") << std::endl;
+    
+    for (std::size_t i = 0; i < static_cast<std::size_t>(FsOp::Count); ++i) {
+        auto op = static_cast<FsOp>(i);
+        auto h = profiler.totals(op);
+        if (h.count() == 0) continue;
+        
+        std::cout << "  " << Color::cyan(fmt::format("{:<12}", fs_op_to_string(op)))
+                  << fmt::format("{:>9} {:>10} {:>9} {:>9} {:>9} {:>9} {:>9}",
+                                 h.count(),
+                                 format_duration_ns(h.total_ns()),
+                                 format_duration_ns(h.total_ns() / h.count()),
+                                 format_duration_ns(h.percentile(50)),
+                                 format_duration_ns(h.percentile(90)),
+                                 format_duration_ns(h.percentile(99)),
+                                 format_duration_ns(h.max_ns()))
+                  << std::endl;
+    }
+    
+    if (profiler.threads().size() > 1) {
+        std::cout << std::endl << Color::dim("  Per thread:") << std::endl;
+        for (const auto& thread : profiler.threads()) {
+            std::string line = fmt::format("    #{:<3}", thread->index);
+            for (std::size_t i = 0; i < static_cast<std::size_t>(FsOp::Count); ++i) {
+                const auto& h = thread->ops[i];
+                if (h.count() == 0) continue;
+                line += fmt::format(" {}={} ({})", fs_op_to_string(static_cast<FsOp>(i)),
+                                    h.count(), format_duration_ns(h.total_ns()));
+            }
+            std::cout << line << std::endl;
+        }
+    }
+    std::cout << std::endl;
+}
+
 void Display::show_scan_progress(const fs::path& current, std::size_t found) {
-    clear_line();
-    std::cout << "\r" << Color::dim("Scanning... ") 
-              << Color::cyan(std::to_string(found)) << " found"
-              << Color::dim(" | ") << current.filename().string();
+    Logger::instance().flush();
+    std::string line = "\r\033[K" + Color::dim("Scanning... ")
+                     + Color::cyan(std::to_string(found)) + " found"
+                     + Color::dim(" | ") + current.filename().string();
+    std::cout << line;
     std::cout.flush();
 }
 
 void Display::show_deletion_progress(std::size_t current, std::size_t total,
                                       const fs::path& current_path) {
-    clear_line();
+    Logger::instance().flush();
     
     const int bar_width = 30;
     double progress = static_cast<double>(current) / total;
     int filled = static_cast<int>(bar_width * progress);
     
-    std::cout << "\r  [";
-    for (int i = 0; i < bar_width; ++i) {
-        if (i < filled) std::cout << Color::green("#");
-        else std::cout << Color::dim("-");
-    }
-    std::cout << "] " << current << "/" << total << " ";
-    std::cout << Color::dim(current_path.filename().string());
+    std::string line = "\r\033[K  [" + Color::green(std::string(filled, '#'))
+                     + Color::dim(std::string(bar_width - filled, '-')) + "] "
+                     + std::to_string(current) + "/" + std::to_string(total) + " "
+                     + Color::dim(current_path.filename().string());
+    std::cout << line;
     std::cout.flush();
 }
 
 bool Display::confirm(const std::string& message, bool default_yes) {
+    Logger::instance().flush();
     std::cout << message << (default_yes ? " [Y/n]: " : " [y/N]: ");
     std::cout.flush();
     
@@ -229,6 +461,7 @@ bool Display::confirm(const std::string& message, bool default_yes) {
 }
 
 bool Display::captcha(const std::string& reason) {
+    Logger::instance().flush();
     const std::string chars = "ABCDEFGHJKLMNPQRSTUVWXYZ23456789";
     std::random_device rd;
     std::mt19937 gen(rd());
@@ -252,22 +485,83 @@ bool Display::captcha(const std::string& reason) {
     return input == code;
 }
 
-void Display::show_tree(const std::vector<TargetEntry>& entries, int /*max_depth*/) {
-    std::cout << std::endl;
-    for (const auto& entry : entries) {
-        std::cout << "  " << Color::dim("+-- ") 
-                  << Color::cyan(entry.path.filename().string())
-                  << Color::dim(" (" + format_bytes(entry.size) + ")") << std::endl;
-        std::cout << "  " << Color::dim("|   +-- ") 
-                  << entry.path.parent_path().string() << std::endl;
+void Display::show_tree(const ScanResult& results, int max_depth) {
+    Logger::instance().flush();
+    if (!results.store || results.store->size() == 0) {
+        std::cout << Color::yellow("No targets found.") << std::endl;
+        return;
+    }
+    const TargetStore& store = *results.store;
+    const PathArena& paths = store.paths();
+    
+    // Children in CSR form, each range sorted by subtree size
+    std::vector<std::uint32_t> offsets;
+    std::vector<std::uint32_t> children;
+    paths.child_index(offsets, children);
+    for (std::size_t i = 0; i + 1 < offsets.size(); ++i) {
+        std::sort(children.begin() + offsets[i], children.begin() + offsets[i + 1],
+            [&store](std::uint32_t a, std::uint32_t b) {
+                return store.subtree_bytes(a) > store.subtree_bytes(b);
+            });
     }
+    
+    auto name_of = [&paths](std::uint32_t node) { return std::string(paths.name(node)); };
+    
+    struct Frame {
+        std::uint32_t node;
+        int depth;
+        std::string prefix;
+        bool last;
+    };
+    std::vector<Frame> stack;
+    auto push_children = [&](std::uint32_t node, int depth, const std::string& prefix) {
+        for (auto i = offsets[node + 1]; i > offsets[node]; --i) {
+            stack.push_back({children[i - 1], depth, prefix, i == offsets[node + 1]});
+        }
+    };
+    
+    // One tree per scan root
     std::cout << std::endl;
+    for (std::uint32_t root = 0; root < paths.size(); ++root) {
+        if (paths.parent(root) != PathArena::NO_PARENT) continue;
+        
+        std::cout << "  " << Color::bold(name_of(root)) << "  "
+                  << Color::green(format_bytes(store.subtree_bytes(root)))
+                  << Color::dim(" in " + std::to_string(store.subtree_targets(root)) + " targets") << std::endl;
+        push_children(root, 1, "  ");
+        
+        while (!stack.empty()) {
+            Frame frame = std::move(stack.back());
+            stack.pop_back();
+            std::string name = name_of(frame.node);
+            bool leaf = offsets[frame.node + 1] == offsets[frame.node];
+            bool collapsed = !leaf && max_depth >= 0 && frame.depth >= max_depth;
+            
+            std::cout << frame.prefix << Color::dim(frame.last ? "`-- " : "+-- ")
+                      << Color::cyan(fmt::format("{:>9}", format_bytes(store.subtree_bytes(frame.node)))) << "  "
+                      << (leaf ? Color::magenta(name) : name + (collapsed ? "/..." : "/"))
+                      << (leaf ? "" : Color::dim(" (" + std::to_string(store.subtree_targets(frame.node)) + ")"))
+                      << '\n';
+            
+            if (!leaf && !collapsed) {
+                push_children(frame.node, frame.depth + 1, frame.prefix + (frame.last ? "    " : "|   "));
+            }
+        }
+        std::cout << std::endl;
+    }
 }
 
 void Display::clear_line() {
-    std::cout << "\r";
-    for (int i = 0; i < 100; ++i) std::cout << ' ';
-    std::cout << "\r";
+    enable_ansi_colors();
+    std::cout << "\r\033[K";
+}
+
+bool Display::is_terminal() {
+#ifdef _WIN32
+    return _isatty(_fileno(stdout)) != 0;
+#else
+    return isatty(fileno(stdout)) != 0;
+#endif
 }
 
 } // namespace nuke
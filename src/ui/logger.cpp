@@ -1,6 +1,6 @@
 #include "nuke/ui/logger.hpp"
 #include "nuke/ui/display.hpp"
-#include <iostream>
+#include <cstdio>
 
 namespace nuke {
 
@@ -9,62 +9,134 @@ Logger& Logger::instance() {
     return logger;
 }
 
+Logger::~Logger() {
+    if (writer_.joinable()) {
+        stopping_.store(true, std::memory_order_release);
+        wakeups_.fetch_add(1, std::memory_order_release);
+        wakeups_.notify_one();
+        writer_.join();
+    }
+}
+
+void Logger::write(std::string text, bool to_stderr) const {
+    std::call_once(writer_started_, [this] {
+        writer_ = std::thread([this] { writer_loop(); });
+    });
+
+    text += '\n';
+    Record record{std::move(text), to_stderr || reserve_stdout_};
+    while (!queue_.try_push(std::move(record))) {
+        // Queue is full: let the writer catch up rather than dropping lines
+        wakeups_.notify_one();
+        std::this_thread::yield();
+    }
+
+    pushed_.fetch_add(1, std::memory_order_release);
+    wakeups_.fetch_add(1, std::memory_order_release);
+    wakeups_.notify_one();
+}
+
+void Logger::writer_loop() const {
+    std::string out_batch;
+    std::string err_batch;
+    Record record;
+
+    for (;;) {
+        auto seen = wakeups_.load(std::memory_order_acquire);
+
+        std::uint64_t count = 0;
+        while (queue_.try_pop(record)) {
+            (record.to_stderr ? err_batch : out_batch) += record.text;
+            ++count;
+        }
+
+        if (count > 0) {
+            if (!err_batch.empty()) {
+                std::fwrite(err_batch.data(), 1, err_batch.size(), stderr);
+                std::fflush(stderr);
+                err_batch.clear();
+            }
+            if (!out_batch.empty()) {
+                std::fwrite(out_batch.data(), 1, out_batch.size(), stdout);
+                std::fflush(stdout);
+                out_batch.clear();
+            }
+            written_.fetch_add(count, std::memory_order_release);
+            written_.notify_all();
+            continue;
+        }
+
+        if (stopping_.load(std::memory_order_acquire)) {
+            break;
+        }
+        wakeups_.wait(seen, std::memory_order_acquire);
+    }
+}
+
+void Logger::flush() const {
+    auto target = pushed_.load(std::memory_order_acquire);
+    auto done = written_.load(std::memory_order_acquire);
+    while (done < target) {
+        written_.wait(done, std::memory_order_acquire);
+        done = written_.load(std::memory_order_acquire);
+    }
+}
+
 void Logger::quiet(const std::string& msg) const {
-    std::cerr << msg << std::endl;
+    write(msg, true);
 }
 
 void Logger::minimal(const std::string& msg) const {
     if (verbosity_ >= Verbosity::Minimal) {
-        std::cout << msg << std::endl;
+        write(msg, false);
     }
 }
 
 void Logger::normal(const std::string& msg) const {
     if (verbosity_ >= Verbosity::Normal) {
-        std::cout << msg << std::endl;
+        write(msg, false);
     }
 }
 
 void Logger::detailed(const std::string& msg) const {
     if (verbosity_ >= Verbosity::Detailed) {
-        std::cout << Display::Color::dim("[DETAIL] ") << msg << std::endl;
+        write(Display::Color::dim("[DETAIL] ") + msg, false);
     }
 }
 
 void Logger::diagnostic(const std::string& msg) const {
     if (verbosity_ >= Verbosity::Diagnostic) {
-        std::cout << Display::Color::cyan("[DIAG] ") << msg << std::endl;
+        write(Display::Color::cyan("[DIAG] ") + msg, false);
     }
 }
 
 void Logger::error(const std::string& msg) const {
     if (verbosity_ != Verbosity::Quiet) {
-        std::cerr << Display::Color::red("[ERROR] ") << msg << std::endl;
+        write(Display::Color::red("[ERROR] ") + msg, true);
     }
 }
 
 void Logger::success(const std::string& msg) const {
     if (verbosity_ >= Verbosity::Minimal) {
-        std::cout << Display::Color::green(msg) << std::endl;
+        write(Display::Color::green(msg), false);
     }
 }
 
 void Logger::warning(const std::string& msg) const {
     if (verbosity_ >= Verbosity::Normal) {
-        std::cout << Display::Color::yellow("[WARNING] ") << msg << std::endl;
+        write(Display::Color::yellow("[WARNING] ") + msg, false);
     }
 }
 
-Logger::Timer::Timer(const std::string& operation) 
+Logger::Timer::Timer(const char* operation)
     : operation_(operation), start_(std::chrono::high_resolution_clock::now()) {
-    Logger::instance().diagnostic("Starting: " + operation_);
+    NUKE_DIAG("Starting: {}", operation_);
 }
 
 Logger::Timer::~Timer() {
     auto end = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start_);
-    Logger::instance().diagnostic(operation_ + " completed in " + 
-                                   std::to_string(duration.count()) + "ms");
+    NUKE_DIAG("{} completed in {}ms", operation_, duration.count());
 }
 
 } // namespace nuke
@@ -0,0 +1,124 @@
+#include "nuke/ui/progress.hpp"
+#include "nuke/ui/display.hpp"
+#include "nuke/ui/logger.hpp"
+#include <fmt/core.h>
+#include <cstdio>
+
+namespace nuke {
+
+namespace {
+    constexpr auto PLAIN_INTERVAL = std::chrono::seconds(2);
+    constexpr int BAR_WIDTH = 30;
+
+    std::string format_count(double value) {
+        if (value >= 1e6) return fmt::format("{:.1f}M", value / 1e6);
+        if (value >= 1e4) return fmt::format("{:.1f}k", value / 1e3);
+        return fmt::format("{:.0f}", value);
+    }
+
+    std::string format_clock(double seconds) {
+        auto total = static_cast<long long>(seconds);
+        if (total >= 3600) {
+            return fmt::format("{}:{:02}:{:02}", total / 3600, (total / 60) % 60, total % 60);
+        }
+        return fmt::format("{}:{:02}", total / 60, total % 60);
+    }
+}
+
+ProgressRenderer::ProgressRenderer(Phase phase, std::chrono::milliseconds interval)
+    : phase_(phase), interval_(interval), tty_(Display::is_terminal()) {}
+
+ProgressRenderer::~ProgressRenderer() {
+    stop();
+}
+
+void ProgressRenderer::set_totals(std::size_t items, std::uintmax_t bytes) {
+    total_items_ = items;
+    total_bytes_ = bytes;
+}
+
+void ProgressRenderer::start() {
+    if (thread_.joinable()) return;
+    started_ = std::chrono::steady_clock::now();
+    stopping_ = false;
+    thread_ = std::thread([this] { run(); });
+}
+
+void ProgressRenderer::stop() {
+    if (!thread_.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_one();
+    thread_.join();
+
+    if (tty_) {
+        Display::clear_line();
+        std::fflush(stdout);
+    }
+}
+
+void ProgressRenderer::run() {
+    auto interval = tty_ ? std::chrono::duration_cast<std::chrono::milliseconds>(interval_)
+                         : std::chrono::duration_cast<std::chrono::milliseconds>(PLAIN_INTERVAL);
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    while (!cv_.wait_for(lock, interval, [this] { return stopping_; })) {
+        auto elapsed = std::chrono::steady_clock::now() - started_;
+        std::string frame = render_frame(elapsed, !tty_);
+
+        Logger::instance().flush();
+        std::fwrite(frame.data(), 1, frame.size(), stdout);
+        std::fflush(stdout);
+    }
+}
+
+std::string ProgressRenderer::render_frame(std::chrono::steady_clock::duration elapsed,
+                                           bool plain) const {
+    double seconds = std::chrono::duration<double>(elapsed).count();
+    double rate_div = seconds > 0.0 ? seconds : 1.0;
+
+    std::size_t entries = counters_.entries.load(std::memory_order_relaxed);
+    std::size_t items = counters_.items.load(std::memory_order_relaxed);
+    std::uintmax_t bytes = counters_.bytes.load(std::memory_order_relaxed);
+    std::string bytes_rate = format_bytes(static_cast<std::uintmax_t>(bytes / rate_div)) + "/s";
+
+    auto dim = [plain](const std::string& text) { return plain ? text : Display::Color::dim(text); };
+    auto cyan = [plain](const std::string& text) { return plain ? text : Display::Color::cyan(text); };
+
+    std::string line = plain ? std::string() : std::string("\r");
+
+    if (phase_ == Phase::Scanning) {
+        line += dim("Scanning... ") + cyan(std::to_string(items)) + " found"
+              + dim(" | ") + format_count(static_cast<double>(entries)) + " entries ("
+              + format_count(entries / rate_div) + "/s)"
+              + dim(" | ") + format_bytes(bytes) + " sized (" + bytes_rate + ")"
+              + dim(" | ") + format_clock(seconds);
+    } else {
+        double fraction = 0.0;
+        if (total_bytes_ > 0) {
+            fraction = static_cast<double>(bytes) / static_cast<double>(total_bytes_);
+        } else if (total_items_ > 0) {
+            fraction = static_cast<double>(items) / static_cast<double>(total_items_);
+        }
+        if (fraction > 1.0) fraction = 1.0;
+        int filled = static_cast<int>(BAR_WIDTH * fraction);
+
+        std::string bar = std::string(filled, '#');
+        std::string rest = std::string(BAR_WIDTH - filled, '-');
+        line += "  [" + (plain ? bar : Display::Color::green(bar)) + dim(rest) + "] "
+              + std::to_string(items) + "/" + std::to_string(total_items_)
+              + dim(" | ") + format_bytes(bytes) + "/" + format_bytes(total_bytes_)
+              + " (" + bytes_rate + ")";
+
+        if (fraction > 0.0 && fraction < 1.0) {
+            line += dim(" | ETA ") + format_clock(seconds * (1.0 - fraction) / fraction);
+        }
+    }
+
+    line += plain ? "\n" : "\033[K";
+    return line;
+}
+
+} // namespace nuke
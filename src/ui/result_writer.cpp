@@ -0,0 +1,234 @@
+#include "nuke/ui/result_writer.hpp"
+#include "nuke/utils/json.hpp"
+
+namespace nuke {
+
+namespace {
+    constexpr std::size_t FLUSH_THRESHOLD = 256 * 1024;
+    // Slow scans still deliver records to the consumer promptly.
+    constexpr auto FLUSH_INTERVAL = std::chrono::milliseconds(500);
+
+    long long to_unix_seconds(std::chrono::system_clock::time_point tp) {
+        return std::chrono::duration_cast<std::chrono::seconds>(tp.time_since_epoch()).count();
+    }
+}
+
+ResultWriter::ResultWriter(OutputFormat format, const std::string& command, std::FILE* out)
+    : format_(format), out_(out) {
+    if (format_ == OutputFormat::Json) {
+        fmt::format_to(std::back_inserter(buffer_), "{{\"command\":");
+        append_json_string(buffer_, command);
+        fmt::format_to(std::back_inserter(buffer_), ",\"targets\":[");
+    }
+}
+
+ResultWriter::~ResultWriter() {
+    finish();
+}
+
+void ResultWriter::begin_record(const char* type) {
+    if (format_ == OutputFormat::Ndjson) {
+        fmt::format_to(std::back_inserter(buffer_), "{{\"type\":\"{}\",", type);
+    } else {
+        if (!targets_closed_) {
+            buffer_.push_back(']');
+            targets_closed_ = true;
+        }
+        fmt::format_to(std::back_inserter(buffer_), ",\"{}\":{{", type);
+    }
+}
+
+void ResultWriter::end_record() {
+    buffer_.push_back('}');
+    if (format_ == OutputFormat::Ndjson) {
+        buffer_.push_back('\n');
+    }
+}
+
+void ResultWriter::write_target(const TargetEntry& target) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (format_ == OutputFormat::Ndjson) {
+        fmt::format_to(std::back_inserter(buffer_), "{{\"type\":\"target\",\"path\":");
+    } else {
+        if (target_count_ > 0) buffer_.push_back(',');
+        fmt::format_to(std::back_inserter(buffer_), "{{\"path\":");
+    }
+    append_json_path(buffer_, target.path);
+    fmt::format_to(std::back_inserter(buffer_),
+                   ",\"size\":{},\"project_type\":", target.size);
+    append_json_string(buffer_, target.project_type);
+    fmt::format_to(std::back_inserter(buffer_),
+                   ",\"size_error\":{},\"shared_size\":{},\"mtime\":{},\"last_used\":{},\"files\":{},\"dirs\":{}",
+                   target.size_error, target.shared_size, to_unix_seconds(target.last_modified),
+                   to_unix_seconds(target.recency()), target.file_count, target.dir_count);
+    end_record();
+
+    target_count_++;
+    flush_if_full();
+}
+
+void ResultWriter::write_scan_summary(const ScanResult& result,
+                                      const std::vector<Safety::Rejection>& rejected) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    begin_record("scan_summary");
+    fmt::format_to(std::back_inserter(buffer_),
+                   "\"total_size\":{},\"total_size_error\":{},\"total_shared\":{},\"estimated\":{},"
+                   "\"total_count\":{},\"complete\":{},\"duration_ms\":{}",
+                   result.total_size, result.total_size_error, result.total_shared, result.estimated,
+                   result.total_count, result.complete, result.scan_duration.count());
+    fmt::format_to(std::back_inserter(buffer_), ",\"roots\":[");
+    for (std::size_t i = 0; i < result.roots.size(); ++i) {
+        if (i > 0) buffer_.push_back(',');
+        fmt::format_to(std::back_inserter(buffer_), "{{\"root\":");
+        append_json_path(buffer_, result.roots[i].root);
+        fmt::format_to(std::back_inserter(buffer_), ",\"total_size\":{},\"total_count\":{}}}",
+                       result.roots[i].total_size, result.roots[i].total_count);
+    }
+    fmt::format_to(std::back_inserter(buffer_), "],\"rejected\":[");
+    for (std::size_t i = 0; i < rejected.size(); ++i) {
+        if (i > 0) buffer_.push_back(',');
+        fmt::format_to(std::back_inserter(buffer_), "{{\"path\":");
+        append_json_path(buffer_, rejected[i].target.path);
+        fmt::format_to(std::back_inserter(buffer_), ",\"reason\":");
+        append_json_string(buffer_, rejected[i].reason);
+        buffer_.push_back('}');
+    }
+    buffer_.push_back(']');
+    end_record();
+    flush_if_full();
+}
+
+void ResultWriter::write_forecast(const std::vector<TargetEntry>& targets,
+                                  const DeletionForecast& forecast) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    begin_record("deletion_forecast");
+    fmt::format_to(std::back_inserter(buffer_),
+                   "\"predicted_ms\":{},\"operations\":{},\"calibrated\":{},\"targets\":[",
+                   forecast.total.count(), forecast.operations, forecast.calibrated);
+    for (std::size_t i = 0; i < targets.size() && i < forecast.targets.size(); ++i) {
+        if (i > 0) buffer_.push_back(',');
+        fmt::format_to(std::back_inserter(buffer_), "{{\"path\":");
+        append_json_path(buffer_, targets[i].path);
+        fmt::format_to(std::back_inserter(buffer_), ",\"predicted_ms\":{}}}", forecast.targets[i].count());
+        flush_if_full();
+    }
+    buffer_.push_back(']');
+    end_record();
+    flush_if_full();
+}
+
+void ResultWriter::write_deletion_summary(const DeletionResult& result) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    begin_record("deletion_summary");
+    fmt::format_to(std::back_inserter(buffer_),
+                   "\"deleted\":{},\"failed\":{},\"skipped\":{},\"freed_bytes\":{},\"duration_ms\":{},"
+                   "\"errors\":[",
+                   result.deleted_count, result.failed_count, result.skipped_count, result.freed_bytes,
+                   result.duration.count());
+    for (std::size_t i = 0; i < result.errors.size(); ++i) {
+        if (i > 0) buffer_.push_back(',');
+        append_json_string(buffer_, result.errors[i]);
+    }
+    fmt::format_to(std::back_inserter(buffer_), "],\"skipped_reasons\":[");
+    for (std::size_t i = 0; i < result.skipped.size(); ++i) {
+        if (i > 0) buffer_.push_back(',');
+        append_json_string(buffer_, result.skipped[i]);
+    }
+    buffer_.push_back(']');
+    end_record();
+    flush_if_full();
+}
+
+void ResultWriter::write_change(const SnapshotChange& change) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (format_ == OutputFormat::Ndjson) {
+        fmt::format_to(std::back_inserter(buffer_), "{{\"type\":\"change\",\"path\":");
+    } else {
+        if (target_count_ > 0) buffer_.push_back(',');
+        fmt::format_to(std::back_inserter(buffer_), "{{\"path\":");
+    }
+    append_json_string(buffer_, change.path);
+    fmt::format_to(std::back_inserter(buffer_),
+                   ",\"change\":\"{}\",\"project_type\":\"{}\",\"old_size\":{},\"new_size\":{},\"delta\":{}",
+                   change_kind_to_string(change.kind), project_type_to_string(change.type),
+                   change.old_bytes, change.new_bytes, change.delta());
+    end_record();
+
+    target_count_++;
+    flush_if_full();
+}
+
+void ResultWriter::write_diff_summary(const SnapshotDiff& diff) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    begin_record("diff_summary");
+    fmt::format_to(std::back_inserter(buffer_),
+                   "\"added\":{},\"removed\":{},\"grown\":{},\"shrunk\":{},\"unchanged\":{},"
+                   "\"old_total\":{},\"new_total\":{},\"delta\":{},\"complete\":{}",
+                   diff.added, diff.removed, diff.grown, diff.shrunk, diff.unchanged, diff.old_total,
+                   diff.new_total,
+                   static_cast<std::int64_t>(diff.new_total) - static_cast<std::int64_t>(diff.old_total),
+                   !diff.corrupt);
+    end_record();
+    flush_if_full();
+}
+
+void ResultWriter::write_quota_summary(const QuotaPlan& plan) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    begin_record("quota_summary");
+    fmt::format_to(std::back_inserter(buffer_), "\"evict_count\":{},\"evict_bytes\":{},\"quotas\":[",
+                   plan.evict.size(), plan.evict_bytes);
+    for (std::size_t i = 0; i < plan.usage.size(); ++i) {
+        const auto& usage = plan.usage[i];
+        if (i > 0) buffer_.push_back(',');
+        fmt::format_to(std::back_inserter(buffer_), "{{\"quota\":");
+        append_json_string(buffer_, usage.budget->label);
+        fmt::format_to(std::back_inserter(buffer_),
+                       ",\"max_size\":{},\"used\":{},\"targets\":{},\"evicted\":{},\"evicted_bytes\":{}}}",
+                       usage.budget->max_bytes, usage.used_bytes, usage.targets, usage.evicted,
+                       usage.evicted_bytes);
+    }
+    buffer_.push_back(']');
+    end_record();
+    flush_if_full();
+}
+
+void ResultWriter::finish() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (finished_) return;
+    finished_ = true;
+
+    if (format_ == OutputFormat::Json) {
+        if (!targets_closed_) {
+            buffer_.push_back(']');
+            targets_closed_ = true;
+        }
+        fmt::format_to(std::back_inserter(buffer_), "}}\n");
+    }
+    flush();
+    std::fflush(out_);
+}
+
+void ResultWriter::flush_if_full() {
+    if (buffer_.size() >= FLUSH_THRESHOLD ||
+        std::chrono::steady_clock::now() - last_flush_ >= FLUSH_INTERVAL) {
+        flush();
+        std::fflush(out_);
+    }
+}
+
+void ResultWriter::flush() {
+    if (buffer_.size() > 0) {
+        std::fwrite(buffer_.data(), 1, buffer_.size(), out_);
+        buffer_.clear();
+    }
+    last_flush_ = std::chrono::steady_clock::now();
+}
+
+} // namespace nuke
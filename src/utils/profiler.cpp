@@ -0,0 +1,141 @@
+#include "nuke/utils/profiler.hpp"
+#include <fmt/format.h>
+#include <algorithm>
+#include <bit>
+#include <fstream>
+
+namespace nuke {
+
+// ============================================================================
+// LatencyHistogram
+// ============================================================================
+
+int LatencyHistogram::bucket_index(std::uint64_t ns) {
+    if (ns < SUB_COUNT) {
+        return static_cast<int>(ns);
+    }
+    int msb = 63 - std::countl_zero(ns);
+    int shift = msb - SUB_BITS;
+    int sub = static_cast<int>((ns >> shift) & (SUB_COUNT - 1));
+    return (shift + 1) * SUB_COUNT + sub;
+}
+
+std::uint64_t LatencyHistogram::bucket_midpoint(int index) {
+    if (index < SUB_COUNT) {
+        return static_cast<std::uint64_t>(index);
+    }
+    int shift = index / SUB_COUNT - 1;
+    std::uint64_t sub = static_cast<std::uint64_t>(index % SUB_COUNT);
+    std::uint64_t low = (static_cast<std::uint64_t>(SUB_COUNT) + sub) << shift;
+    return low + ((std::uint64_t{1} << shift) >> 1);
+}
+
+void LatencyHistogram::record(std::uint64_t ns) {
+    buckets_[bucket_index(ns)]++;
+    count_++;
+    total_ns_ += ns;
+    min_ns_ = std::min(min_ns_, ns);
+    max_ns_ = std::max(max_ns_, ns);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    for (int i = 0; i < BUCKETS; ++i) {
+        buckets_[i] += other.buckets_[i];
+    }
+    count_ += other.count_;
+    total_ns_ += other.total_ns_;
+    min_ns_ = std::min(min_ns_, other.min_ns_);
+    max_ns_ = std::max(max_ns_, other.max_ns_);
+}
+
+std::uint64_t LatencyHistogram::percentile(double p) const {
+    if (count_ == 0) return 0;
+
+    auto rank = static_cast<std::uint64_t>(p / 100.0 * static_cast<double>(count_ - 1)) + 1;
+    std::uint64_t seen = 0;
+    for (int i = 0; i < BUCKETS; ++i) {
+        seen += buckets_[i];
+        if (seen >= rank) {
+            return std::clamp(bucket_midpoint(i), min_ns(), max_ns_);
+        }
+    }
+    return max_ns_;
+}
+
+// ============================================================================
+// Profiler
+// ============================================================================
+
+Profiler& Profiler::instance() {
+    static Profiler profiler;
+    return profiler;
+}
+
+Profiler::ThreadProfile& Profiler::local() {
+    thread_local ThreadProfile* profile = nullptr;
+    if (!profile) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        threads_.push_back(std::make_unique<ThreadProfile>());
+        profile = threads_.back().get();
+        profile->index = threads_.size() - 1;
+    }
+    return *profile;
+}
+
+void Profiler::record(FsOp op, std::uint64_t ns) {
+    local().ops[static_cast<std::size_t>(op)].record(ns);
+}
+
+LatencyHistogram Profiler::totals(FsOp op) const {
+    LatencyHistogram total;
+    for (const auto& thread : threads_) {
+        total.merge(thread->ops[static_cast<std::size_t>(op)]);
+    }
+    return total;
+}
+
+namespace {
+    void append_histogram_json(fmt::memory_buffer& out, const LatencyHistogram& h) {
+        fmt::format_to(std::back_inserter(out),
+            R"({{"count":{},"total_ns":{},"min_ns":{},"p50_ns":{},"p90_ns":{},"p99_ns":{},"max_ns":{}}})",
+            h.count(), h.total_ns(), h.min_ns(), h.percentile(50), h.percentile(90),
+            h.percentile(99), h.max_ns());
+    }
+
+    void append_ops_json(fmt::memory_buffer& out, const Profiler& profiler,
+                         const Profiler::ThreadProfile* thread) {
+        out.push_back('{');
+        bool first = true;
+        for (std::size_t i = 0; i < static_cast<std::size_t>(FsOp::Count); ++i) {
+            auto op = static_cast<FsOp>(i);
+            LatencyHistogram h = thread ? thread->ops[i] : profiler.totals(op);
+            if (h.count() == 0) continue;
+            if (!first) out.push_back(',');
+            first = false;
+            fmt::format_to(std::back_inserter(out), "\"{}\":", fs_op_to_string(op));
+            append_histogram_json(out, h);
+        }
+        out.push_back('}');
+    }
+}
+
+bool Profiler::write_json(const fs::path& path) const {
+    fmt::memory_buffer out;
+    fmt::format_to(std::back_inserter(out), R"({{"version":1,"ops":)");
+    append_ops_json(out, *this, nullptr);
+    fmt::format_to(std::back_inserter(out), R"(,"threads":[)");
+    for (std::size_t t = 0; t < threads_.size(); ++t) {
+        if (t > 0) out.push_back(',');
+        fmt::format_to(std::back_inserter(out), R"({{"thread":{},"ops":)", threads_[t]->index);
+        append_ops_json(out, *this, threads_[t].get());
+        out.push_back('}');
+    }
+    fmt::format_to(std::back_inserter(out), "]}}\n");
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file) return false;
+    file.write(out.data(), static_cast<std::streamsize>(out.size()));
+    return file.good();
+}
+
+} // namespace nuke
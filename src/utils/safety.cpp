@@ -1,12 +1,306 @@
 #include "nuke/utils/safety.hpp"
+#include "nuke/core/concurrency.hpp"
+#include "nuke/core/mount_table.hpp"
+#include "nuke/utils/profiler.hpp"
+#include <fmt/format.h>
 #include <algorithm>
-#include <cctype>
 #include <cstdlib>
+#include <mutex>
+
+#ifdef _WIN32
 #include <Windows.h>
 #include <ShlObj.h>
+#include <cwctype>
+#else
+#include <pwd.h>
+#include <unistd.h>
+#endif
 
 namespace nuke {
 
+namespace {
+    // Targets checked per pool task; a check is a couple of lookups, so
+    // one task each would cost more in queueing than in checking
+    constexpr std::size_t VALIDATE_CHUNK = 256;
+
+    // Absolute, without "." or ".." and without a trailing separator. The
+    // working directory is already physical, so dropping ".." lexically
+    // agrees with the kernel for every path the scanner produces.
+    fs::path normalize(const fs::path& path) {
+        std::error_code ec;
+        fs::path absolute = fs::absolute(path, ec);
+        if (ec) absolute = path;
+        absolute = absolute.lexically_normal();
+        if (!absolute.has_filename() && absolute.has_relative_path()) {
+            absolute = absolute.parent_path();
+        }
+        return absolute;
+    }
+
+    fs::path::string_type component_key(const fs::path& component) {
+        fs::path::string_type key = component.native();
+#ifdef _WIN32
+        // NTFS names compare case-insensitively
+        std::transform(key.begin(), key.end(), key.begin(),
+                       [](wchar_t c) { return static_cast<wchar_t>(std::towlower(c)); });
+#endif
+        return key;
+    }
+
+    // Follows `path` if it is a symlink (or a junction on Windows)
+    fs::path follow_link(const fs::path& path) {
+        std::error_code ec;
+        fs::file_status status;
+        {
+            NUKE_PROFILE(Stat);
+            status = fs::symlink_status(path, ec);
+        }
+        if (ec || !(fs::is_symlink(status) || fs::is_other(status))) {
+            return path;
+        }
+        NUKE_PROFILE(Canonicalize);
+        fs::path resolved = fs::weakly_canonical(path, ec);
+        return ec ? path : resolved;
+    }
+
+    fs::path home_directory() {
+#ifdef _WIN32
+        char home[MAX_PATH];
+        if (SUCCEEDED(SHGetFolderPathA(nullptr, CSIDL_PROFILE, nullptr, 0, home))) {
+            return fs::path(home);
+        }
+        return {};
+#else
+        if (const char* home = std::getenv("HOME"); home && *home) {
+            return fs::path(home);
+        }
+        if (const passwd* entry = ::getpwuid(::getuid()); entry && entry->pw_dir) {
+            return fs::path(entry->pw_dir);
+        }
+        return {};
+#endif
+    }
+
+#ifdef _WIN32
+    fs::path windows_folder(const char* variable, const char* fallback) {
+        const char* value = std::getenv(variable);
+        return fs::path(value && *value ? value : fallback);
+    }
+#endif
+}
+
+// ============================================================================
+// Construction
+// ============================================================================
+
+Safety::Safety(const Config& config) {
+    nodes_.emplace_back();
+    home_ = home_directory();
+
+    // First, so it keeps its own label if it is also a top-level directory
+    // or a mount point
+    if (!home_.empty()) {
+        protect(home_, Guard::Exact, true, "the home directory");
+    }
+
+#ifdef _WIN32
+    for (const auto& dir : {windows_folder("SystemRoot", "C:\\Windows"),
+                            windows_folder("ProgramFiles", "C:\\Program Files"),
+                            windows_folder("ProgramFiles(x86)", "C:\\Program Files (x86)"),
+                            windows_folder("ProgramData", "C:\\ProgramData")}) {
+        protect(dir, Guard::Subtree, true, "the system directory " + dir.string());
+    }
+#else
+    for (const char* dir : {"/usr", "/etc", "/bin", "/sbin", "/lib", "/lib32", "/lib64",
+                            "/boot", "/dev", "/proc", "/sys", "/run"}) {
+        protect(dir, Guard::Subtree, true, std::string("the system directory ") + dir);
+    }
+    // Projects live below these, but the directories themselves stay
+    for (const char* dir : {"/home", "/root", "/opt", "/srv", "/mnt", "/media", "/var", "/tmp"}) {
+        protect(dir, Guard::Exact, false, std::string("the top-level directory ") + dir);
+    }
+#endif
+
+    auto mounts = MountTable::load();
+    for (const auto& mount : mounts.mounts()) {
+        protect(mount.mount_point, Guard::Exact, false,
+                "the mount point " + mount.mount_point.string());
+    }
+
+    for (const auto& entry : config.protected_paths()) {
+        if (entry.empty()) continue;
+        protect(expand_home(entry), Guard::Subtree, true, "the protected path " + entry);
+    }
+}
+
+fs::path Safety::expand_home(const std::string& path) {
+    if (path == "~" || path.rfind("~/", 0) == 0) {
+        if (auto home = home_directory(); !home.empty()) {
+            return home / path.substr(std::min<std::size_t>(path.size(), 2));
+        }
+    }
+    return fs::path(path);
+}
+
+void Safety::protect(const fs::path& path, Guard guard, bool blocks_scan, std::string label) {
+    fs::path canonical = resolve(path);
+    std::uint32_t index = 0;
+    for (const auto& component : canonical) {
+        nodes_[index].guards_below = true;
+        auto key = component_key(component);
+        auto it = nodes_[index].children.find(key);
+        if (it != nodes_[index].children.end()) {
+            index = it->second;
+            continue;
+        }
+        auto child = static_cast<std::uint32_t>(nodes_.size());
+        nodes_[index].children.emplace(std::move(key), child);
+        nodes_.emplace_back();
+        index = child;
+    }
+
+    // A subtree guard outranks an exact one on the same directory
+    Node& node = nodes_[index];
+    if (node.guard == Guard::None || guard == Guard::Subtree) {
+        node.guard = guard;
+        node.label = std::move(label);
+    }
+    node.blocks_scan = node.blocks_scan || blocks_scan;
+}
+
+// ============================================================================
+// Path Resolution
+// ============================================================================
+
+fs::path Safety::resolve(const fs::path& path) const {
+    fs::path normal = normalize(path);
+    if (!normal.has_relative_path()) {
+        return normal;
+    }
+    return follow_link(resolve_directory(normal.parent_path()) / normal.filename());
+}
+
+fs::path Safety::resolve_directory(const fs::path& dir) const {
+    if (!dir.has_relative_path()) {
+        return dir;
+    }
+    {
+        std::shared_lock<std::shared_mutex> lock(cache_mutex_);
+        auto it = resolved_.find(dir.native());
+        if (it != resolved_.end()) {
+            return it->second;
+        }
+    }
+
+    // Ancestors first, so each directory costs a single lstat
+    fs::path resolved = follow_link(resolve_directory(dir.parent_path()) / dir.filename());
+
+    std::unique_lock<std::shared_mutex> lock(cache_mutex_);
+    resolved_.emplace(dir.native(), resolved);
+    return resolved;
+}
+
+// ============================================================================
+// Checks
+// ============================================================================
+
+std::string Safety::verdict(const fs::path& path, bool deleting) const {
+    fs::path canonical = resolve(path);
+    if (!canonical.has_relative_path()) {
+        return "Cannot delete the root directory";
+    }
+
+    const Node* node = &nodes_[0];
+    for (const auto& component : canonical) {
+        auto it = node->children.find(component_key(component));
+        if (it == node->children.end()) {
+            return "";  // Off the trie: nothing guards this path
+        }
+        node = &nodes_[it->second];
+        if (node->guard == Guard::Subtree && (deleting || node->blocks_scan)) {
+            return fmt::format("{} is inside {}", canonical.string(), node->label);
+        }
+    }
+
+    if (node->guard == Guard::Exact && (deleting || node->blocks_scan)) {
+        return "Cannot delete " + node->label;
+    }
+    if (deleting && node->guards_below) {
+        if (const Node* inner = first_guarded_below(*node)) {
+            return fmt::format("{} contains {}", canonical.string(), inner->label);
+        }
+    }
+    return "";
+}
+
+const Safety::Node* Safety::first_guarded_below(const Node& node) const {
+    for (const auto& [key, child] : node.children) {
+        const Node& next = nodes_[child];
+        if (next.guard != Guard::None) {
+            return &next;
+        }
+        if (const Node* inner = first_guarded_below(next)) {
+            return inner;
+        }
+    }
+    return nullptr;
+}
+
+std::string Safety::check_root(const fs::path& root) const {
+    std::string filename = root.filename().string();
+    if (is_protected_folder(filename)) {
+        return "'" + filename + "' is a protected folder";
+    }
+    return verdict(root, false);
+}
+
+// Folder names are not checked here: "bin" is a protected name for a root
+// but an ordinary build output as a target
+std::string Safety::check_target(const fs::path& path) const {
+    return verdict(path, true);
+}
+
+std::vector<Safety::Rejection> Safety::validate(std::vector<TargetEntry>& targets) const {
+    std::vector<std::string> reasons(targets.size());
+    {
+        TaskPool pool;
+        for (std::size_t begin = 0; begin < targets.size(); begin += VALIDATE_CHUNK) {
+            std::size_t end = std::min(targets.size(), begin + VALIDATE_CHUNK);
+            auto task = [this, &targets, &reasons, begin, end]() -> std::size_t {
+                for (std::size_t i = begin; i < end; ++i) {
+                    reasons[i] = check_target(targets[i].path);
+                }
+                // About an lstat per target; cached ancestors cost nothing
+                return end - begin;
+            };
+            const auto& first = targets[begin];
+            if (first.id.known()) {
+                pool.submit(first.id.dev, first.path, std::move(task));
+            } else {
+                pool.submit(first.path, std::move(task));
+            }
+        }
+        pool.wait();
+    }
+
+    std::vector<Rejection> rejected;
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < targets.size(); ++i) {
+        if (!reasons[i].empty()) {
+            rejected.push_back({std::move(targets[i]), std::move(reasons[i])});
+        } else {
+            if (kept != i) targets[kept] = std::move(targets[i]);
+            kept++;
+        }
+    }
+    targets.resize(kept);
+    return rejected;
+}
+
+// ============================================================================
+// Names and Thresholds
+// ============================================================================
+
 const std::vector<std::string>& Safety::protected_folders() {
     static const std::vector<std::string> folders = {
         ".git",
@@ -30,93 +324,16 @@ const std::vector<std::string>& Safety::protected_folders() {
     return folders;
 }
 
-bool Safety::is_root_path(const fs::path& path) {
-    auto canonical = fs::weakly_canonical(path);
-    std::string path_str = canonical.string();
-    
-    // Check if it's a drive root like C:\ or D:
-    if (path_str.length() >= 2 && path_str.length() <= 3) {
-        unsigned char first_char = static_cast<unsigned char>(path_str[0]);
-        if (std::isalpha(first_char) && path_str[1] == ':') {
-            if (path_str.length() == 2) {
-                return true;
-            }
-            if (path_str[2] == '\\' || path_str[2] == '/') {
-                return true;
-            }
-        }
-    }
-    return false;
-}
-
-bool Safety::is_home_path(const fs::path& path) {
-    auto canonical = fs::weakly_canonical(path);
-    
-    char home[MAX_PATH];
-    if (SUCCEEDED(SHGetFolderPathA(nullptr, CSIDL_PROFILE, nullptr, 0, home))) {
-        fs::path home_path(home);
-        return canonical == fs::weakly_canonical(home_path);
-    }
-    return false;
-}
-
 bool Safety::is_protected_folder(const std::string& name) {
     const auto& folders = protected_folders();
     return std::find(folders.begin(), folders.end(), name) != folders.end();
 }
 
-bool Safety::is_safe_path(const fs::path& path) {
-    if (is_root_path(path) || is_home_path(path)) {
-        return false;
-    }
-    
-    std::string filename = path.filename().string();
-    if (is_protected_folder(filename)) {
-        return false;
-    }
-    
-    auto canonical = fs::weakly_canonical(path);
-    std::string path_str = canonical.string();
-    
-    // Windows system folders
-    const std::vector<std::string> system_paths = {
-        "C:\\Windows",
-        "C:\\Program Files",
-        "C:\\Program Files (x86)",
-        "C:\\ProgramData"
-    };
-    
-    for (const auto& sys_path : system_paths) {
-        if (path_str.find(sys_path) == 0) {
-            return false;
-        }
-    }
-    
-    return true;
-}
-
-bool Safety::requires_captcha(std::uintmax_t total_bytes, std::size_t project_count) {
+bool Safety::requires_captcha(std::uintmax_t reclaimable_bytes, std::size_t project_count) {
     constexpr std::uintmax_t CAPTCHA_SIZE_THRESHOLD = 10ULL * 1024 * 1024 * 1024;
     constexpr std::size_t CAPTCHA_COUNT_THRESHOLD = 5;
-    
-    return total_bytes > CAPTCHA_SIZE_THRESHOLD || project_count > CAPTCHA_COUNT_THRESHOLD;
-}
 
-std::string Safety::get_unsafe_reason(const fs::path& path) {
-    if (is_root_path(path)) {
-        return "Cannot delete root directory";
-    }
-    
-    if (is_home_path(path)) {
-        return "Cannot delete home directory";
-    }
-    
-    std::string filename = path.filename().string();
-    if (is_protected_folder(filename)) {
-        return "'" + filename + "' is a protected folder";
-    }
-    
-    return "";
+    return reclaimable_bytes > CAPTCHA_SIZE_THRESHOLD || project_count > CAPTCHA_COUNT_THRESHOLD;
 }
 
 } // namespace nuke